@@ -0,0 +1,73 @@
+// check the vectorised character run scanners in char-runs.h against a char_isa() loop
+// usage: char-runs-check [inputs], each character group is checked on inputs random byte strings, the default is 1000
+// the strings are mostly bytes from the group so that runs are longer than a vector, every start offset is checked
+#include "char-runs.h"
+#include "iobuffer.h"
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace std ;
+using namespace CS_IO_Buffers ;
+using namespace Assignment_Tokeniser ;
+
+// the first byte in [p,end) that is not in group cg, one byte at a time
+static const char *skip_run_scalar(int cg,const char *p,const char *end)
+{
+    while ( p < end && char_isa((unsigned char)*p,cg) ) p++ ;
+    return p ;
+}
+
+// check skip_run<cg>() on random strings, returns the number of start offsets where it differs
+template <int cg> static int check_group(string name,int inputs)
+{
+    // the bytes that are in the group
+    vector<char> members ;
+    for ( int b = 0 ; b < 256 ; b++ )
+    {
+        if ( char_isa(b,cg) ) members.push_back((char)b) ;
+    }
+
+    // a fixed seed and the generator's raw output so every platform checks the same strings
+    mt19937 random(cg) ;
+    int differences = 0 ;
+    for ( int i = 0 ; i < inputs ; i++ )
+    {
+        string s(random() % 200,' ') ;
+        for ( auto &ch : s )
+        {
+            ch = random() % 16 != 0 ? members[random() % members.size()] : (char)(random() % 256) ;
+        }
+
+        const char *end = s.data() + s.size() ;
+        for ( const char *p = s.data() ; p <= end ; p++ )
+        {
+            if ( skip_run<cg>(p,end) != skip_run_scalar(cg,p,end) ) differences++ ;
+        }
+    }
+
+    write_to_output(name + ": " + to_string(inputs) + " inputs checked, " + to_string(differences) + " differences\n") ;
+    return differences ;
+}
+
+// check each group that skip_run() supports
+int main(int argc,char **argv)
+{
+    // configure io buffers to output immediately
+    config_output(iob_immediate) ;
+    config_errors(iob_immediate) ;
+
+    int inputs = argc > 1 ? atoi(argv[1]) : 1000 ;
+    if ( inputs <= 0 ) inputs = 1000 ;
+
+    int differences = check_group<cg_wspace>("wspace",inputs) +
+                      check_group<cg_id_letter>("id_letter",inputs) +
+                      check_group<cg_eol_char>("eol_char",inputs) +
+                      check_group<cg_not_star>("not_star",inputs) ;
+
+    // flush output - the test scripts disable unbuffered output
+    print_output() ;
+    print_errors() ;
+
+    return differences == 0 ? 0 : 1 ;
+}
@@ -0,0 +1,107 @@
+#ifndef ASSIGNMENT_CHAR_RUNS_H
+#define ASSIGNMENT_CHAR_RUNS_H
+
+#include "tokeniser-extras.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Vectorised scanning of long runs of characters from one character group
+//
+// - skip_run<cg>(p,end) returns a pointer to the first byte in [p,end) that is not in group cg
+// - 32 bytes are tested at a time with AVX2, 16 with SSE2, the remaining bytes use char_isa()
+// - only the groups that form long runs are supported:
+//   cg_wspace       runs of spaces, tabs and line endings
+//   cg_id_letter    the rest of an identifier
+//   cg_eol_char     the body of an eol_comment, up to the '\n'
+//   cg_not_star     the body of an adhoc_comment, up to the next '*'
+// - bytes 0x80 to 0xFF, ie UTF-8 encodings, are never in these groups so a run stops at the first one
+//
+namespace Assignment_Tokeniser
+{
+#if defined(__AVX2__)
+    typedef __m256i run_vector ;
+    constexpr int run_width = 32 ;
+
+    inline run_vector run_load(const char *p) { return _mm256_loadu_si256((const __m256i *)p) ; }
+    inline run_vector run_or(run_vector a,run_vector b) { return _mm256_or_si256(a,b) ; }
+    inline run_vector run_eq(run_vector v,char c) { return _mm256_cmpeq_epi8(v,_mm256_set1_epi8(c)) ; }
+    inline unsigned run_mask(run_vector v) { return (unsigned)_mm256_movemask_epi8(v) ; }
+
+    // bytes from lo to hi, unsigned compare by subtracting lo then checking <= hi - lo
+    inline run_vector run_in(run_vector v,char lo,char hi)
+    {
+        run_vector d = _mm256_sub_epi8(v,_mm256_set1_epi8(lo)) ;
+        return _mm256_cmpeq_epi8(_mm256_min_epu8(d,_mm256_set1_epi8((char)(hi - lo))),d) ;
+    }
+#elif defined(__SSE2__)
+    typedef __m128i run_vector ;
+    constexpr int run_width = 16 ;
+
+    inline run_vector run_load(const char *p) { return _mm_loadu_si128((const __m128i *)p) ; }
+    inline run_vector run_or(run_vector a,run_vector b) { return _mm_or_si128(a,b) ; }
+    inline run_vector run_eq(run_vector v,char c) { return _mm_cmpeq_epi8(v,_mm_set1_epi8(c)) ; }
+    inline unsigned run_mask(run_vector v) { return (unsigned)_mm_movemask_epi8(v) ; }
+
+    // bytes from lo to hi, unsigned compare by subtracting lo then checking <= hi - lo
+    inline run_vector run_in(run_vector v,char lo,char hi)
+    {
+        run_vector d = _mm_sub_epi8(v,_mm_set1_epi8(lo)) ;
+        return _mm_cmpeq_epi8(_mm_min_epu8(d,_mm_set1_epi8((char)(hi - lo))),d) ;
+    }
+#else
+    constexpr int run_width = 0 ;
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    // the bytes of v that are in group cg, one bit per byte
+    template <int cg> unsigned run_matches(run_vector v) ;
+
+    // wspace ::= '\t' | '\n' | '\r' | ' '
+    template <> inline unsigned run_matches<cg_wspace>(run_vector v)
+    {
+        return run_mask(run_or(run_or(run_eq(v,'\t'),run_eq(v,'\n')),run_or(run_eq(v,'\r'),run_eq(v,' ')))) ;
+    }
+
+    // id_letter ::= 'a'-'z'|'A'-'Z'|'0'-'9'|'_'|'$'|'.'
+    template <> inline unsigned run_matches<cg_id_letter>(run_vector v)
+    {
+        run_vector alnum = run_or(run_or(run_in(v,'a','z'),run_in(v,'A','Z')),run_in(v,'0','9')) ;
+        return run_mask(run_or(alnum,run_or(run_or(run_eq(v,'_'),run_eq(v,'$')),run_eq(v,'.')))) ;
+    }
+
+    // eol_char ::= '\t'|'\r'|' '-'~'
+    template <> inline unsigned run_matches<cg_eol_char>(run_vector v)
+    {
+        return run_mask(run_or(run_or(run_eq(v,'\t'),run_eq(v,'\r')),run_in(v,' ','~'))) ;
+    }
+
+    // not_star ::= '\t'|'\n'|'\r'|' '-')'|'+'-'~'
+    template <> inline unsigned run_matches<cg_not_star>(run_vector v)
+    {
+        run_vector controls = run_or(run_or(run_eq(v,'\t'),run_eq(v,'\n')),run_eq(v,'\r')) ;
+        return run_mask(run_or(controls,run_or(run_in(v,' ',')'),run_in(v,'+','~')))) ;
+    }
+#endif
+
+    // return a pointer to the first byte in [p,end) that is not in group cg
+    template <int cg> const char *skip_run(const char *p,const char *end)
+    {
+#if defined(__AVX2__) || defined(__SSE2__)
+        constexpr unsigned all = run_width == 32 ? 0xFFFFFFFFu : 0xFFFFu ;
+        while ( end - p >= run_width )
+        {
+            unsigned matches = run_matches<cg>(run_load(p)) ;
+            if ( matches != all ) return p + __builtin_ctz(~matches) ;
+            p += run_width ;
+        }
+#endif
+        while ( p < end && char_isa((unsigned char)*p,cg) ) p++ ;
+        return p ;
+    }
+}
+
+#endif //ASSIGNMENT_CHAR_RUNS_H
@@ -0,0 +1,83 @@
+#ifndef ASSIGNMENT_KEYWORDS_H
+#define ASSIGNMENT_KEYWORDS_H
+
+#include "tokeniser.h"
+#include <cstring>
+
+// Perfect hash tables for recognising keywords
+//
+// - a keyword_hash is built at compile time from a list of keywords and their token kinds
+// - a word is hashed using its first character, last character and length, multiplied by a constant
+//   that the constructor searches for so that no two keywords share a slot
+// - find() checks a word given as a pointer and a length, no string is created,
+//   it costs one hash, one length compare and at most one memcmp()
+// - Bits must be large enough that the table has at least twice as many slots as keywords
+//
+namespace Assignment_Tokeniser
+{
+    template <class Kind,int Count,int Bits> class keyword_hash
+    {
+        static constexpr int slots = 1 << Bits ;
+        static_assert(slots >= 2 * Count,"a keyword_hash needs at least twice as many slots as keywords") ;
+
+    public:
+        struct keyword
+        {
+            const char *spelling ;
+            Kind kind ;
+        } ;
+
+        constexpr keyword_hash(const keyword (&words)[Count]) : keywords(), lengths(), table(), multiplier(0)
+        {
+            for ( int i = 0 ; i < Count ; i++ )
+            {
+                keywords[i] = words[i] ;
+                while ( words[i].spelling[lengths[i]] != '\0' ) lengths[i]++ ;
+            }
+
+            // try odd multipliers until every keyword has its own slot
+            for ( unsigned m = 0x9E3779B1u ; multiplier == 0 ; m += 2 )
+            {
+                for ( int s = 0 ; s < slots ; s++ ) table[s] = -1 ;
+
+                bool perfect = true ;
+                for ( int i = 0 ; i < Count && perfect ; i++ )
+                {
+                    unsigned slot = hash(words[i].spelling,lengths[i],m) ;
+                    if ( table[slot] != -1 ) perfect = false ;
+                    table[slot] = i ;
+                }
+                if ( perfect ) multiplier = m ;
+            }
+        }
+
+        // the kind of the word s of length n if it is a keyword, otherwise not_a_keyword
+        Kind find(const char *s,int n,Kind not_a_keyword) const
+        {
+            if ( n < 1 ) return not_a_keyword ;
+
+            int i = table[hash(s,n,multiplier)] ;
+            if ( i < 0 || lengths[i] != n || memcmp(keywords[i].spelling,s,n) != 0 ) return not_a_keyword ;
+            return keywords[i].kind ;
+        }
+
+    private:
+        keyword keywords[Count] ;           // the keywords
+        int lengths[Count] ;                // the length of each keyword
+        int table[slots] ;                  // index of the keyword in each slot or -1
+        unsigned multiplier ;               // the multiplier that gives every keyword its own slot
+
+        static constexpr unsigned hash(const char *s,int n,unsigned m)
+        {
+            unsigned key = (unsigned char)s[0] | (unsigned char)s[n - 1] << 8 | (unsigned)n << 16 ;
+            return (key * m) >> (32 - Bits) ;
+        }
+    } ;
+
+    // the keywords of the assignment language
+    // * keyword ::= 'do'|'for'|'pointer'|'real'|'this'
+    typedef keyword_hash<TokenKind,5,4> assignment_keywords ;
+    inline constexpr assignment_keywords keywords({{"do",tk_do},{"for",tk_for},{"pointer",tk_pointer},{"real",tk_real},{"this",tk_this}}) ;
+}
+
+#endif //ASSIGNMENT_KEYWORDS_H
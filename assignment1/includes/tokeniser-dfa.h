@@ -0,0 +1,221 @@
+#ifndef ASSIGNMENT_TOKENISER_DFA_H
+#define ASSIGNMENT_TOKENISER_DFA_H
+
+#include "tokeniser.h"
+#include "keywords.h"
+#include <cstring>
+#include <string>
+
+// generated by tokeniser-generator --shortest adhoc_comment includes/tokeniser.h, do not edit
+//
+// - a minimised DFA with 44 states and 36 character classes
+// - dfa_scan(p,n,kind) returns the length in bytes of the longest token at the start of the UTF-8 text p
+//   and sets kind, it returns 0 and sets kind to tk_oops if no token can be formed
+// - dfa_classify_spelling(kind,s,n) returns the kind of a literal that the DFA accepts as another kind
+// - dfa_correct_spelling(kind,spelling) removes the delimiters that are not part of a token's spelling
+//
+namespace Assignment_Tokeniser
+{
+    constexpr int dfa_states = 44 ;
+    constexpr int dfa_classes = 36 ;
+
+    // the class of each ASCII character
+    inline constexpr unsigned char dfa_ascii_class[128] =
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 0, 0, 3, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        4, 5, 6, 7, 8, 7, 7, 7, 9, 10, 11, 7, 12, 7, 13, 14,
+        15, 16, 17, 17, 17, 17, 17, 17, 18, 18, 19, 20, 21, 22, 23, 24,
+        25, 26, 26, 26, 26, 26, 26, 27, 27, 27, 27, 27, 27, 27, 27, 27,
+        27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 28, 7, 29, 30, 8,
+        7, 27, 31, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27,
+        27, 27, 27, 27, 27, 27, 27, 27, 32, 27, 27, 33, 7, 34, 7, 0
+    } ;
+
+    // the classes of the other code points, any code point not in a range has class 0
+    struct dfa_range { int first ; int last ; int dfa_class ; } ;
+    inline constexpr dfa_range dfa_ranges[] =
+    {
+        { 0x370, 0x3ff, 35 },
+        { 0x1f00, 0x1fff, 35 },
+    } ;
+
+    // the next state for each state and class, -1 if no token can be formed
+    inline constexpr short dfa_next[dfa_states][dfa_classes] =
+    {
+        { -1, 1, 2, 3, 4, 5, 6, -1, -1, 7, 8, -1, 9, 10, 11, 12, 13, 13, 13, 14, 15, 16, 17, -1, -1, 18, 19, 19, 20, 21, 19, 19, 19, 22, 23, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 24, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, 6, 6, 25, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 26, -1, -1, 27, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 28, -1, 29, 29, 29, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 30, 31, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 28, -1, 13, 13, 13, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 32, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 33, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, 19, -1, -1, -1, -1, 19, -1, 19, 19, 19, 19, -1, -1, -1, -1, -1, 34, -1, 19, 19, -1, -1, -1, 19, 19, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 35, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, -1 },
+        { -1, 27, 36, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, 27, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 28, 28, 28, 28, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 37, -1, 29, 29, 29, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 38, 38, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 39, 39, 39, 39, -1, -1, -1, -1, -1, -1, -1, 39, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 40, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 35, 26, 26, 41, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, 26, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 37, 37, 37, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 42, -1, 38, 38, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 43, -1, 39, 39, 39, 39, -1, -1, -1, -1, -1, -1, -1, 39, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 42, 42, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+        { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 43, 43, 43, 43, -1, -1, -1, -1, -1, -1, -1, 43, -1, -1, -1, -1, -1, -1, -1, -1, -1 },
+    } ;
+
+    // the kind of token accepted in each state, tk_oops if none
+    inline constexpr TokenKind dfa_accepts[dfa_states] =
+    {
+        tk_oops,
+        tk_tab,
+        tk_newline,
+        tk_carriage_return,
+        tk_space,
+        tk_oops,
+        tk_oops,
+        tk_lrb,
+        tk_rrb,
+        tk_comma,
+        tk_dot,
+        tk_div,
+        tk_number,
+        tk_number,
+        tk_colon,
+        tk_semi,
+        tk_oops,
+        tk_oops,
+        tk_at,
+        tk_identifier,
+        tk_lsb,
+        tk_rsb,
+        tk_lcb,
+        tk_rcb,
+        tk_ne,
+        tk_string,
+        tk_oops,
+        tk_oops,
+        tk_number,
+        tk_number,
+        tk_oops,
+        tk_oops,
+        tk_oops,
+        tk_eq,
+        tk_identifier,
+        tk_oops,
+        tk_eol_comment,
+        tk_number,
+        tk_number,
+        tk_number,
+        tk_spaceship,
+        tk_adhoc_comment,
+        tk_number,
+        tk_number,
+    } ;
+
+    // the character class of code point ch
+    inline int dfa_char_class(int ch)
+    {
+        if ( ch >= 0 && ch < 128 ) return dfa_ascii_class[ch] ;
+
+        int lo = 0, hi = sizeof(dfa_ranges) / sizeof(dfa_ranges[0]) ;
+        while ( lo < hi )
+        {
+            int mid = (lo + hi) / 2 ;
+            if ( ch < dfa_ranges[mid].first ) hi = mid ;
+            else
+            if ( ch > dfa_ranges[mid].last ) lo = mid + 1 ;
+            else return dfa_ranges[mid].dfa_class ;
+        }
+        return 0 ;
+    }
+
+    // decode the UTF-8 code point at the start of the n bytes at p and set size to its length in bytes,
+    // a byte that does not start a valid encoding is returned as -1
+    inline int dfa_decode(const char *p,int n,int &size)
+    {
+        unsigned char c = p[0] ;
+        size = c < 0x80 ? 1 : c >= 0xC2 && c < 0xE0 ? 2 : c >= 0xE0 && c < 0xF0 ? 3 : c >= 0xF0 && c < 0xF5 ? 4 : 0 ;
+        if ( size == 1 ) return c ;
+        if ( size == 0 || size > n ) { size = 1 ; return -1 ; }
+
+        int ch = c & (0x7F >> size) ;
+        for ( int i = 1 ; i < size ; i++ )
+        {
+            if ( (p[i] & 0xC0) != 0x80 ) { size = 1 ; return -1 ; }
+            ch = ch << 6 | (p[i] & 0x3F) ;
+        }
+        return ch ;
+    }
+
+    // the length in bytes of the longest token at the start of the n bytes at p, its kind is returned in kind
+    inline int dfa_scan(const char *p,int n,TokenKind &kind)
+    {
+        int state = 0, length = 0 ;
+        kind = tk_oops ;
+        for ( int i = 0, size ; i < n ; i += size )
+        {
+            state = dfa_next[state][dfa_char_class(dfa_decode(p + i,n - i,size))] ;
+            if ( state < 0 ) break ;
+            if ( dfa_accepts[state] != tk_oops )
+            {
+                kind = dfa_accepts[state] ;
+                length = i + size ;
+            }
+        }
+        return length ;
+    }
+
+    // the kind of the token with spelling s of length n that the DFA accepted as kind
+    inline TokenKind dfa_classify_spelling(TokenKind kind,const char *s,int n)
+    {
+        switch(kind)
+        {
+        case tk_identifier:
+            // keywords.h lists 'do', 'for', 'pointer', 'real', 'this'
+            return keywords.find(s,n,kind) ;
+        default:
+            break ;
+        }
+        return kind ;
+    }
+
+    // the spelling of a token without the delimiters that are not part of it
+    inline std::string dfa_correct_spelling(TokenKind kind,const std::string &spelling)
+    {
+        switch(kind)
+        {
+        case tk_adhoc_comment: return spelling.substr(2,spelling.size() - 4) ;
+        case tk_eol_comment: return spelling.substr(2,spelling.size() - 3) ;
+        case tk_string: return spelling.substr(1,spelling.size() - 2) ;
+        default: return spelling ;
+        }
+    }
+}
+
+#endif //ASSIGNMENT_TOKENISER_DFA_H
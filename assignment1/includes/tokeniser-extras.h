@@ -91,12 +91,68 @@ namespace Assignment_Tokeniser
     // eg char_isa('-',cg_identifier) returns false
     extern bool char_isa(int ch,int cg) ;
 
-    // work out the kind of a parsed token, this calls keyword_or_identifier() if a token looks like an identifier
+    // work out the kind of a parsed token, a token that looks like an identifier is looked up in the keyword table
     extern TokenKind classify_spelling(string spelling) ;
 
     // work out the correct spelling to use in the Token object being created by new_token()
     extern string correct_spelling(TokenKind kind,string spelling) ;
 
+    // the part of the n characters at s that correct_spelling() keeps, from offset first up to offset last
+    extern void spelling_bounds(TokenKind kind,const char *s,int n,int &first,int &last) ;
+
+    // the exact value of a tk_number token is mantissa / radix^scale, eg 0x1.8 is 0x18 / 16^1
+    // trailing 0s in a fraction are not included, just as correct_spelling() removes them
+    // overflow is true if the digits do not fit in mantissa, mantissa is then not the value's digits
+    struct number_value
+    {
+        unsigned long long mantissa ;   // all of the digits
+        int radix ;                     // 2, 8, 10 or 16
+        int scale ;                     // the number of fraction digits
+        bool overflow ;                 // true if the digits did not fit
+
+        // the nearest double, it is exact if the value has no more than 53 significant bits and radix is not 10
+        double to_double() const ;
+    } ;
+
+    // builds a number_value one character at a time as a number is scanned
+    // zeros in a fraction are only added once a later non-zero digit is found
+    class number_builder
+    {
+    public:
+        explicit number_builder(int radix) : value{0,radix,0,false}, in_fraction(false), zeros(0) {}
+
+        // add the next digit, '0'-'9' or 'A'-'F'
+        void digit(int ch)
+        {
+            int d = ch <= '9' ? ch - '0' : ch - 'A' + 10 ;
+            if ( !in_fraction ) add(d) ;
+            else
+            if ( d == 0 ) zeros++ ;
+            else
+            {
+                for ( ; zeros > 0 ; zeros-- ) { add(0) ; value.scale++ ; }
+                add(d) ;
+                value.scale++ ;
+            }
+        }
+
+        // the '.' that starts a fraction
+        void point() { in_fraction = true ; }
+
+        number_value result() const { return value ; }
+
+    private:
+        number_value value ;
+        bool in_fraction ;
+        int zeros ;                     // fraction zeros not yet added
+
+        void add(int d)
+        {
+            if ( value.mantissa > (~0ULL - d) / value.radix ) value.overflow = true ;
+            value.mantissa = value.mantissa * value.radix + d ;
+        }
+    } ;
+
 }
 
 #endif //ASSIGNMENT_TOKENISER_EXTRAS_H
@@ -0,0 +1,98 @@
+#ifndef ASSIGNMENT_TOKENISER_GROUPS_H
+#define ASSIGNMENT_TOKENISER_GROUPS_H
+
+#include "tokeniser-extras.h"
+
+// generated by tokeniser-generator --groups includes/tokeniser-extras.h includes/tokeniser.h, do not edit
+//
+// - the code points that can start each rule that has a character group, eg cg_number for rule number
+// - each group's ranges are in increasing order and do not overlap or touch
+//
+namespace Assignment_Tokeniser
+{
+    struct char_group_range { int cg ; int first ; int last ; } ;
+    inline constexpr char_group_range char_group_ranges[] =
+    {
+        // token ::= wspace | identifier | number | string | keyword | symbol | eol_comment | adhoc_comment
+        { cg_token, '\t', '\n' },
+        { cg_token, '\r', '\r' },
+        { cg_token, ' ', '"' },
+        { cg_token, '(', ')' },
+        { cg_token, ',', ',' },
+        { cg_token, '.', '=' },
+        { cg_token, '@', '[' },
+        { cg_token, ']', '^' },
+        { cg_token, 'a', '{' },
+        { cg_token, '}', '}' },
+        // wspace ::= '\t' | '\n' | '\r' | ' '
+        { cg_wspace, '\t', '\n' },
+        { cg_wspace, '\r', '\r' },
+        { cg_wspace, ' ', ' ' },
+        // identifier ::= ('a'-'z'|'A'-'Z'|'^') id_letter* '?'?
+        { cg_identifier, 'A', 'Z' },
+        { cg_identifier, '^', '^' },
+        { cg_identifier, 'a', 'z' },
+        // id_letter ::= 'a'-'z'|'A'-'Z'|'0'-'9'|'_'|'$'|'.'
+        { cg_id_letter, '$', '$' },
+        { cg_id_letter, '.', '.' },
+        { cg_id_letter, '0', '9' },
+        { cg_id_letter, 'A', 'Z' },
+        { cg_id_letter, '_', '_' },
+        { cg_id_letter, 'a', 'z' },
+        // number ::= binary | octal | decimal | hexadecimal
+        { cg_number, '0', '9' },
+        // bin_digit ::= '0' | '1'
+        { cg_bin_digit, '0', '1' },
+        // oct_digit ::= '0'-'7'
+        { cg_oct_digit, '0', '7' },
+        // decimal ::= ('0' | decimal19) dec_fraction?
+        { cg_decimal, '0', '9' },
+        // decimal19 ::= ('1'-'9') dec_digit*
+        { cg_decimal19, '1', '9' },
+        // dec_digit ::= '0'-'9'
+        { cg_dec_digit, '0', '9' },
+        // hex_digit ::= '0'-'9'|'A'-'F'
+        { cg_hex_digit, '0', '9' },
+        { cg_hex_digit, 'A', 'F' },
+        // instring ::= ' '|'!'|'#'-'~'|greek
+        { cg_instring, ' ', '!' },
+        { cg_instring, '#', '~' },
+        { cg_instring, 0x370, 0x3ff },
+        { cg_instring, 0x1f00, 0x1fff },
+        // greek ::= all unicode code-points from 0x370 to 0x3FF and 0x1F00 to 0x1FFF
+        { cg_greek, 0x370, 0x3ff },
+        { cg_greek, 0x1f00, 0x1fff },
+        // eol_char ::= '\t'|'\r'|' '-'~'
+        { cg_eol_char, '\t', '\t' },
+        { cg_eol_char, '\r', '\r' },
+        { cg_eol_char, ' ', '~' },
+        // adhoc_char ::= '\t'|'\n'|'\r'|' '-'~'
+        { cg_adhoc_char, '\t', '\n' },
+        { cg_adhoc_char, '\r', '\r' },
+        { cg_adhoc_char, ' ', '~' },
+        // not_star ::= '\t'|'\n'|'\r'|' '-')'|'+'-'~'
+        { cg_not_star, '\t', '\n' },
+        { cg_not_star, '\r', '\r' },
+        { cg_not_star, ' ', ')' },
+        { cg_not_star, '+', '~' },
+        // not_div ::= '\t'|'\n'|'\r'|' '-')'|'+'-'.'|'0'-'~'
+        { cg_not_div, '\t', '\n' },
+        { cg_not_div, '\r', '\r' },
+        { cg_not_div, ' ', ')' },
+        { cg_not_div, '+', '.' },
+        { cg_not_div, '0', '~' },
+        // symbol ::= '@'|';'|':'|'!='|','|'.'|'=='|'<=>'|'{'|'}'|'('|')'|'['|']'|'/'
+        { cg_symbol, '!', '!' },
+        { cg_symbol, '(', ')' },
+        { cg_symbol, ',', ',' },
+        { cg_symbol, '.', '/' },
+        { cg_symbol, ':', '=' },
+        { cg_symbol, '@', '@' },
+        { cg_symbol, '[', '[' },
+        { cg_symbol, ']', ']' },
+        { cg_symbol, '{', '{' },
+        { cg_symbol, '}', '}' },
+    } ;
+}
+
+#endif //ASSIGNMENT_TOKENISER_GROUPS_H
@@ -0,0 +1,206 @@
+#ifndef ASSIGNMENT_TOKENISER_SPANS_H
+#define ASSIGNMENT_TOKENISER_SPANS_H
+
+#include "tokeniser.h"
+#include "tokeniser-extras.h"
+#include <cstddef>
+#include <vector>
+
+// An alternative input mode for the assignment tokeniser that works on the whole input at once
+//
+// - the input is memory-mapped from a file, or read from standard input in one bulk read
+// - tokens are described by token_span records that refer to the input instead of holding a copy of their spelling
+// - a token's spelling is only created if span_tokeniser::spelling() is called, it is the same as token_spelling()
+//   would return for the Token read by read_next_token()
+// - tokenising allocates nothing per token
+// - the value of each tk_number token is decoded while it is scanned, see number_value in tokeniser-extras.h
+//
+// Example:
+//
+//     span_input input("Square.jack") ;
+//     span_tokeniser tokeniser(input) ;
+//     for ( token_span t = tokeniser.next() ; t.kind != tk_eoi ; t = tokeniser.next() )
+//         if ( t.kind == tk_identifier ) write_to_output(tokeniser.spelling(t) + "\n") ;
+//
+// - tokenise_all() tokenises the whole input in one pass into a token_array, a parser can then look ahead
+//   any distance with peek(k) and backtrack with mark() and reset(), tokenising can also be run as a
+//   separate stage before parsing
+//
+// Example:
+//
+//     token_array tokens = tokenise_all(input) ;
+//     int start = tokens.mark() ;
+//     if ( tokens.peek(0).kind == tk_identifier && tokens.peek(1).kind == tk_colon ) ...
+//     tokens.reset(start) ;
+//
+namespace Assignment_Tokeniser
+{
+    // a token recorded as its position in the input
+    // a token that cannot be formed has kind tk_oops, its offset, line and column are those of the unexpected character
+    struct token_span
+    {
+        TokenKind kind ;                // the kind of token
+        int offset ;                    // offset in bytes of the token's first character
+        int length ;                    // length in bytes of all of the token's characters
+        int line ;                      // line of the token's first character, starts at 1
+        int column ;                    // column in bytes of the token's first character, starts at 1
+    } ;
+
+    // the value of the tk_number token at offset
+    struct token_number
+    {
+        int offset ;                    // offset of the token
+        number_value value ;            // its value
+    } ;
+
+    // the complete input held in memory
+    class span_input
+    {
+    public:
+        // read all of standard input
+        span_input() ;
+
+        // memory-map the named file, if it cannot be mapped it is read instead
+        // it is a fatal error if the file cannot be opened
+        explicit span_input(string path) ;
+
+        ~span_input() ;
+
+        span_input(const span_input &) = delete ;
+        span_input &operator=(const span_input &) = delete ;
+
+        const char *data() const { return bytes ; }
+        int size() const { return length ; }
+
+    private:
+        const char *bytes ;             // the input
+        int length ;                    // number of bytes of input
+        void *mapping ;                 // the mmap()ed file or nullptr
+        string buffer ;                 // the input if it was read rather than mapped
+    } ;
+
+    // reads token_spans from a span_input
+    class span_tokeniser
+    {
+    public:
+        explicit span_tokeniser(const span_input &input) ;
+
+        // tokenise the part of input from begin to end, begin must be the start of a line and end must follow a '\n'
+        // or be the end of input, line numbers start at 1 for the line at begin
+        // if in_comment is true the part starts inside the body of an adhoc_comment and the first token returned
+        // is the rest of the comment, its offset is begin
+        span_tokeniser(const span_input &input,int begin,int end,bool in_comment) ;
+
+        // true if the last token returned is an adhoc_comment that continues past the end of the part
+        bool in_open_comment() const { return open_comment ; }
+
+        // the next token, once the end of input is reached every call returns a tk_eoi token
+        // once a tk_oops token is returned every call returns the same tk_oops token
+        token_span next() ;
+
+        // the characters that make up the token t as they appear in the input
+        string characters(const token_span &t) const ;
+
+        // the spelling of token t after correct_spelling() has been applied
+        string spelling(const token_span &t) const ;
+
+        // the value of the last token returned by next(), it must be a tk_number token
+        number_value number() const { return value ; }
+
+        // the character or character group that tokens would report as not found for the last tk_oops token,
+        // it is the argument tokeniser.cpp passes to did_not_find_char(), eg '=' or cg_token
+        int expected() const { return missing ; }
+
+    private:
+        const char *input ;             // the input
+        int length ;                    // offset of the end of the part of the input being tokenised
+        int input_size ;                // number of bytes of input
+        int pos ;                       // offset of the next character
+        int line ;                      // line of the next character
+        int line_start ;                // offset of the first character on the current line
+        bool failed ;                   // true once a tk_oops token is returned
+        bool resume_comment ;           // true if the first token continues an adhoc_comment
+        bool open_comment ;             // true if the last token is an adhoc_comment that continues past length
+        number_value value ;            // the value of the last tk_number token
+        int missing ;                   // what was expected when tk_oops was returned, see expected()
+
+        // the kind of token starting at pos, pos is moved past the token
+        // returns tk_oops with pos at the unexpected character if no legal token can be formed
+        TokenKind scan() ;
+
+        // the rest of an adhoc_comment after the '/*'
+        TokenKind scan_adhoc_body() ;
+
+        // record what was expected at pos and return tk_oops
+        TokenKind oops(int cg) { missing = cg ; return tk_oops ; }
+
+        // the character at offset i or EOF
+        int at(int i) const { return i < length ? (unsigned char)input[i] : EOF ; }
+
+        // if the next character is in cg move past it and return true
+        bool skip_isa(int cg) ;
+
+        // move past a UTF-8 encoded greek letter, returns false if the next character is not one
+        bool skip_greek() ;
+    } ;
+
+    // every token in an input stored contiguously with a cursor
+    // the last token is always tk_eoi or tk_oops
+    class token_array
+    {
+    public:
+        explicit token_array(const span_input &input) ;
+
+        // an array of tokens already read from input and the values of its tk_number tokens in input order
+        token_array(const span_input &input,std::vector<token_span> tokens,std::vector<token_number> numbers) ;
+
+        // the number of tokens including the final tk_eoi or tk_oops token
+        int size() const { return tokens.size() ; }
+        const token_span &operator[](int i) const { return tokens[i] ; }
+
+        // the token k places after the cursor, peek(0) is the current token
+        // looking past the end returns the final tk_eoi or tk_oops token
+        const token_span &peek(int k) const
+        {
+            int i = cursor + k ;
+            return tokens[i < size() ? i : size() - 1] ;
+        }
+        const token_span &current() const { return tokens[cursor] ; }
+
+        // move the cursor to the next token, the cursor never moves past the final token
+        void next() { if ( cursor < size() - 1 ) cursor++ ; }
+
+        // remember the cursor position and return to it later
+        int mark() const { return cursor ; }
+        void reset(int position) { cursor = position ; }
+
+        // the spelling of token t after correct_spelling() has been applied
+        string spelling(const token_span &t) const { return tokeniser.spelling(t) ; }
+
+        // the value of token t, it must be a tk_number token from this array
+        number_value number(const token_span &t) const ;
+
+        // the character or character group that was expected at the final tk_oops token, see span_tokeniser::expected()
+        int expected() const ;
+
+    private:
+        span_tokeniser tokeniser ;      // reads the tokens and creates spellings
+        std::vector<token_span> tokens ; // the tokens in input order
+        std::vector<token_number> numbers ; // the values of the tk_number tokens in input order
+        int cursor ;                    // index of the current token
+    } ;
+
+    // tokenise all of input in one pass
+    extern token_array tokenise_all(const span_input &input) ;
+
+    // tokenise all of input using up to threads threads, 0 means one per hardware thread
+    // - the input is split into one chunk per thread at line boundaries
+    // - a token can only continue onto the next line if it is an adhoc_comment so each chunk is tokenised
+    //   twice in parallel, once starting outside of a comment and once starting inside a comment
+    // - the chunks are then joined in order, using the result that matches how the previous chunk ended,
+    //   and their line numbers are adjusted by the number of lines before the chunk
+    // - the tokens are identical to those returned by tokenise_all()
+    extern token_array tokenise_all_parallel(const span_input &input,int threads = 0) ;
+}
+
+#endif //ASSIGNMENT_TOKENISER_SPANS_H
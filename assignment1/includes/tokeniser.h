@@ -123,7 +123,6 @@ namespace Assignment_Tokeniser
     //   . 'make Show' can be used to see the names of all files used by each test
     //
 
-0000032.4000000
     // The kinds of token that are recognised
     enum TokenKind
     {
@@ -8,7 +8,6 @@
 #include "iobuffer.h"
 #include <iostream>
 #include <vector>
-#include <math.h>
 
 // to shorten the code
 using namespace std;
@@ -44,73 +43,66 @@ namespace Assignment_Tokeniser
         return column;
     }
 
-    string stringArray[1000];
-    // temporary memory solution so we can build ASCII tokens
-    static string memory = "";
+    // every character remembered so far, encoded in UTF-8, the input is only stored once
+    static string remembered = "";
+
+    // the offset in remembered of the start of each line, line_starts[0] is the start of line 1
+    // a new entry is added each time a '\n' is remembered
+    static vector<int> line_starts(1, 0);
+
+    // the offset in remembered of the first character not yet returned by last_characters()
+    static int last_start = 0;
 
     // remember character ch
     // ch is a legal unicode code-point in the range 0 to 0x10FFFF
     void remember(int ch)
     {
-        //calculate number of bits
-        int bit = (int)log2(ch)+1;
-
-        //allocate memory
-        if (bit <= 7)
+        // 0 is not part of the input, it is neither remembered nor counted as a column
+        if (!ch)
         {
-            memory += (char)(ch & 0x7F);
+            return;
         }
 
-        else if (bit <= 11)
+        // ASCII characters are their own UTF-8 encoding
+        if (ch < 0x80)
         {
-            memory += (char)(0xC0 | ((ch >> 6) & 0x1F));
-            memory += (char)(0x80 | (ch & 0x3F));
-
-            stringArray[line] += (char)(0xC0 | ((ch >> 6) & 0x1F));
-            stringArray[line] += (char)(0x80 | (ch & 0x3F));
+            remembered += (char)ch;
         }
 
-        else if (bit <= 16)
+        // up to 11 bits
+        else if (ch < 0x800)
         {
-            memory += (char)(0xE0 | ((ch >> 12) & 0x0F));
-            memory += (char)(0x80 | ((ch >> 6) & 0x3F));
-            memory += (char)(0x80 | ((ch & 0x3F)));
+            remembered += (char)(0xC0 | ((ch >> 6) & 0x1F));
+            remembered += (char)(0x80 | (ch & 0x3F));
+        }
 
-            stringArray[line] += (char)(0xE0 | ((ch >> 12) & 0x0F));
-            stringArray[line] += (char)(0x80 | ((ch >> 6) & 0x3F));
-            stringArray[line] += (char)(0x80 | ((ch & 0x3F)));
+        // up to 16 bits
+        else if (ch < 0x10000)
+        {
+            remembered += (char)(0xE0 | ((ch >> 12) & 0x0F));
+            remembered += (char)(0x80 | ((ch >> 6) & 0x3F));
+            remembered += (char)(0x80 | (ch & 0x3F));
         }
 
-        else if (bit <= 21)
+        // up to 21 bits
+        else
         {
-            memory += (char)(0xF0 | ((ch >> 18) & 0x07));
-            memory += (char)(0x80 | ((ch >> 12) & 0x3F));
-            memory += (char)(0x80 | ((ch >> 6) & 0x3F));
-            memory += (char)(0x80 | (ch & 0x3F));
-
-            stringArray[line] += (char)(0xF0 | ((ch >> 18) & 0x07));
-            stringArray[line] += (char)(0x80 | ((ch >> 12) & 0x3F));
-            stringArray[line] += (char)(0x80 | ((ch >> 6) & 0x3F));
-            stringArray[line] += (char)(0x80 | (ch & 0x3F));
+            remembered += (char)(0xF0 | ((ch >> 18) & 0x07));
+            remembered += (char)(0x80 | ((ch >> 12) & 0x3F));
+            remembered += (char)(0x80 | ((ch >> 6) & 0x3F));
+            remembered += (char)(0x80 | (ch & 0x3F));
         }
 
-        //if it's a \n, it will be added to the string, increase line and reset column
+        //if it's a \n, start a new line and reset column
         if (ch == '\n')
         {
-            if (bit <= 7)
-            {
-                stringArray[line] += ch;
-            }
+            line_starts.push_back(remembered.size());
             line++;
             column = 1;
         }
-        //else add it to string and increase column, line remain
-        else if (ch)
+        //else increase column, line remain
+        else
         {
-            if (bit <= 7)
-            {
-                stringArray[line] += ch;
-            }
             column++;
         }
     }
@@ -125,18 +117,19 @@ namespace Assignment_Tokeniser
         {
             return "";
         }
-        else
-        {
-            return stringArray[ln];
-        }
+
+        // the line is only copied out of remembered when it is asked for
+        int start = line_starts[ln - 1];
+        int end = ln < get_line() ? line_starts[ln] : remembered.size();
+        return remembered.substr(start, end - start);
     }
 
     // returns all characters remembered since the last call
     // the string is encoded in UTF-8
     string last_characters()
     {
-        string last = memory;
-        memory = "";
+        string last = remembered.substr(last_start);
+        last_start = remembered.size();
         return last;
     }
 }
@@ -2,6 +2,12 @@
 
 #include "iobuffer.h"
 #include "tokeniser-extras.h"
+#include "keywords.h"
+#include "tokeniser-groups.h"
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 
 // to shorten the code
 using namespace std;
@@ -9,258 +15,60 @@ using namespace CS_IO_Buffers;
 
 namespace Assignment_Tokeniser
 {
+    // the character classes are precomputed at compile time from the BNF in tokeniser.h
+    // . the first characters of each rule with a character group are generated by tokeniser-generator --groups
+    //   into tokeniser-groups.h, so the groups cannot drift from the rules
+    // . each of the 256 byte values has one bit per character group, bit 0 is cg_token
+    // . the few ranges above 0xFF, the greek letters, are checked in char_group_ranges itself
+    // . char_isa() is called for every next_char_isa() and next_char_mustbe() so each call is now
+    //   a single table lookup instead of a switch over the group and then the character
+
+    // the bit used for character group cg
+    static constexpr uint32_t group_bit(int cg)
+    {
+        return 1u << (cg - cg_token);
+    }
+
+    // the generated ranges of each character group, restricted to the characters 0 to 0xFF
+    static constexpr array<uint32_t, 256> make_class_table()
+    {
+        array<uint32_t, 256> table{};
+        for (auto &range : char_group_ranges)
+            for (int ch = range.first; ch <= range.last && ch < 256; ch++)
+                table[ch] |= group_bit(range.cg);
+        return table;
+    }
+
+    static constexpr array<uint32_t, 256> class_table = make_class_table();
+
     // check if a char matches another char or is a member of a character group
     // eg char_isa('3',cg_digit) returns true
     bool char_isa(int ch, int cg)
     {
         // single character groups use their character as their value
-        // do not add them to the switch statement
         if (ch == cg)
             return true;
 
-        switch (cg)
-        {
-        // characters that start rule wspace
-        case cg_wspace: 
-            switch (ch)
-            {
-            case '\t':
-            case '\n':
-            case '\r':
-            case ' ':
-                return true;
-            default:
-                return false;
-            }
-        // complete a switch statement for each of the following
-        // characters that start rule token
-        case cg_token: 
-            switch (ch)
-            {
-            default:
-                return false;
-            }
-        // characters that start rule identifier
-        case cg_identifier: 
-            switch (ch)
-            {
-            case 'a' ... 'z':
-            case 'A' ... 'Z':
-            case '^':
-                return true;
-            default:
-                return false;
-            }
-
-        // characters that start rule id_letter
-        case cg_id_letter: 
-            switch (ch)
-            {
-            case 'a' ... 'z':
-            case 'A' ... 'Z':
-            case '0' ... '9':
-            case '_':
-            case '$':
-            case '.':
-                return true;
-            default:
-                return false;
-            }
-
-        // characters that start rule number
-        case cg_number: 
-            switch (ch)
-            {
-            case '0' ... '9':
-                return true;
-            default:
-                return false;
-            }
-
-        // characters that start rule bin_digit
-        case cg_bin_digit: 
-            switch (ch)
-            {
-            case '0':
-            case '1':
-                return true;
-            default:
-                return false;
-            }
-
-        // characters that start rule oct_digit
-        case cg_oct_digit: 
-            switch (ch)
-            {
-            case '0' ... '7':
-                return true;
-            default:
-                return false;
-            }
-
-        // characters that start rule decimal
-        case cg_decimal: 
-            switch (ch)
-            {
-            case '0' ... '9':
-                return true;
-            }
-
-        // characters that start rule decimal19
-        case cg_decimal19: 
-            switch (ch)
-            {
-            case '1' ... '9':
-                return true;
-            default:
-                return false;
-            }
-
-        // characters that start rule dec_digit
-        case cg_dec_digit: 
-            switch (ch)
-            {
-            case '0' ... '9':
-                return true;
-            default:
-                return false;
-            }
-
-        // characters that start rule hex_digit
-        case cg_hex_digit: 
-            switch (ch)
-            {
-            case '0' ... '9':
-            case 'A' ... 'F':
-                return true;
-            default:
-                return false;
-            }
-
-        // characters that start rule instring
-        case cg_instring: 
-            switch (ch)
-            {
-            case ' ':
-            case '!':
-            case '#' ... '~':
-            case L'\u0370' ... L'\u03FF':
-            case L'\u1F00' ... L'\u1FFF':
-                return true;
-            default:
-                return false;
-            }
-
-        // characters that start rule greek
-        case cg_greek: 
-            switch (ch)
-            {
-            case L'\u0370' ... L'\u03FF':
-            case L'\u1F00' ... L'\u1FFF':
-                return true;
-            default:
-                return false;
-            }
-
-        // characters that start rule eol_char
-        case cg_eol_char: 
-            switch (ch)
-            {
-            case '\t':
-            case '\r':
-            case ' ' ... '~':
-                return true;
-            default:
-                return false;
-            }
-
-        // characters that start rule adhoc_char
-        case cg_adhoc_char: 
-            switch (ch)
-            {
-            case '\t':
-            case '\n':
-            case '\r':
-            case ' ' ... '~':
-                return true;
-            default:
-                return false;
-            }
-
-        // characters that start rule not_star
-        case cg_not_star: 
-            switch (ch)
-            {
-            case '\t':
-            case '\n':
-            case '\r':
-            case ' ' ... ')':
-            case '+' ... '~':
-                return true;
-            default:
-                return false;
-            }
+        // not a character group or cg_oops
+        if (cg <= cg_min || cg >= cg_oops)
+            return false;
 
-        // characters that start rule not_div
-        case cg_not_div: 
-            switch (ch)
-            {
-            case '\t':
-            case '\n':
-            case '\r':
-            case ' ' ... ')':
-            case '+' ... '.':
-            case '0' ... '~':
-                return true;
-            default:
-                return false;
-            }
+        if (ch >= 0 && ch < 256)
+            return (class_table[ch] & group_bit(cg)) != 0;
 
-        // characters that start rule symbol
-        case cg_symbol: 
-            switch (ch)
-            {
-            case '@':
-            case ';':
-            case ':':
-            case '!':
-            case ',':
-            case '.':
-            case '=':
-            case '<':
-            case '{':
-            case '}':
-            case '(':
-            case ')':
-            case '[':
-            case ']':
-            case '/':
+        // a code point outside the table can only be in one of the generated ranges above 0xFF
+        for (auto &range : char_group_ranges)
+            if (range.cg == cg && ch >= range.first && ch <= range.last)
                 return true;
-            default:
-                return false;
-            }
-        case cg_oops:
-        default:
-            return false;
-        }
+        return false;
     }
 
-    // work out the kind of a parsed token, this may call keyword_or_identifier()
+    // work out the kind of a parsed token, words are looked up in the keyword table
     // the spelling is a valid token or "" if at end of input
     TokenKind classify_spelling(string spelling)
     {
         if (spelling == "")
             return tk_eoi;
-        if (spelling == "do")
-            return tk_do;
-        if (spelling == "for")
-            return tk_for;
-        if (spelling == "pointer")
-            return tk_pointer;
-        if (spelling == "real")
-            return tk_real;
-        if (spelling == "this")
-            return tk_this;
 
         switch (spelling[0])
         {
@@ -275,7 +83,8 @@ namespace Assignment_Tokeniser
                 return tk_string;
         case 'a' ... 'z':
         case 'A' ... 'Z':
-            return keyword_or_identifier(spelling);
+            // a single probe of the keyword table
+            return keywords.find(spelling.data(), spelling.size(), tk_identifier);
         case '^':
             return tk_identifier;
         case '!':
@@ -332,81 +141,60 @@ namespace Assignment_Tokeniser
         return tk_identifier;
     }
 
-    // work out the correct spelling to use in the Token object being created by new_token()
-    // the spelling is a valid token and kind is its kind
-    string correct_spelling(TokenKind kind, string spelling)
+    // the part of a token's characters that is its spelling
+    // comments and strings lose their delimiters and numbers lose trailing 0s from a fraction,
+    // and the '.' if no fraction digits are left, the bounds are found without moving any characters
+    void spelling_bounds(TokenKind kind, const char *s, int n, int &first, int &last)
     {
-        //fixing eol_comment
-        if (kind == tk_eol_comment)
+        first = 0;
+        last = n;
+        switch (kind)
         {
-            for (int i = 0; i < spelling.length(); i++)
-            {
-                spelling[i] = spelling[i + 2];
-            }
-            spelling.pop_back();
-            spelling.pop_back();
-            for (int i = 0; i < spelling.length(); i++)
-            {
-                if (spelling[i] == '\n')
-                {
-                    spelling[i] = spelling[i + 1];
-                    spelling.pop_back();
-                }
-            }
-        }
-
-        //fixing adhoc_comment
-        if (kind == tk_adhoc_comment)
+        case tk_eol_comment:
+            // '//' and '\n'
+            first = 2;
+            last = n - 1;
+            break;
+        case tk_adhoc_comment:
+            // '/*' and '*/'
+            first = 2;
+            last = n - 2;
+            break;
+        case tk_string:
+            // '"' and '"'
+            first = 1;
+            last = n - 1;
+            break;
+        case tk_number:
         {
-            for (int i = 0; i < spelling.length(); i++)
-            {
-                spelling[i] = spelling[i + 2];
-            }
-            spelling.pop_back();
-            spelling.pop_back();
-            spelling.pop_back();
-            spelling.pop_back();
+            const char *dot = (const char *)memchr(s, '.', n);
+            if (dot == nullptr)
+                break;
+            while (last > dot - s + 1 && s[last - 1] == '0')
+                last--;
+            if (last == dot - s + 1)
+                last--;
+            break;
         }
-
-        //fixing quotation mark for string
-        if (kind == tk_string)
-        {
-            for (int i = 0; i < spelling.length(); i++)
-            {
-                spelling[i] = spelling[i + 1];
-            }
-            spelling.pop_back();
-            spelling.pop_back();
+        default:
+            break;
         }
+    }
 
-        //fixing extra dot and zeroes from numbers
-        int dot_index;
-        bool dot_exist = false;
+    // work out the correct spelling to use in the Token object being created by new_token()
+    // the spelling is a valid token and kind is its kind
+    string correct_spelling(TokenKind kind, string spelling)
+    {
+        int first, last;
+        spelling_bounds(kind, spelling.data(), spelling.size(), first, last);
+        if (first == 0 && last == (int)spelling.size())
+            return spelling;
+        return spelling.substr(first, last - first);
+    }
 
-        if (kind == tk_number)
-        {
-            //fix dot with zeroes behind
-            //find if dot exist
-            for (int i = 0; i < spelling.length(); i++)
-            {
-                if (spelling[i] == '.')
-                {
-                    dot_index = i;
-                    dot_exist = true;
-                }
-            }
-            if (dot_exist)
-            {
-                int initial_spelling_length = spelling.length();
-                for (int i = dot_index; i < initial_spelling_length; i++)
-                {
-                    if (spelling.back() == '0' || spelling.back() == '.')
-                    {
-                        spelling.pop_back();
-                    }
-                }
-            }
-        }
-        return spelling;
+    // the nearest double to a number_value
+    double number_value::to_double() const
+    {
+        return mantissa / pow((double)radix, scale);
     }
-}
\ No newline at end of file
+}
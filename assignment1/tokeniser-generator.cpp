@@ -0,0 +1,1059 @@
+// tokeniser-generator - build a minimised DFA tokeniser from the BNF token rules in a tokeniser header
+//
+// usage: tokeniser-generator [--shortest rule]... includes/tokeniser.h > includes/tokeniser-dfa.h
+//        tokeniser-generator --groups includes/tokeniser-extras.h includes/tokeniser.h > includes/tokeniser-groups.h
+//
+// The header must describe its tokens in the same way as includes/tokeniser.h:
+// * the token rules are comment lines of the form '* rule ::= definition' or '- rule ::= definition',
+//   they start after the '*** TOKEN RULES' heading and end at the next '** ' heading, later sections can
+//   define more rules for the parser in the same way, eg not_star, but they cannot replace a token rule
+// * the rule 'token' lists the rules that each form a token
+// * a definition uses ' ' literals, '-' ranges, ( ) grouping, | alternatives and ?, * and + repetition,
+//   a definition of the form 'all unicode code-points from 0x370 to 0x3FF and ...' lists code-point ranges
+// * the TokenKind enum gives each token its kind, either by name, tk_<rule> for a whole rule, or by a
+//   comment that is a single literal, eg tk_semi // ';', for each literal in a rule that has no tk_<rule>
+// * a comment on a kind of the form ''x' and 'y' are not part of the spelling' describes the delimiters that
+//   correct_spelling() removes
+//
+// The generated header contains:
+// * the DFA as tables, the input is split into character classes so each state has one entry per class
+// * dfa_scan() which finds the longest token at the start of some UTF-8 text
+// * dfa_classify_spelling() for the literals that can never be matched because an earlier rule matches
+//   the same text, eg keywords matched as identifiers, they are looked up in the keywords table in keywords.h
+// * dfa_correct_spelling() which removes the delimiters described in the comments, other spelling changes
+//   that are only described in words, eg removing trailing 0s from numbers, are not generated
+//
+// With --groups the generated header instead lists the code points that can start each rule that has a
+// character group, the groups are the Char enum members in the extras header with a comment of the form
+// 'characters that start rule <rule>', eg cg_number // characters that start rule number.
+//
+// The DFA always matches the longest token, earlier rules in 'token' win if two rules match the same text.
+// A rule named with --shortest stops at its first match instead, this is needed for rules like adhoc_comment
+// where the repeated characters include the closing delimiter.
+//
+// The DFA is built by Thompson's construction of an NFA, the subset construction and Moore's partition
+// refinement, states that cannot lead to a token are removed and classes with identical columns are merged.
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// to shorten the code
+using namespace std;
+
+// report an error in the spec and exit
+static void spec_error(string message)
+{
+    cerr << "tokeniser-generator: " << message << endl;
+    exit(1);
+}
+
+// ***** the token spec read from the header *****
+
+struct token_spec
+{
+    string guard;                               // the header's include guard
+    string space;                               // the namespace that declares TokenKind
+    map<string, string> rules;                  // the definition of each rule
+    vector<string> token_rules;                 // the rules that form tokens in order
+    set<string> kinds;                          // every TokenKind
+    map<string, string> literal_kinds;          // the kind of each literal that has its own kind
+    map<string, pair<string, string>> delimiters; // the delimiters removed from the spelling of a kind
+};
+
+// the characters of a literal with its escapes replaced
+static string unescape(string s)
+{
+    string chars;
+    for (size_t i = 0; i < s.size(); i++)
+    {
+        if (s[i] != '\\' || i + 1 == s.size())
+        {
+            chars += s[i];
+            continue;
+        }
+        switch (s[++i])
+        {
+        case 't': chars += '\t'; break;
+        case 'n': chars += '\n'; break;
+        case 'r': chars += '\r'; break;
+        default:  chars += s[i]; break;
+        }
+    }
+    return chars;
+}
+
+// read the rules, namespace, guard and TokenKind enum from a header
+static token_spec read_spec(istream &in)
+{
+    token_spec spec;
+    regex guard_line(R"(^\s*#ifndef\s+(\w+))");
+    regex namespace_line(R"(^\s*namespace\s+(\w+))");
+    regex rule_line(R"(^\s*//\s*[*-]\s*(\w+)\s*::=\s*(.*?)\s*$)");
+    regex kind_line(R"(^\s*(tk_\w+)\s*(=[^,]*)?,?\s*(//\s*(.*?))?\s*$)");
+    regex literal_comment(R"(^'((\\.|[^'\\])+)'\s*(,.*)?$)");
+    regex delimiter_comment(R"('((\\.|[^'\\])+)' and '((\\.|[^'\\])+)' are not part of the spelling)");
+
+    bool in_rules = false, rules_done = false, in_enum = false;
+    string line;
+    smatch m;
+    while (getline(in, line))
+    {
+        if (spec.guard == "" && regex_search(line, m, guard_line))
+            spec.guard = m[1];
+        else if (spec.space == "" && regex_search(line, m, namespace_line))
+            spec.space = m[1];
+
+        if (!rules_done && line.find("*** TOKEN RULES") != string::npos)
+            in_rules = true;
+        else if (in_rules && regex_search(line, regex(R"(^\s*//\s*\*\*\s)")))
+        {
+            in_rules = false;
+            rules_done = true;
+        }
+        else if (in_rules && regex_match(line, m, rule_line))
+            spec.rules[m[1]] = m[2];
+        else if (rules_done && regex_match(line, m, rule_line) && spec.rules.count(m[1]) == 0)
+            spec.rules[m[1]] = m[2];
+
+        if (line.find("enum TokenKind") != string::npos)
+            in_enum = true;
+        else if (in_enum && regex_search(line, regex(R"(^\s*\})")))
+            in_enum = false;
+        else if (in_enum && regex_match(line, m, kind_line))
+        {
+            string kind = m[1], comment = m[4];
+            spec.kinds.insert(kind);
+
+            smatch c;
+            if (regex_match(comment, c, literal_comment))
+                spec.literal_kinds[unescape(c[1])] = kind;
+            if (regex_search(comment, c, delimiter_comment))
+                spec.delimiters[kind] = { unescape(c[1]), unescape(c[3]) };
+        }
+    }
+
+    if (spec.rules.count("token") == 0)
+        spec_error("there is no rule named token");
+    if (spec.kinds.count("tk_oops") == 0)
+        spec_error("TokenKind must include tk_oops");
+
+    // token ::= rule | rule ...
+    stringstream alternatives(regex_replace(spec.rules["token"], regex(R"(\|)"), " "));
+    string rule;
+    while (alternatives >> rule)
+    {
+        if (spec.rules.count(rule) == 0)
+            spec_error("token rule " + rule + " is not defined");
+        spec.token_rules.push_back(rule);
+    }
+    return spec;
+}
+
+// ***** regular expressions built from rule definitions *****
+
+// a range of code points
+struct char_range
+{
+    int first;
+    int last;
+};
+
+// a regular expression tree
+struct rx
+{
+    enum rx_op { chars, sequence, alternatives, optional, zero_or_more, one_or_more } op;
+    vector<char_range> ranges;                  // for chars
+    vector<rx> parts;                           // for everything else
+};
+
+// the code points in a UTF-8 string
+static vector<int> code_points(const string &s)
+{
+    vector<int> points;
+    for (size_t i = 0; i < s.size();)
+    {
+        unsigned char c = s[i];
+        int extra = c < 0x80 ? 0 : c < 0xE0 ? 1 : c < 0xF0 ? 2 : 3;
+        int point = extra == 0 ? c : c & (0x3F >> extra);
+        for (int k = 1; k <= extra && i + k < s.size(); k++)
+            point = point << 6 | (s[i + k] & 0x3F);
+        points.push_back(point);
+        i += extra + 1;
+    }
+    return points;
+}
+
+// parses the definition of a rule, named rules are replaced by their definitions
+class rule_parser
+{
+public:
+    rule_parser(const token_spec &spec, vector<string> &expanding) : spec(spec), expanding(expanding) {}
+
+    rx parse(string rule)
+    {
+        if (find(expanding.begin(), expanding.end(), rule) != expanding.end())
+            spec_error("rule " + rule + " is recursive");
+        if (spec.rules.count(rule) == 0)
+            spec_error("rule " + rule + " is not defined");
+
+        name = rule;
+        text = spec.rules.at(rule);
+        pos = 0;
+
+        // all unicode code-points from 0x370 to 0x3FF and 0x1F00 to 0x1FFF
+        if (text.compare(0, 23, "all unicode code-points") == 0)
+        {
+            rx r { rx::chars, {}, {} };
+            regex range(R"((0x[0-9A-Fa-f]+)\s+to\s+(0x[0-9A-Fa-f]+))");
+            for (sregex_iterator i(text.begin(), text.end(), range), end; i != end; ++i)
+                r.ranges.push_back({ stoi((*i)[1], nullptr, 16), stoi((*i)[2], nullptr, 16) });
+            return r;
+        }
+
+        expanding.push_back(rule);
+        rx r = parse_alternatives();
+        skip_spaces();
+        if (pos != text.size())
+            fail("unexpected '" + text.substr(pos, 1) + "'");
+        expanding.pop_back();
+        return r;
+    }
+
+private:
+    const token_spec &spec;
+    vector<string> &expanding;                  // the rules being expanded, to catch recursion
+    string name;
+    string text;
+    size_t pos;
+
+    void fail(string message)
+    {
+        spec_error("rule " + name + ": " + message + " at column " + to_string(pos + 1) + " of: " + text);
+    }
+
+    void skip_spaces()
+    {
+        while (pos < text.size() && text[pos] == ' ')
+            pos++;
+    }
+
+    bool have(char c)
+    {
+        skip_spaces();
+        if (pos < text.size() && text[pos] == c)
+        {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+
+    // alternatives ::= sequence ('|' sequence)*
+    rx parse_alternatives()
+    {
+        rx r { rx::alternatives, {}, { parse_sequence() } };
+        while (have('|'))
+            r.parts.push_back(parse_sequence());
+        return r.parts.size() == 1 ? r.parts[0] : r;
+    }
+
+    // sequence ::= repeat+
+    rx parse_sequence()
+    {
+        rx r { rx::sequence, {}, {} };
+        skip_spaces();
+        while (pos < text.size() && text[pos] != '|' && text[pos] != ')')
+        {
+            r.parts.push_back(parse_repeat());
+            skip_spaces();
+        }
+        if (r.parts.empty())
+            fail("empty alternative");
+        return r.parts.size() == 1 ? r.parts[0] : r;
+    }
+
+    // repeat ::= atom ('?' | '*' | '+')*
+    rx parse_repeat()
+    {
+        rx r = parse_atom();
+        for (;;)
+        {
+            if (have('?'))
+                r = rx { rx::optional, {}, { r } };
+            else if (have('*'))
+                r = rx { rx::zero_or_more, {}, { r } };
+            else if (have('+'))
+                r = rx { rx::one_or_more, {}, { r } };
+            else
+                return r;
+        }
+    }
+
+    // atom ::= literal ('-' literal)? | rule | '(' alternatives ')'
+    rx parse_atom()
+    {
+        if (have('('))
+        {
+            rx r = parse_alternatives();
+            if (!have(')'))
+                fail("missing ')'");
+            return r;
+        }
+
+        if (pos < text.size() && text[pos] == '\'')
+        {
+            vector<int> first = code_points(parse_literal());
+            if (have('-'))
+            {
+                vector<int> last = code_points(parse_literal());
+                if (first.size() != 1 || last.size() != 1 || first[0] > last[0])
+                    fail("a range must be from one character to a later one");
+                return rx { rx::chars, { { first[0], last[0] } }, {} };
+            }
+
+            rx r { rx::sequence, {}, {} };
+            for (int c : first)
+                r.parts.push_back(rx { rx::chars, { { c, c } }, {} });
+            return r.parts.size() == 1 ? r.parts[0] : r;
+        }
+
+        size_t start = pos;
+        while (pos < text.size() && (isalnum((unsigned char)text[pos]) || text[pos] == '_'))
+            pos++;
+        if (pos == start)
+            fail("expected a literal, rule or '('");
+
+        string rule = text.substr(start, pos - start);
+        rx r = rule_parser(spec, expanding).parse(rule);
+        return r;
+    }
+
+    // the characters of a ' ' literal
+    string parse_literal()
+    {
+        skip_spaces();
+        if (pos >= text.size() || text[pos] != '\'')
+            fail("expected a literal");
+        size_t start = ++pos;
+        while (pos < text.size() && text[pos] != '\'')
+            pos += text[pos] == '\\' ? 2 : 1;
+        if (pos >= text.size())
+            fail("unterminated literal");
+        return unescape(text.substr(start, pos++ - start));
+    }
+};
+
+// the literals of a rule that is only a choice between literals, eg symbol, or an empty vector
+static vector<string> literal_alternatives(const string &definition)
+{
+    vector<string> literals;
+    regex alternative(R"(^\s*'((\\.|[^'\\])+)'\s*(\||$))");
+    smatch m;
+    string rest = definition;
+    while (rest != "" && regex_search(rest, m, alternative))
+    {
+        literals.push_back(unescape(m[1]));
+        rest = m.suffix();
+    }
+    return rest == "" ? literals : vector<string>();
+}
+
+// the code points that can start a match of r, nullable is set if r can match no characters
+static void first_chars(const rx &r, vector<char_range> &first, bool &nullable)
+{
+    switch (r.op)
+    {
+    case rx::chars:
+        first.insert(first.end(), r.ranges.begin(), r.ranges.end());
+        nullable = false;
+        break;
+    case rx::sequence:
+        nullable = true;
+        for (size_t i = 0; i < r.parts.size() && nullable; i++)
+            first_chars(r.parts[i], first, nullable);
+        break;
+    case rx::alternatives:
+    {
+        bool any = false;
+        for (auto &part : r.parts)
+        {
+            first_chars(part, first, nullable);
+            any = any || nullable;
+        }
+        nullable = any;
+        break;
+    }
+    case rx::optional:
+    case rx::zero_or_more:
+    case rx::one_or_more:
+        first_chars(r.parts[0], first, nullable);
+        nullable = nullable || r.op != rx::one_or_more;
+        break;
+    }
+}
+
+// sort ranges and join the ones that overlap or touch
+static vector<char_range> merge_ranges(vector<char_range> ranges)
+{
+    sort(ranges.begin(), ranges.end(), [](const char_range &a, const char_range &b) { return a.first < b.first; });
+    vector<char_range> merged;
+    for (auto &range : ranges)
+    {
+        if (!merged.empty() && range.first <= merged.back().last + 1)
+            merged.back().last = max(merged.back().last, range.last);
+        else
+            merged.push_back(range);
+    }
+    return merged;
+}
+
+// ***** the NFA *****
+
+// a transition on a range of code points
+struct nfa_edge
+{
+    char_range on;
+    int to;
+};
+
+struct nfa_state
+{
+    vector<nfa_edge> edges;
+    vector<int> empty;                          // transitions that read nothing
+    int rule;                                   // index of the token rule the state belongs to
+    int accepts;                                // index of the token accepted or -1
+};
+
+// a token that the NFA accepts, earlier tokens have priority
+struct nfa_token
+{
+    string kind;
+    int rule;
+    string literal;                             // the literal if the token is one literal of a rule
+};
+
+class nfa
+{
+public:
+    vector<nfa_state> states;
+    vector<nfa_token> tokens;
+
+    nfa() { add(-1); }                          // state 0 is the start state
+
+    // add a token that matches r
+    void add_token(const rx &r, int rule, string kind, string literal)
+    {
+        pair<int, int> f = build(r, rule);
+        int accept = add(rule);
+        states[accept].accepts = tokens.size();
+        tokens.push_back({ kind, rule, literal });
+        states[0].empty.push_back(f.first);
+        states[f.second].empty.push_back(accept);
+    }
+
+private:
+    int add(int rule)
+    {
+        states.push_back({ {}, {}, rule, -1 });
+        return states.size() - 1;
+    }
+
+    // Thompson's construction, returns the start and end states of a fragment matching r
+    pair<int, int> build(const rx &r, int rule)
+    {
+        int start = add(rule), end = add(rule);
+        switch (r.op)
+        {
+        case rx::chars:
+            for (auto &range : r.ranges)
+                states[start].edges.push_back({ range, end });
+            break;
+        case rx::sequence:
+        {
+            int at = start;
+            for (auto &part : r.parts)
+            {
+                pair<int, int> f = build(part, rule);
+                states[at].empty.push_back(f.first);
+                at = f.second;
+            }
+            states[at].empty.push_back(end);
+            break;
+        }
+        case rx::alternatives:
+            for (auto &part : r.parts)
+            {
+                pair<int, int> f = build(part, rule);
+                states[start].empty.push_back(f.first);
+                states[f.second].empty.push_back(end);
+            }
+            break;
+        case rx::optional:
+        case rx::zero_or_more:
+        case rx::one_or_more:
+        {
+            pair<int, int> f = build(r.parts[0], rule);
+            states[start].empty.push_back(f.first);
+            states[f.second].empty.push_back(end);
+            if (r.op != rx::one_or_more)
+                states[start].empty.push_back(end);
+            if (r.op != rx::optional)
+                states[f.second].empty.push_back(f.first);
+            break;
+        }
+        }
+        return { start, end };
+    }
+};
+
+// ***** the DFA *****
+
+struct dfa
+{
+    vector<int> bounds;                         // interval i is the code points from bounds[i] to bounds[i+1]-1
+    vector<vector<int>> next;                   // next[state][interval] or -1
+    vector<int> accepts;                        // index of the token accepted by each state or -1
+};
+
+// the states reachable from a set of NFA states without reading anything
+static vector<int> closure(const nfa &n, vector<int> set)
+{
+    vector<bool> seen(n.states.size(), false);
+    vector<int> work = set;
+    set.clear();
+    while (!work.empty())
+    {
+        int s = work.back();
+        work.pop_back();
+        if (seen[s])
+            continue;
+        seen[s] = true;
+        set.push_back(s);
+        for (int e : n.states[s].empty)
+            work.push_back(e);
+    }
+    sort(set.begin(), set.end());
+    return set;
+}
+
+// the subset construction
+// once a set includes the accept state of a --shortest rule that rule's states are dropped from the set
+static dfa subset_construction(const nfa &n, const set<int> &shortest)
+{
+    dfa d;
+
+    // split the code points into intervals that every edge either covers or misses
+    set<int> cuts = { 0, 0x110000 };
+    for (auto &s : n.states)
+        for (auto &e : s.edges)
+        {
+            cuts.insert(e.on.first);
+            cuts.insert(e.on.last + 1);
+        }
+    d.bounds.assign(cuts.begin(), cuts.end());
+    int intervals = d.bounds.size() - 1;
+
+    map<pair<vector<int>, int>, int> ids;
+    vector<vector<int>> sets;
+
+    auto state_of = [&](vector<int> set) -> int
+    {
+        set = closure(n, set);
+        if (set.empty())
+            return -1;
+
+        int accepts = -1;
+        vector<int> dropped_rules;
+        for (int s : set)
+        {
+            int t = n.states[s].accepts;
+            if (t < 0)
+                continue;
+            if (accepts < 0 || t < accepts)
+                accepts = t;
+            if (shortest.count(n.tokens[t].rule) > 0)
+                dropped_rules.push_back(n.tokens[t].rule);
+        }
+        if (!dropped_rules.empty())
+        {
+            vector<int> kept;
+            for (int s : set)
+                if (find(dropped_rules.begin(), dropped_rules.end(), n.states[s].rule) == dropped_rules.end())
+                    kept.push_back(s);
+            set = kept;
+        }
+
+        auto key = make_pair(set, accepts);
+        auto found = ids.find(key);
+        if (found != ids.end())
+            return found->second;
+
+        int id = sets.size();
+        ids[key] = id;
+        sets.push_back(set);
+        d.accepts.push_back(accepts);
+        return id;
+    };
+
+    state_of({ 0 });
+    for (size_t id = 0; id < sets.size(); id++)
+    {
+        d.next.push_back(vector<int>(intervals, -1));
+        for (int i = 0; i < intervals; i++)
+        {
+            vector<int> moves;
+            for (int s : sets[id])
+                for (auto &e : n.states[s].edges)
+                    if (e.on.first <= d.bounds[i] && d.bounds[i + 1] - 1 <= e.on.last)
+                        moves.push_back(e.to);
+            if (!moves.empty())
+                d.next[id][i] = state_of(moves);
+        }
+    }
+    return d;
+}
+
+// the state reached from the start state by reading the code points of s or -1
+static int run(const dfa &d, const string &s)
+{
+    int state = 0;
+    for (int c : code_points(s))
+    {
+        int i = upper_bound(d.bounds.begin(), d.bounds.end(), c) - d.bounds.begin() - 1;
+        state = d.next[state][i];
+        if (state < 0)
+            return -1;
+    }
+    return state;
+}
+
+// Moore's partition refinement after removing states that cannot lead to a token,
+// states with the same kind are merged, the start state is state 0 of the result
+static dfa minimise(const dfa &d, const nfa &n)
+{
+    int states = d.next.size(), intervals = d.bounds.size() - 1;
+
+    // states that can reach an accepting state
+    vector<bool> live(states, false);
+    for (bool changed = true; changed;)
+    {
+        changed = false;
+        for (int s = 0; s < states; s++)
+        {
+            if (live[s])
+                continue;
+            bool reaches = d.accepts[s] >= 0;
+            for (int i = 0; i < intervals && !reaches; i++)
+                reaches = d.next[s][i] >= 0 && live[d.next[s][i]];
+            if (reaches)
+                live[s] = changed = true;
+        }
+    }
+    auto target = [&](int s, int i) { int t = d.next[s][i]; return t >= 0 && live[t] ? t : -1; };
+
+    // refine blocks of states with the same kind until every block's states have the same transitions
+    vector<int> block(states);
+    map<string, int> by_kind;
+    for (int s = 0; s < states; s++)
+    {
+        string kind = d.accepts[s] < 0 ? "" : n.tokens[d.accepts[s]].kind;
+        block[s] = by_kind.emplace(kind, by_kind.size()).first->second;
+    }
+    for (size_t blocks = by_kind.size(), previous = 0; blocks != previous;)
+    {
+        map<vector<int>, int> signatures;
+        vector<int> refined(states);
+        for (int s = 0; s < states; s++)
+        {
+            vector<int> signature = { block[s] };
+            for (int i = 0; i < intervals; i++)
+            {
+                int t = target(s, i);
+                signature.push_back(t < 0 ? -1 : block[t]);
+            }
+            refined[s] = signatures.emplace(signature, signatures.size()).first->second;
+        }
+        previous = blocks;
+        blocks = signatures.size();
+        block = refined;
+    }
+
+    // number the blocks in the order they are reached from the start state
+    map<int, int> number;
+    vector<int> order = { 0 };
+    number[block[0]] = 0;
+    for (size_t k = 0; k < order.size(); k++)
+        for (int i = 0; i < intervals; i++)
+        {
+            int t = target(order[k], i);
+            if (t >= 0 && number.emplace(block[t], order.size()).second)
+                order.push_back(t);
+        }
+
+    dfa m;
+    m.bounds = d.bounds;
+    for (int s : order)
+    {
+        m.accepts.push_back(d.accepts[s]);
+        m.next.push_back(vector<int>(intervals, -1));
+        for (int i = 0; i < intervals; i++)
+        {
+            int t = target(s, i);
+            m.next.back()[i] = t < 0 ? -1 : number[block[t]];
+        }
+    }
+    return m;
+}
+
+// ***** writing the generated header *****
+
+// a C++ character or string literal for the characters in s
+static string cpp_literal(const string &s, char quote)
+{
+    string out(1, quote);
+    for (char c : s)
+    {
+        switch (c)
+        {
+        case '\t': out += "\\t"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        case '\\': out += "\\\\"; break;
+        default:
+            if (c == quote)
+                out += '\\';
+            out += c;
+        }
+    }
+    return out + quote;
+}
+
+static void write_header(ostream &out, const token_spec &spec, const string &source, const string &command, const dfa &m, const nfa &n,
+                         const map<string, vector<pair<string, string>>> &keywords)
+{
+    int states = m.next.size(), intervals = m.bounds.size() - 1;
+
+    // intervals with identical columns share a character class
+    map<vector<int>, int> columns;
+    vector<int> interval_class(intervals);
+    for (int i = 0; i < intervals; i++)
+    {
+        vector<int> column;
+        for (int s = 0; s < states; s++)
+            column.push_back(m.next[s][i]);
+        interval_class[i] = columns.emplace(column, columns.size()).first->second;
+    }
+    int classes = columns.size();
+    int other = interval_class[intervals - 1];
+    auto class_of = [&](int c) { return interval_class[upper_bound(m.bounds.begin(), m.bounds.end(), c) - m.bounds.begin() - 1]; };
+
+    string guard = spec.guard;
+    if (guard.size() > 2 && guard.compare(guard.size() - 2, 2, "_H") == 0)
+        guard.insert(guard.size() - 2, "_DFA");
+    else
+        guard += "_DFA";
+
+    out << "#ifndef " << guard << "\n#define " << guard << "\n\n";
+    out << "#include \"" << source.substr(source.find_last_of('/') + 1) << "\"\n";
+    if (!keywords.empty())
+        out << "#include \"keywords.h\"\n";
+    out << "#include <cstring>\n#include <string>\n\n";
+    out << "// generated by " << command << ", do not edit\n";
+    out << "//\n";
+    out << "// - a minimised DFA with " << states << " states and " << classes << " character classes\n";
+    out << "// - dfa_scan(p,n,kind) returns the length in bytes of the longest token at the start of the UTF-8 text p\n";
+    out << "//   and sets kind, it returns 0 and sets kind to tk_oops if no token can be formed\n";
+    out << "// - dfa_classify_spelling(kind,s,n) returns the kind of a literal that the DFA accepts as another kind\n";
+    out << "// - dfa_correct_spelling(kind,spelling) removes the delimiters that are not part of a token's spelling\n";
+    out << "//\n";
+    out << "namespace " << spec.space << "\n{\n";
+
+    out << "    constexpr int dfa_states = " << states << " ;\n";
+    out << "    constexpr int dfa_classes = " << classes << " ;\n\n";
+
+    out << "    // the class of each ASCII character\n";
+    out << "    inline constexpr unsigned char dfa_ascii_class[128] =\n    {";
+    for (int c = 0; c < 128; c++)
+        out << (c % 16 == 0 ? "\n        " : " ") << class_of(c) << (c < 127 ? "," : "");
+    out << "\n    } ;\n\n";
+
+    out << "    // the classes of the other code points, any code point not in a range has class " << other << "\n";
+    out << "    struct dfa_range { int first ; int last ; int dfa_class ; } ;\n";
+    out << "    inline constexpr dfa_range dfa_ranges[] =\n    {\n";
+    int nranges = 0;
+    for (int i = 0; i < intervals; i++)
+    {
+        int first = max(m.bounds[i], 128), last = m.bounds[i + 1] - 1;
+        if (last < 128 || interval_class[i] == other)
+            continue;
+        while (i + 1 < intervals && interval_class[i + 1] == interval_class[i])
+            last = m.bounds[++i + 1] - 1;
+        out << "        { 0x" << hex << first << ", 0x" << last << dec << ", " << interval_class[i] << " },\n";
+        nranges++;
+    }
+    if (nranges == 0)
+        out << "        { -1, -1, " << other << " },\n";
+    out << "    } ;\n\n";
+
+    out << "    // the next state for each state and class, -1 if no token can be formed\n";
+    out << "    inline constexpr short dfa_next[dfa_states][dfa_classes] =\n    {\n";
+    for (int s = 0; s < states; s++)
+    {
+        vector<int> row(classes, -1);
+        for (int i = 0; i < intervals; i++)
+            row[interval_class[i]] = m.next[s][i];
+        out << "        {";
+        for (int c = 0; c < classes; c++)
+            out << (c == 0 ? " " : ", ") << row[c];
+        out << " },\n";
+    }
+    out << "    } ;\n\n";
+
+    out << "    // the kind of token accepted in each state, tk_oops if none\n";
+    out << "    inline constexpr TokenKind dfa_accepts[dfa_states] =\n    {\n";
+    for (int s = 0; s < states; s++)
+        out << "        " << (m.accepts[s] < 0 ? "tk_oops" : n.tokens[m.accepts[s]].kind) << ",\n";
+    out << "    } ;\n\n";
+
+    out << R"(    // the character class of code point ch
+    inline int dfa_char_class(int ch)
+    {
+        if ( ch >= 0 && ch < 128 ) return dfa_ascii_class[ch] ;
+
+        int lo = 0, hi = sizeof(dfa_ranges) / sizeof(dfa_ranges[0]) ;
+        while ( lo < hi )
+        {
+            int mid = (lo + hi) / 2 ;
+            if ( ch < dfa_ranges[mid].first ) hi = mid ;
+            else
+            if ( ch > dfa_ranges[mid].last ) lo = mid + 1 ;
+            else return dfa_ranges[mid].dfa_class ;
+        }
+        return )" << other << R"( ;
+    }
+
+    // decode the UTF-8 code point at the start of the n bytes at p and set size to its length in bytes,
+    // a byte that does not start a valid encoding is returned as -1
+    inline int dfa_decode(const char *p,int n,int &size)
+    {
+        unsigned char c = p[0] ;
+        size = c < 0x80 ? 1 : c >= 0xC2 && c < 0xE0 ? 2 : c >= 0xE0 && c < 0xF0 ? 3 : c >= 0xF0 && c < 0xF5 ? 4 : 0 ;
+        if ( size == 1 ) return c ;
+        if ( size == 0 || size > n ) { size = 1 ; return -1 ; }
+
+        int ch = c & (0x7F >> size) ;
+        for ( int i = 1 ; i < size ; i++ )
+        {
+            if ( (p[i] & 0xC0) != 0x80 ) { size = 1 ; return -1 ; }
+            ch = ch << 6 | (p[i] & 0x3F) ;
+        }
+        return ch ;
+    }
+
+    // the length in bytes of the longest token at the start of the n bytes at p, its kind is returned in kind
+    inline int dfa_scan(const char *p,int n,TokenKind &kind)
+    {
+        int state = 0, length = 0 ;
+        kind = tk_oops ;
+        for ( int i = 0, size ; i < n ; i += size )
+        {
+            state = dfa_next[state][dfa_char_class(dfa_decode(p + i,n - i,size))] ;
+            if ( state < 0 ) break ;
+            if ( dfa_accepts[state] != tk_oops )
+            {
+                kind = dfa_accepts[state] ;
+                length = i + size ;
+            }
+        }
+        return length ;
+    }
+
+)";
+
+    out << "    // the kind of the token with spelling s of length n that the DFA accepted as kind\n";
+    out << "    inline TokenKind dfa_classify_spelling(TokenKind kind,const char *s,int n)\n    {\n";
+    out << "        switch(kind)\n        {\n";
+    for (auto &k : keywords)
+    {
+        out << "        case " << k.first << ":\n";
+        out << "            // keywords.h lists";
+        for (size_t w = 0; w < k.second.size(); w++)
+            out << (w == 0 ? " " : ", ") << cpp_literal(k.second[w].first, '\'');
+        out << "\n";
+        out << "            return keywords.find(s,n,kind) ;\n";
+    }
+    out << "        default:\n            break ;\n        }\n        return kind ;\n    }\n\n";
+
+    out << "    // the spelling of a token without the delimiters that are not part of it\n";
+    out << "    inline std::string dfa_correct_spelling(TokenKind kind,const std::string &spelling)\n    {\n";
+    out << "        switch(kind)\n        {\n";
+    for (auto &d : spec.delimiters)
+    {
+        size_t a = d.second.first.size(), b = d.second.second.size();
+        out << "        case " << d.first << ": return spelling.substr(" << a << ",spelling.size() - " << a + b << ") ;\n";
+    }
+    out << "        default: return spelling ;\n        }\n    }\n";
+    out << "}\n\n#endif //" << guard << "\n";
+}
+
+// the character groups in a header's Char enum, each is its constant and the rule whose first characters it holds
+static vector<pair<string, string>> read_groups(istream &in)
+{
+    vector<pair<string, string>> groups;
+    regex group_line(R"(^\s*(cg_\w+)\s*,?\s*//\s*characters that start rule (\w+)\s*$)");
+    string line;
+    smatch m;
+    while (getline(in, line))
+    {
+        if (regex_match(line, m, group_line))
+            groups.push_back({ m[1], m[2] });
+    }
+    if (groups.empty())
+        spec_error("there are no character groups of the form cg_rule // characters that start rule rule");
+    return groups;
+}
+
+// a C++ literal for code point c, a character literal if it is printable ASCII or a control character with an escape
+static string code_point_literal(int c)
+{
+    if ((c >= ' ' && c <= '~') || c == '\t' || c == '\n' || c == '\r')
+        return cpp_literal(string(1, (char)c), '\'');
+
+    stringstream hexed;
+    hexed << "0x" << hex << c;
+    return hexed.str();
+}
+
+static void write_groups(ostream &out, const token_spec &spec, const string &extras, const string &command,
+                         const vector<pair<string, string>> &groups)
+{
+    string guard = spec.guard;
+    if (guard.size() > 2 && guard.compare(guard.size() - 2, 2, "_H") == 0)
+        guard.insert(guard.size() - 2, "_GROUPS");
+    else
+        guard += "_GROUPS";
+
+    out << "#ifndef " << guard << "\n#define " << guard << "\n\n";
+    out << "#include \"" << extras.substr(extras.find_last_of('/') + 1) << "\"\n\n";
+    out << "// generated by " << command << ", do not edit\n";
+    out << "//\n";
+    out << "// - the code points that can start each rule that has a character group, eg cg_number for rule number\n";
+    out << "// - each group's ranges are in increasing order and do not overlap or touch\n";
+    out << "//\n";
+    out << "namespace " << spec.space << "\n{\n";
+
+    out << "    struct char_group_range { int cg ; int first ; int last ; } ;\n";
+    out << "    inline constexpr char_group_range char_group_ranges[] =\n    {\n";
+    for (auto &group : groups)
+    {
+        vector<string> expanding;
+        vector<char_range> first;
+        bool nullable = false;
+        first_chars(rule_parser(spec, expanding).parse(group.second), first, nullable);
+        if (nullable)
+            spec_error("rule " + group.second + " can match no characters so " + group.first + " is not a character group");
+
+        out << "        // " << group.second << " ::= " << spec.rules.at(group.second) << "\n";
+        for (auto &range : merge_ranges(first))
+        {
+            out << "        { " << group.first << ", " << code_point_literal(range.first) << ", "
+                << code_point_literal(range.last) << " },\n";
+        }
+    }
+    out << "    } ;\n";
+    out << "}\n\n#endif //" << guard << "\n";
+}
+
+// main program
+int main(int argc, char **argv)
+{
+    vector<string> shortest_rules;
+    string source, groups_source, command = "tokeniser-generator";
+    for (int i = 1; i < argc; i++)
+        command += " " + string(argv[i]);
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--shortest" && i + 1 < argc)
+            shortest_rules.push_back(argv[++i]);
+        else if (arg == "--groups" && i + 1 < argc)
+            groups_source = argv[++i];
+        else if (source == "" && arg[0] != '-')
+            source = arg;
+        else
+            spec_error("usage: tokeniser-generator [--shortest rule]... [--groups tokeniser-extras.h] tokeniser.h");
+    }
+    if (source == "")
+        spec_error("usage: tokeniser-generator [--shortest rule]... [--groups tokeniser-extras.h] tokeniser.h");
+
+    ifstream in(source);
+    if (!in)
+        spec_error("cannot open " + source);
+    token_spec spec = read_spec(in);
+
+    if (groups_source != "")
+    {
+        ifstream extras(groups_source);
+        if (!extras)
+            spec_error("cannot open " + groups_source);
+        write_groups(cout, spec, groups_source, command, read_groups(extras));
+        return 0;
+    }
+
+    // one NFA token per rule that has its own kind, otherwise one per literal
+    nfa n;
+    set<int> shortest;
+    for (size_t r = 0; r < spec.token_rules.size(); r++)
+    {
+        string rule = spec.token_rules[r];
+        vector<string> expanding;
+        if (find(shortest_rules.begin(), shortest_rules.end(), rule) != shortest_rules.end())
+            shortest.insert(r);
+
+        if (spec.kinds.count("tk_" + rule) > 0)
+        {
+            n.add_token(rule_parser(spec, expanding).parse(rule), r, "tk_" + rule, "");
+            continue;
+        }
+
+        vector<string> literals = literal_alternatives(spec.rules[rule]);
+        if (literals.empty())
+            spec_error("token rule " + rule + " has no tk_" + rule + " and is not a choice of literals");
+        for (auto &literal : literals)
+        {
+            if (spec.literal_kinds.count(literal) == 0)
+                spec_error("no TokenKind has the comment " + cpp_literal(literal, '\''));
+            rx r_literal { rx::sequence, {}, {} };
+            for (int c : code_points(literal))
+                r_literal.parts.push_back(rx { rx::chars, { { c, c } }, {} });
+            n.add_token(r_literal, r, spec.literal_kinds[literal], literal);
+        }
+    }
+
+    dfa d = subset_construction(n, shortest);
+
+    // literals that an earlier rule also matches can never be accepted, they are found by classify_spelling
+    map<string, vector<pair<string, string>>> keywords;
+    for (size_t t = 0; t < n.tokens.size(); t++)
+    {
+        if (n.tokens[t].literal == "")
+            continue;
+        int state = run(d, n.tokens[t].literal);
+        int accepted = state < 0 ? -1 : d.accepts[state];
+        if (accepted < 0)
+            spec_error("the literal " + cpp_literal(n.tokens[t].literal, '\'') + " can never be matched");
+        if (accepted != (int)t)
+            keywords[n.tokens[accepted].kind].push_back({ n.tokens[t].literal, n.tokens[t].kind });
+    }
+
+    write_header(cout, spec, source, command, minimise(d, n), n, keywords);
+    return 0;
+}
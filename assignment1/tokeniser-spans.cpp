@@ -0,0 +1,499 @@
+// the span tokeniser, it parses the same BNF as tokeniser.cpp but works directly on
+// the input bytes rather than calling read_next_char() for every character
+
+#include "iobuffer.h"
+#include "tokeniser-extras.h"
+#include "tokeniser-spans.h"
+#include "char-runs.h"
+#include "keywords.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// to shorten the code
+using namespace std;
+using namespace CS_IO_Buffers;
+
+namespace Assignment_Tokeniser
+{
+    // read all of standard input
+    span_input::span_input() : mapping(nullptr)
+    {
+        buffer.assign(istreambuf_iterator<char>(cin), istreambuf_iterator<char>());
+        bytes = buffer.data();
+        length = buffer.size();
+    }
+
+    // memory-map the named file, if it cannot be mapped it is read instead
+    span_input::span_input(string path) : mapping(nullptr)
+    {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            fatal_error(0, "Cannot open file: " + path);
+
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0)
+        {
+            void *m = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (m != MAP_FAILED)
+            {
+                mapping = m;
+                bytes = (const char *)m;
+                length = info.st_size;
+            }
+        }
+
+        // empty files and files that cannot be mapped, eg pipes, are read
+        if (mapping == nullptr)
+        {
+            char block[65536];
+            ssize_t n;
+            while ((n = read(fd, block, sizeof(block))) > 0)
+                buffer.append(block, n);
+            bytes = buffer.data();
+            length = buffer.size();
+        }
+        close(fd);
+    }
+
+    span_input::~span_input()
+    {
+        if (mapping != nullptr)
+            munmap(mapping, length);
+    }
+
+    span_tokeniser::span_tokeniser(const span_input &in)
+        : span_tokeniser(in, 0, in.size(), false)
+    {
+    }
+
+    span_tokeniser::span_tokeniser(const span_input &in, int begin, int end, bool in_comment)
+        : input(in.data()), length(end), input_size(in.size()), pos(begin), line(1), line_start(begin),
+          failed(false), resume_comment(in_comment), open_comment(false), value{0, 10, 0, false},
+          missing(cg_token)
+    {
+    }
+
+    // if the next character is in cg move past it and return true
+    bool span_tokeniser::skip_isa(int cg)
+    {
+        if (!char_isa(at(pos), cg))
+            return false;
+        pos++;
+        return true;
+    }
+
+    // move past a UTF-8 encoded greek letter, 0x370 to 0x3FF are 2 bytes and 0x1F00 to 0x1FFF are 3 bytes
+    bool span_tokeniser::skip_greek()
+    {
+        int c0 = at(pos);
+        if ((c0 == 0xCD || c0 == 0xCE || c0 == 0xCF) && (at(pos + 1) & 0xC0) == 0x80)
+        {
+            int ch = ((c0 & 0x1F) << 6) | (at(pos + 1) & 0x3F);
+            if (ch < 0x370)
+                return false;
+            pos += 2;
+            return true;
+        }
+        if (c0 == 0xE1 && (at(pos + 1) & 0xFC) == 0xBC && (at(pos + 2) & 0xC0) == 0x80)
+        {
+            pos += 3;
+            return true;
+        }
+        return false;
+    }
+
+    // the kind of token starting at pos, pos is moved past the token
+    TokenKind span_tokeniser::scan()
+    {
+        int start = pos;
+        int ch = at(pos);
+
+        // * wspace ::= '\t' | '\n' | '\r' | ' '
+        switch (ch)
+        {
+        case EOF:
+            return tk_eoi;
+        case '\t':
+            pos++;
+            return tk_tab;
+        case '\n':
+            pos++;
+            return tk_newline;
+        case '\r':
+            pos++;
+            return tk_carriage_return;
+        case ' ':
+            pos++;
+            return tk_space;
+        }
+
+        // * identifier  ::= ('a'-'z'|'A'-'Z'|'^') id_letter* '?'?
+        if (char_isa(ch, cg_identifier))
+        {
+            pos = skip_run<cg_id_letter>(input + pos + 1, input + length) - input;
+            skip_isa('?');
+
+            // only words starting with a letter are checked for keywords, as classify_spelling() does
+            if (ch == '^')
+                return tk_identifier;
+            return keywords.find(input + start, pos - start, tk_identifier);
+        }
+
+        // * number ::= binary | octal | decimal | hexadecimal
+        // the value is built from the digits as they are scanned
+        if (char_isa(ch, cg_number))
+        {
+            pos++;
+            int digits = cg_dec_digit;
+            int radix = 10;
+            if (ch == '0')
+            {
+                if (at(pos) == 'b' || at(pos) == 'x')
+                {
+                    digits = at(pos) == 'b' ? cg_bin_digit : cg_hex_digit;
+                    radix = at(pos) == 'b' ? 2 : 16;
+                    pos++;
+
+                    // binary and hexadecimal need at least one digit after the 'b' or 'x'
+                    if (!char_isa(at(pos), digits))
+                        return oops(digits);
+                }
+                else if (char_isa(at(pos), cg_oct_digit))
+                {
+                    digits = cg_oct_digit;
+                    radix = 8;
+                }
+                else if (at(pos) != '.')
+                {
+                    value = number_builder(10).result();
+                    return tk_number;
+                }
+            }
+
+            number_builder number(radix);
+            number.digit(ch);
+            for (; char_isa(at(pos), digits); pos++)
+                number.digit(at(pos));
+            if (at(pos) == '.')
+            {
+                pos++;
+                number.point();
+                for (; char_isa(at(pos), digits); pos++)
+                    number.digit(at(pos));
+            }
+            value = number.result();
+            return tk_number;
+        }
+
+        // * string ::= '"' instring* '"'
+        if (ch == '"')
+        {
+            pos++;
+            while (skip_isa(cg_instring) || skip_greek())
+                ;
+            return skip_isa('"') ? tk_string : oops('"');
+        }
+
+        // * symbol ::= '@'|';'|':'|'!='|','|'.'|'=='|'<=>'|'{'|'}'|'('|')'|'['|']'|'/'
+        pos++;
+        switch (ch)
+        {
+        case '@':
+            return tk_at;
+        case ';':
+            return tk_semi;
+        case ':':
+            return tk_colon;
+        case ',':
+            return tk_comma;
+        case '.':
+            return tk_dot;
+        case '{':
+            return tk_lcb;
+        case '}':
+            return tk_rcb;
+        case '(':
+            return tk_lrb;
+        case ')':
+            return tk_rrb;
+        case '[':
+            return tk_lsb;
+        case ']':
+            return tk_rsb;
+        case '!':
+            // classify_spelling() gives a '!' on its own the kind tk_number
+            value = number_builder(10).result();
+            return skip_isa('=') ? tk_ne : tk_number;
+        case '=':
+            return skip_isa('=') ? tk_eq : oops('=');
+        case '<':
+            if (!skip_isa('='))
+                return oops('=');
+            return skip_isa('>') ? tk_spaceship : oops('>');
+        case '/':
+            // * eol_comment  ::= '/' '/' eol_char* '\n'
+            if (skip_isa('/'))
+            {
+                pos = skip_run<cg_eol_char>(input + pos, input + length) - input;
+                return skip_isa('\n') ? tk_eol_comment : oops('\n');
+            }
+
+            // * adhoc_comment  ::= '/' '*' adhoc_char* '*/'
+            if (skip_isa('*'))
+                return scan_adhoc_body();
+            return tk_div;
+        }
+
+        // not a character that can start a token
+        pos = start;
+        return oops(cg_token);
+    }
+
+    // the rest of an adhoc_comment after the '/*'
+    // tokeniser.cpp expects the closing '/' until the body has a '*' followed by another character, then a '*'
+    TokenKind span_tokeniser::scan_adhoc_body()
+    {
+        int expect = '/';
+        while (true)
+        {
+            pos = skip_run<cg_not_star>(input + pos, input + length) - input;
+            if (!skip_isa('*'))
+                break;
+            while (skip_isa('*'))
+                ;
+            if (skip_isa('/'))
+                return tk_adhoc_comment;
+            expect = '/';
+            if (!char_isa(at(pos), cg_not_div))
+                break;
+            expect = '*';
+        }
+
+        // a part of the input that ends inside a comment continues in the next part
+        if (pos == length && length < input_size)
+        {
+            open_comment = true;
+            return tk_adhoc_comment;
+        }
+        return oops(expect);
+    }
+
+    // the next token
+    token_span span_tokeniser::next()
+    {
+        int start = pos;
+        int start_line = line;
+        int start_column = pos - line_start + 1;
+        TokenKind kind = failed ? tk_oops : resume_comment ? scan_adhoc_body() : scan();
+        resume_comment = false;
+
+        // count the lines in the characters that were consumed
+        for (const char *nl = (const char *)memchr(input + start, '\n', pos - start); nl != nullptr;
+             nl = (const char *)memchr(nl + 1, '\n', input + pos - nl - 1))
+        {
+            line++;
+            line_start = nl - input + 1;
+        }
+
+        // the unexpected character is not consumed so every later call returns the same token
+        if (kind == tk_oops)
+        {
+            failed = true;
+            return {tk_oops, pos, 0, line, pos - line_start + 1};
+        }
+        return {kind, start, pos - start, start_line, start_column};
+    }
+
+    // the characters that make up the token t as they appear in the input
+    string span_tokeniser::characters(const token_span &t) const
+    {
+        return string(input + t.offset, t.length);
+    }
+
+    // the spelling of token t after correct_spelling() has been applied
+    string span_tokeniser::spelling(const token_span &t) const
+    {
+        if (t.kind == tk_eoi || t.kind == tk_oops)
+            return "";
+
+        // only the characters that are kept are copied
+        int first, last;
+        spelling_bounds(t.kind, input + t.offset, t.length, first, last);
+        return string(input + t.offset + first, last - first);
+    }
+
+    // tokenise all of input, the number of tokens is estimated from the input size to avoid regrowing the array
+    token_array::token_array(const span_input &in) : tokeniser(in), cursor(0)
+    {
+        tokens.reserve(in.size() / 4 + 1);
+        token_span t = tokeniser.next();
+        tokens.push_back(t);
+        while (t.kind != tk_eoi && t.kind != tk_oops)
+        {
+            if (t.kind == tk_number)
+                numbers.push_back({t.offset, tokeniser.number()});
+            t = tokeniser.next();
+            tokens.push_back(t);
+        }
+        tokens.shrink_to_fit();
+    }
+
+    token_array::token_array(const span_input &in, vector<token_span> all, vector<token_number> values)
+        : tokeniser(in), tokens(move(all)), numbers(move(values)), cursor(0)
+    {
+    }
+
+    // the value of a tk_number token, found by its offset
+    number_value token_array::number(const token_span &t) const
+    {
+        auto found = lower_bound(numbers.begin(), numbers.end(), t.offset,
+                                 [](const token_number &n, int offset) { return n.offset < offset; });
+        if (found == numbers.end() || found->offset != t.offset)
+            return number_builder(10).result();
+        return found->value;
+    }
+
+    // the tokeniser has only been run if the tokens were not read in parallel, a copy is run to the final token
+    int token_array::expected() const
+    {
+        span_tokeniser rescan = tokeniser;
+        token_span t = rescan.next();
+        while (t.kind != tk_eoi && t.kind != tk_oops)
+            t = rescan.next();
+        return rescan.expected();
+    }
+
+    token_array tokenise_all(const span_input &input)
+    {
+        return token_array(input);
+    }
+
+    // the tokens in one chunk of the input, line numbers start at 1 for the chunk's first line
+    struct chunk_tokens
+    {
+        vector<token_span> tokens;      // the tokens, a tk_eoi token is only included for the last chunk
+        vector<token_number> numbers;   // the values of the tk_number tokens
+        bool open;                      // true if the last token is an adhoc_comment that continues in the next chunk
+    };
+
+    // tokenise the chunk from begin to end, starting inside or outside of an adhoc_comment
+    static chunk_tokens tokenise_chunk(const span_input &input, int begin, int end, bool in_comment)
+    {
+        span_tokeniser tokeniser(input, begin, end, in_comment);
+        chunk_tokens chunk = {{}, {}, false};
+        chunk.tokens.reserve((end - begin) / 4 + 1);
+        while (true)
+        {
+            token_span t = tokeniser.next();
+            if (t.kind == tk_eoi && end < input.size())
+                break;
+            chunk.tokens.push_back(t);
+            if (t.kind == tk_eoi || t.kind == tk_oops)
+                break;
+            if (t.kind == tk_number)
+                chunk.numbers.push_back({t.offset, tokeniser.number()});
+            if (tokeniser.in_open_comment())
+            {
+                chunk.open = true;
+                break;
+            }
+        }
+        return chunk;
+    }
+
+    // tokenise all of input using up to threads threads
+    token_array tokenise_all_parallel(const span_input &input, int threads)
+    {
+        const char *data = input.data();
+        int size = input.size();
+        if (threads <= 0)
+            threads = max(1u, thread::hardware_concurrency());
+
+        // split the input into chunks that each start at the beginning of a line
+        vector<int> starts = {0};
+        for (int i = 1; i < threads; i++)
+        {
+            int split = (int)((long)size * i / threads);
+            if (split <= starts.back())
+                continue;
+            const char *nl = (const char *)memchr(data + split - 1, '\n', size - split + 1);
+            if (nl == nullptr || nl - data + 1 >= size)
+                break;
+            if (nl - data + 1 > starts.back())
+                starts.push_back(nl - data + 1);
+        }
+        starts.push_back(size);
+        int nchunks = starts.size() - 1;
+        if (nchunks == 1)
+            return tokenise_all(input);
+
+        // tokenise every chunk both ways in parallel, the first chunk can only start outside of a comment
+        vector<chunk_tokens> outside(nchunks), inside(nchunks);
+        vector<int> newlines(nchunks);
+        vector<thread> workers;
+        for (int c = 0; c < nchunks; c++)
+        {
+            workers.emplace_back([&, c]()
+            {
+                outside[c] = tokenise_chunk(input, starts[c], starts[c + 1], false);
+                if (c > 0)
+                    inside[c] = tokenise_chunk(input, starts[c], starts[c + 1], true);
+                newlines[c] = count(data + starts[c], data + starts[c + 1], '\n');
+            });
+        }
+        for (auto &worker : workers)
+            worker.join();
+
+        // join the chunks using the result that matches how the previous chunk ended
+        vector<token_span> tokens;
+        vector<token_number> numbers;
+        size_t total = 0;
+        for (int c = 0; c < nchunks; c++)
+            total += outside[c].tokens.size();
+        tokens.reserve(total);
+
+        bool in_comment = false;
+        token_span comment = {};        // the adhoc_comment that continues into the next chunk
+        int lines_before = 0;
+        for (int c = 0; c < nchunks; c++)
+        {
+            chunk_tokens &chunk = in_comment ? inside[c] : outside[c];
+            numbers.insert(numbers.end(), chunk.numbers.begin(), chunk.numbers.end());
+            int n = chunk.tokens.size();
+            for (int i = 0; i < n; i++)
+            {
+                token_span t = chunk.tokens[i];
+                t.line += lines_before;
+
+                // the first token of an inside chunk is the rest of the comment, unless it is an error
+                if (in_comment && i == 0 && t.kind != tk_oops)
+                {
+                    if (chunk.open && n == 1)
+                        break;
+                    comment.length = t.offset + t.length - comment.offset;
+                    tokens.push_back(comment);
+                    in_comment = false;
+                    continue;
+                }
+
+                if (chunk.open && i == n - 1)
+                {
+                    comment = t;
+                    in_comment = true;
+                    break;
+                }
+
+                tokens.push_back(t);
+                if (t.kind == tk_oops)
+                    return token_array(input, move(tokens), move(numbers));
+            }
+            lines_before += newlines[c];
+        }
+        return token_array(input, move(tokens), move(numbers));
+    }
+}
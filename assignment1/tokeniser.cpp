@@ -16,43 +16,25 @@ namespace Assignment_Tokeniser
     // * wspace ::= '\t' | '\n' | '\r' | ' '
     static void parse_wspace()
     {
-        if (next_char_isa(cg_wspace))
-            next_char_mustbe(cg_wspace);
-        else
-            did_not_find_char(cg_wspace);
-    }
-
-    //   - id_letter ::= 'a'-'z'|'A'-'Z'|'0'-'9'|'_'|'$'|'.'
-    static void parse_id_letter()
-    {
-        if (next_char_isa(cg_id_letter))
-            next_char_mustbe(cg_id_letter);
+        next_char_mustbe(cg_wspace);
     }
 
     // * identifier  ::= ('a'-'z'|'A'-'Z'|'^') id_letter* '?'?
     static void parse_identifier()
     {
-        if (next_char_isa(cg_identifier))
-            next_char_mustbe(cg_identifier);
+        next_char_mustbe(cg_identifier);
         while (next_char_isa(cg_id_letter))
-            parse_id_letter();
+            read_next_char();
         if (next_char_isa('?'))
             next_char_mustbe('?');
     }
 
-    //   - bin_digit    ::= '0' | '1'
-    static void parse_bin_digit()
-    {   
-        if(next_char_isa(cg_bin_digit))
-            next_char_mustbe(cg_bin_digit);
-    }
-
     //   - bin_fraction ::= '.' bin_digit*
     static void parse_bin_fraction()
     {
         next_char_mustbe('.');
         while (next_char_isa(cg_bin_digit))
-            next_char_mustbe(cg_bin_digit);
+            read_next_char();
     }
 
     //   - binary       ::= '0' 'b' bin_digit+ bin_fraction?
@@ -61,7 +43,7 @@ namespace Assignment_Tokeniser
         next_char_mustbe('b');
         next_char_mustbe(cg_bin_digit);
         while (next_char_isa(cg_bin_digit))
-            parse_bin_digit();
+            read_next_char();
         if (next_char_isa(cg_bin_fraction))
             parse_bin_fraction();
     }
@@ -71,7 +53,7 @@ namespace Assignment_Tokeniser
     {
         next_char_mustbe('.');
         while (next_char_isa(cg_oct_digit))
-            next_char_mustbe(cg_oct_digit);
+            read_next_char();
     }
 
     //   - octal        ::= '0' oct_digit+ oct_fraction?
@@ -79,7 +61,7 @@ namespace Assignment_Tokeniser
     {   
         next_char_mustbe(cg_oct_digit);
         while (next_char_isa(cg_oct_digit))
-            next_char_mustbe(cg_oct_digit);
+            read_next_char();
         if (next_char_isa(cg_oct_fraction))
             parse_oct_fraction();
     }
@@ -89,7 +71,7 @@ namespace Assignment_Tokeniser
     {
         next_char_mustbe(cg_decimal19);
         while (next_char_isa(cg_dec_digit))
-            next_char_mustbe(cg_dec_digit);
+            read_next_char();
     }
 
     //   - dec_fraction ::= '.' dec_digit*
@@ -97,7 +79,7 @@ namespace Assignment_Tokeniser
     {
         next_char_mustbe('.');
         while (next_char_isa(cg_dec_digit))
-            next_char_mustbe(cg_dec_digit);
+            read_next_char();
     }
 
     //   - decimal      ::= ('0' | decimal19) dec_fraction?
@@ -108,19 +90,12 @@ namespace Assignment_Tokeniser
             parse_dec_fraction();
     }
 
-    //   - hex_digit    ::= '0'-'9'|'A'-'F'
-    static void parse_hex_digit()
-    {   
-        if(next_char_isa(cg_hex_digit))
-            next_char_mustbe(cg_hex_digit);
-    }
-
     //   - hex_fraction ::= '.' hex_digit*
     static void parse_hex_fraction()
     {
         next_char_mustbe('.');
         while (next_char_isa(cg_hex_digit))
-            next_char_mustbe(cg_hex_digit);
+            read_next_char();
     }
 
     //   - hexadecimal  ::= '0' 'x' hex_digit+ hex_fraction?
@@ -129,7 +104,7 @@ namespace Assignment_Tokeniser
         next_char_mustbe('x');
         next_char_mustbe(cg_hex_digit);
         while (next_char_isa(cg_hex_digit))
-            parse_hex_digit();
+            read_next_char();
         if (next_char_isa(cg_hex_fraction))
             parse_hex_fraction();
     }
@@ -139,7 +114,7 @@ namespace Assignment_Tokeniser
     {
         next_char_mustbe('"');
         while (next_char_isa(cg_instring))
-            next_char_mustbe(cg_instring);
+            read_next_char();
         next_char_mustbe('"');
     }
 
@@ -148,10 +123,10 @@ namespace Assignment_Tokeniser
     {
         next_char_mustbe(cg_not_div);
         while (next_char_isa(cg_not_star))
-            next_char_mustbe(cg_not_star);
+            read_next_char();
         next_char_mustbe('*');
         while (next_char_isa('*'))
-            next_char_mustbe('*');
+            read_next_char();
     }
 
     //   - adhoc_suffix ::= '*' adhoc_char* '*/'
@@ -159,9 +134,9 @@ namespace Assignment_Tokeniser
     {
         next_char_mustbe('*');
         while (next_char_isa(cg_not_star))
-            next_char_mustbe(cg_not_star);
+            read_next_char();
         while (next_char_isa('*'))
-            next_char_mustbe('*');
+            read_next_char();
         while (next_char_isa(cg_not_div))
             parse_adhoc_suffix_extra();
         next_char_mustbe('/');
@@ -202,7 +177,7 @@ namespace Assignment_Tokeniser
             {
                 next_char_mustbe('/');
                 while (next_char_isa(cg_eol_char))
-                    next_char_mustbe(cg_eol_char);
+                    read_next_char();
                 next_char_mustbe('\n');
             }
             else if (next_char_isa('*'))
@@ -0,0 +1,157 @@
+// convert Text into Tokens using the generated DFA in includes/tokeniser-dfa.h
+// the output and errors are the same as tokens but the whole input is read at once
+// usage: tokens-dfa [file], standard input is read if no file is given or file is -
+#include "tokeniser-dfa.h"
+#include "tokeniser-extras.h"
+#include "iobuffer.h"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+using namespace std ;
+using namespace CS_IO_Buffers ;
+using namespace Assignment_Tokeniser ;
+
+// the spelling with control characters escaped as they are by to_string(Token)
+static string escape(string spelling)
+{
+    string escaped ;
+    for ( char ch : spelling )
+    {
+        switch(ch)
+        {
+        case '\n': escaped += "\\n" ; break ;
+        case '\r': escaped += "\\r" ; break ;
+        case '\t': escaped += "\\t" ; break ;
+        default:   escaped += ch ;    break ;
+        }
+    }
+    return escaped ;
+}
+
+// the spelling of a character in an error message, a '"' is escaped as well
+static string quoted(string characters)
+{
+    return characters == "\"" ? "\\\"" : escape(characters) ;
+}
+
+// the description of the character or character group that tokens reports as not found
+static string describe_expected(int expected)
+{
+    switch(expected)
+    {
+    case cg_token:      return "a character that can start a token" ;
+    case cg_bin_digit:  return "one of '0' to '1'" ;
+    case cg_hex_digit:  return "one of '0' to '9' or 'A' to 'F'" ;
+    default:            return quoted(string(1,(char)expected)) ;
+    }
+}
+
+// the UTF-8 encoded character at offset in the input or EOF
+static string found_at(const string &input,int offset)
+{
+    if ( offset >= (int)input.size() ) return "EOF" ;
+
+    unsigned char first = input[offset] ;
+    int length = first < 0xC0 ? 1 : first < 0xE0 ? 2 : first < 0xF0 ? 3 : 4 ;
+    return quoted(input.substr(offset,length)) ;
+}
+
+// run the DFA from the start of the n bytes at p until it stops, the state it stopped in is returned in state,
+// like tokens the DFA never backs up so a token only ends where no more characters can be added to it
+static int dfa_stop(const char *p,int n,int &state)
+{
+    int i = 0 ;
+    state = 0 ;
+    for ( int size ; i < n ; i += size )
+    {
+        int next = dfa_next[state][dfa_char_class(dfa_decode(p + i,n - i,size))] ;
+        if ( next < 0 ) break ;
+        state = next ;
+    }
+    return i ;
+}
+
+// the character or character group that tokens expects after the DFA stopped in a state that does not accept,
+// this is the ASCII characters that complete a token or, if there are none, the characters that continue one
+static int dfa_expected(int state)
+{
+    if ( state == 0 ) return cg_token ;
+
+    string completes, continues ;
+    for ( int ch = 0 ; ch < 128 ; ch++ )
+    {
+        int next = dfa_next[state][dfa_ascii_class[ch]] ;
+        if ( next < 0 ) continue ;
+        continues += (char)ch ;
+        if ( dfa_accepts[next] != tk_oops ) completes += (char)ch ;
+    }
+    string expected = completes != "" ? completes : continues ;
+    if ( expected.size() == 1 ) return expected[0] ;
+
+    for ( int cg : { cg_bin_digit, cg_hex_digit } )
+    {
+        string group ;
+        for ( int ch = 0 ; ch < 128 ; ch++ )
+        {
+            if ( char_isa(ch,cg) ) group += (char)ch ;
+        }
+        if ( expected == group ) return cg ;
+    }
+    return cg_token ;
+}
+
+// this main program tokenises a file or standard input and
+// prints the tokens in the same format as tokens
+int main(int argc,char **argv)
+{
+    int count = 0 ;
+
+    // configure io buffers to output immediately
+    config_output(iob_immediate) ;
+    config_errors(iob_immediate) ;
+
+    string input ;
+    if ( argc > 1 && string(argv[1]) != "-" )
+    {
+        ifstream file(argv[1],ios::binary) ;
+        input.assign(istreambuf_iterator<char>(file),istreambuf_iterator<char>()) ;
+    }
+    else
+    {
+        input.assign(istreambuf_iterator<char>(cin),istreambuf_iterator<char>()) ;
+    }
+
+    // display each token
+    int offset = 0, size = input.size(), state = 0, stop = 0 ;
+    while ( offset < size )
+    {
+        TokenKind kind ;
+        int length = dfa_scan(input.data() + offset,size - offset,kind) ;
+
+        // the DFA went past the longest token or found none
+        stop = dfa_stop(input.data() + offset,size - offset,state) ;
+        if ( length == 0 || stop != length ) break ;
+
+        kind = dfa_classify_spelling(kind,input.data() + offset,length) ;
+        string spelling = input.substr(offset,length) ;
+        spelling = kind == tk_number ? correct_spelling(kind,spelling) : dfa_correct_spelling(kind,spelling) ;
+        write_to_output("{kind: " + to_string(kind) + ", spelling: \"" + escape(spelling) + "\"}\n") ;
+        count++ ;
+        offset += length ;
+    }
+    write_to_output("Read " + to_string(count) + " tokens\n") ;
+
+    // the error tokens reports when did_not_find_char() is called
+    if ( offset < size )
+    {
+        write_to_errors("***** Fatal error!\nExpected: \"" + describe_expected(dfa_expected(state)) +
+                        "\" but found: \"" + found_at(input,offset + stop) + "\"\n") ;
+    }
+
+    // flush output - the test scripts disable unbuffered output
+    print_output() ;
+    print_errors() ;
+
+    return 0 ;
+}
@@ -0,0 +1,110 @@
+// convert Text into Tokens using the span tokeniser
+// the output and errors are the same as tokens but the whole input is read at once
+// usage: tokens-spans [-p threads] [file], standard input is read if no file is given or file is -
+// -p tokenises the input in parallel using up to threads threads, 0 means one per hardware thread,
+// it can also be written as -pthreads, eg -p4, so that tests.csv does not need a space in its arguments
+#include "tokeniser-spans.h"
+#include "iobuffer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+
+using namespace std ;
+using namespace CS_IO_Buffers ;
+using namespace Assignment_Tokeniser ;
+
+// the spelling with control characters escaped as they are by to_string(Token)
+static string escape(string spelling)
+{
+    string escaped ;
+    for ( char ch : spelling )
+    {
+        switch(ch)
+        {
+        case '\n': escaped += "\\n" ; break ;
+        case '\r': escaped += "\\r" ; break ;
+        case '\t': escaped += "\\t" ; break ;
+        default:   escaped += ch ;    break ;
+        }
+    }
+    return escaped ;
+}
+
+// the spelling of a character in an error message, a '"' is escaped as well
+static string quoted(string characters)
+{
+    return characters == "\"" ? "\\\"" : escape(characters) ;
+}
+
+// the description of the character or character group that tokens reports as not found
+static string describe_expected(int expected)
+{
+    switch(expected)
+    {
+    case cg_token:      return "a character that can start a token" ;
+    case cg_bin_digit:  return "one of '0' to '1'" ;
+    case cg_hex_digit:  return "one of '0' to '9' or 'A' to 'F'" ;
+    default:            return quoted(string(1,(char)expected)) ;
+    }
+}
+
+// the UTF-8 encoded character at offset in the input or EOF
+static string found_at(const span_input &input,int offset)
+{
+    if ( offset >= input.size() ) return "EOF" ;
+
+    unsigned char first = input.data()[offset] ;
+    int length = first < 0xC0 ? 1 : first < 0xE0 ? 2 : first < 0xF0 ? 3 : 4 ;
+    return quoted(string(input.data() + offset,min(length,input.size() - offset))) ;
+}
+
+// this main program tokenises a file or standard input and
+// prints the tokens in the same format as tokens
+int main(int argc,char **argv)
+{
+    int count = 0 ;
+
+    // configure io buffers to output immediately
+    config_output(iob_immediate) ;
+    config_errors(iob_immediate) ;
+
+    // -pN or -p N
+    bool parallel = argc > 1 && string(argv[1]).compare(0,2,"-p") == 0 ;
+    int threads = 0 ;
+    if ( parallel )
+    {
+        const char *n = argv[1] + 2 ;
+        int used = 1 ;
+        if ( *n == '\0' && argc > 2 ) { n = argv[2] ; used = 2 ; }
+        threads = atoi(n) ;
+        argc -= used ; argv += used ;
+    }
+
+    bool from_file = argc > 1 && string(argv[1]) != "-" ;
+    unique_ptr<span_input> input(from_file ? new span_input(argv[1]) : new span_input()) ;
+    token_array tokens = parallel ? tokenise_all_parallel(*input,threads) : tokenise_all(*input) ;
+
+    // display each token
+    token_span token = tokens.current() ;
+    while ( token.kind != tk_eoi && token.kind != tk_oops )
+    {
+        write_to_output("{kind: " + to_string(token.kind) + ", spelling: \"" + escape(tokens.spelling(token)) + "\"}\n") ;
+        count++ ;
+        tokens.next() ;
+        token = tokens.current() ;
+    }
+    write_to_output("Read " + to_string(count) + " tokens\n") ;
+
+    // the error tokens reports when did_not_find_char() is called
+    if ( token.kind == tk_oops )
+    {
+        write_to_errors("***** Fatal error!\nExpected: \"" + describe_expected(tokens.expected()) +
+                        "\" but found: \"" + found_at(*input,token.offset) + "\"\n") ;
+    }
+
+    // flush output - the test scripts disable unbuffered output
+    print_output() ;
+    print_errors() ;
+
+    return 0 ;
+}
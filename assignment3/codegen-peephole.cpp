@@ -0,0 +1,424 @@
+//AUTHOR: MONG YUAN SIM A1808469
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "iobuffer.h"
+#include "jackc.h"
+
+// to shorten our code:
+using namespace std;
+using namespace CS_IO_Buffers;
+using namespace Jack_Compiler;
+
+// peephole optimisation of the VM code written by codegen
+//
+// codegen writes each subroutine's VM code to a string, one command per line, and if any rules are selected
+// it passes the string to jack_peephole() before writing it to the output. Each rule in the rule table has a
+// pattern of commands and the commands to replace them with:
+//
+// . the commands are read in order onto the end of a window, after each command every selected rule's pattern
+//   is compared with the end of the window and the first one that matches is replaced
+// . the replacement commands are read again as if they were the next commands of the input, so one
+//   replacement can make another one possible, eg folding 1 + 2 + 3 folds 1 + 2 first then 3 + 3
+// . $a, $b and $c in a pattern match any word, the same variable must match the same word every time
+// . a rule with a compute function can only be used if it returns true, it can check the words matched
+//   or set $c from $a and $b
+// . several rules can have the same name, they are selected and counted together
+//
+// The rules are selected by the environment variable JACK_PEEPHOLE, eg JACK_PEEPHOLE=all or
+// JACK_PEEPHOLE=not-not,branch, unless jack_peephole_rules() is called, jackc calls it for its --peephole option.
+// If no rules are selected the VM code is not changed, this is the default so codegen matches the tests.
+//
+// If the environment variable JACK_PEEPHOLE_STATS is set the number of times each rule was used is written
+// to std::cerr when the program exits, like JACK_AST_STATS this is for compiling a single class.
+
+namespace
+{
+
+// the words matched by a pattern's variables, bound[0] is $a, bound[1] is $b and bound[2] is $c
+typedef vector<string> bindings;
+
+// a VM command split into words, eg push constant 7 is { "push", "constant", "7" }
+typedef vector<string> command;
+
+// the value of a push constant word, constants are always 0 to 32767
+int constant(const string &word)
+{
+    return atoi(word.c_str());
+}
+
+// true if $c is a command that leaves true or false on the stack
+bool is_comparison(bindings &bound)
+{
+    return bound[2] == "lt" || bound[2] == "gt" || bound[2] == "eq";
+}
+
+// set $c to the result of a folded operation if it can be pushed as a constant
+bool set_constant(bindings &bound, int value)
+{
+    if (value < 0 || value > 32767)
+    {
+        return false;
+    }
+    bound[2] = to_string(value);
+    return true;
+}
+
+bool fold_add(bindings &bound)
+{
+    return set_constant(bound, constant(bound[0]) + constant(bound[1]));
+}
+
+bool fold_sub(bindings &bound)
+{
+    return set_constant(bound, constant(bound[0]) - constant(bound[1]));
+}
+
+bool fold_and(bindings &bound)
+{
+    return set_constant(bound, constant(bound[0]) & constant(bound[1]));
+}
+
+bool fold_or(bindings &bound)
+{
+    return set_constant(bound, constant(bound[0]) | constant(bound[1]));
+}
+
+// a peephole rule
+struct peephole_rule
+{
+    string name;                        // the name used to select the rule
+    vector<string> pattern;             // the commands to match
+    vector<string> replacement;         // the commands to replace them with
+    bool (*compute)(bindings &bound);   // nullptr or returns false if the rule cannot be used
+};
+
+// the rule table, the rules are tried in this order
+const vector<peephole_rule> rules =
+{
+    // arithmetic on two constants, the result must be a constant that can be pushed
+    { "fold-add", { "push constant $a", "push constant $b", "add" }, { "push constant $c" }, fold_add },
+    { "fold-sub", { "push constant $a", "push constant $b", "sub" }, { "push constant $c" }, fold_sub },
+    { "fold-and", { "push constant $a", "push constant $b", "and" }, { "push constant $c" }, fold_and },
+    { "fold-or", { "push constant $a", "push constant $b", "or" }, { "push constant $c" }, fold_or },
+
+    // ~~x is x, eg a while loop's condition is negated and ~ conditions are common
+    { "not-not", { "not", "not" }, {}, nullptr },
+
+    // let x = x ;
+    { "push-pop", { "push $a $b", "pop $a $b" }, {}, nullptr },
+
+    // the if-goto, goto, label sequence written for every if statement, negating the condition only reverses
+    // the jump if the condition is true or false, eg ~5 is not 0, so it must have just been made by a comparison
+    { "branch", { "$c", "if-goto $a", "goto $b", "label $a" }, { "$c", "not", "if-goto $b", "label $a" }, is_comparison },
+    { "branch", { "$c", "not", "if-goto $a", "goto $b", "label $a" }, { "$c", "if-goto $b", "label $a" }, is_comparison },
+
+    // conditions that are false or true, eg while (true) or if (false)
+    { "never-taken", { "push constant 0", "if-goto $a" }, {}, nullptr },
+    { "always-taken", { "push constant 0", "not", "if-goto $a" }, { "goto $a" }, nullptr },
+
+    // a goto that cannot be reached or that jumps to the next command
+    { "dead-goto", { "goto $a", "goto $b" }, { "goto $a" }, nullptr },
+    { "goto-next", { "goto $a", "label $a" }, { "label $a" }, nullptr },
+};
+
+// the number of times each rule has been used, subroutines are optimised in parallel
+// one counter per rule in the table, it is constructed after the table
+vector<atomic<long>> hits(rules.size());
+
+// the words of a line of VM code
+command split(const string &line)
+{
+    command words;
+    size_t start = 0;
+    while (start < line.size())
+    {
+        size_t end = line.find(' ', start);
+        if (end == string::npos)
+        {
+            end = line.size();
+        }
+        if (end > start)
+        {
+            words.push_back(line.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return words;
+}
+
+// a rule's pattern and replacement split into words, they are split once when first used
+struct compiled_rule
+{
+    vector<command> pattern;
+    vector<command> replacement;
+};
+
+const vector<compiled_rule> &compiled_rules()
+{
+    static const vector<compiled_rule> compiled = []()
+    {
+        vector<compiled_rule> all;
+        for (auto &rule : rules)
+        {
+            compiled_rule c;
+            for (auto &line : rule.pattern)
+            {
+                c.pattern.push_back(split(line));
+            }
+            for (auto &line : rule.replacement)
+            {
+                c.replacement.push_back(split(line));
+            }
+            all.push_back(c);
+        }
+        return all;
+    }();
+    return compiled;
+}
+
+// true if a word is a pattern variable, $a to $c
+bool is_variable(const string &word)
+{
+    return word.size() == 2 && word[0] == '$' && word[1] >= 'a' && word[1] <= 'c';
+}
+
+// true if the end of the window matches the pattern, the variables it matches are recorded in bound
+bool match(const vector<command> &window, const vector<command> &pattern, bindings &bound)
+{
+    if (pattern.size() > window.size())
+    {
+        return false;
+    }
+
+    bound.assign(3, "");
+    size_t first = window.size() - pattern.size();
+    for (size_t i = 0; i < pattern.size(); i++)
+    {
+        const command &c = window[first + i];
+        const command &p = pattern[i];
+        if (c.size() != p.size())
+        {
+            return false;
+        }
+        for (size_t w = 0; w < p.size(); w++)
+        {
+            if (!is_variable(p[w]))
+            {
+                if (p[w] != c[w])
+                {
+                    return false;
+                }
+                continue;
+            }
+
+            string &value = bound[p[w][1] - 'a'];
+            if (value == "")
+            {
+                value = c[w];
+            }
+            else if (value != c[w])
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// the rules selected by the environment variable JACK_PEEPHOLE
+vector<bool> selected_from_environment();
+
+// write the number of times each selected rule was used to std::cerr
+void report();
+
+// the selected rules, one entry per rule in the table
+// the report is registered after on is created so that it runs before on is destroyed
+vector<bool> &selected()
+{
+    static vector<bool> on = selected_from_environment();
+    static bool reporting = getenv("JACK_PEEPHOLE_STATS") != nullptr && atexit(report) == 0;
+    (void)reporting;
+    return on;
+}
+
+// true if at least one rule is selected
+bool any_selected()
+{
+    for (bool on : selected())
+    {
+        if (on)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void report()
+{
+    for (size_t r = 0; r < rules.size(); r++)
+    {
+        if (!selected()[r] || (r > 0 && rules[r - 1].name == rules[r].name))
+        {
+            continue;
+        }
+
+        // rules with the same name are next to each other in the table
+        long total = 0;
+        for (size_t same = r; same < rules.size() && rules[same].name == rules[r].name; same++)
+        {
+            total += hits[same];
+        }
+        cerr << "peephole " << rules[r].name << ": " << total << " hits\n";
+    }
+}
+
+// select the rules named in a comma separated list, "all" selects every rule and "" selects none,
+// returns false and selects none if a name is not in the rule table
+bool select_rules(string names, vector<bool> &on)
+{
+    on.assign(rules.size(), names == "all");
+    if (names == "all" || names == "")
+    {
+        return true;
+    }
+
+    size_t start = 0;
+    while (start <= names.size())
+    {
+        size_t end = names.find(',', start);
+        if (end == string::npos)
+        {
+            end = names.size();
+        }
+        string name = names.substr(start, end - start);
+
+        bool found = false;
+        for (size_t r = 0; r < rules.size(); r++)
+        {
+            if (rules[r].name == name)
+            {
+                on[r] = true;
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            on.assign(rules.size(), false);
+            return false;
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+vector<bool> selected_from_environment()
+{
+    vector<bool> on;
+    const char *names = getenv("JACK_PEEPHOLE");
+    if (names != nullptr && !select_rules(names, on))
+    {
+        fatal_error(0, "JACK_PEEPHOLE names an unknown peephole rule: " + string(names));
+    }
+    if (on.empty())
+    {
+        on.assign(rules.size(), false);
+    }
+    return on;
+}
+
+} // namespace
+
+// select the peephole rules named in a comma separated list, "all" selects every rule and "" selects none
+bool Jack_Compiler::jack_peephole_rules(string names)
+{
+    return select_rules(names, selected());
+}
+
+// true if any peephole rule is selected
+bool Jack_Compiler::jack_peephole_selected()
+{
+    return any_selected();
+}
+
+// apply the selected peephole rules to the VM code of a subroutine
+string Jack_Compiler::jack_peephole(string vm)
+{
+    if (!any_selected())
+    {
+        return vm;
+    }
+
+    const vector<compiled_rule> &table = compiled_rules();
+
+    // the input is read from the back of a stack so replacements can be pushed back onto it
+    vector<command> input;
+    size_t start = 0;
+    while (start < vm.size())
+    {
+        size_t end = vm.find('\n', start);
+        if (end == string::npos)
+        {
+            end = vm.size();
+        }
+        command c = split(vm.substr(start, end - start));
+        if (!c.empty())
+        {
+            input.push_back(c);
+        }
+        start = end + 1;
+    }
+    reverse(input.begin(), input.end());
+
+    vector<command> window;
+    bindings bound;
+    while (!input.empty())
+    {
+        window.push_back(input.back());
+        input.pop_back();
+
+        for (size_t r = 0; r < table.size(); r++)
+        {
+            if (!selected()[r] || !match(window, table[r].pattern, bound))
+            {
+                continue;
+            }
+            if (rules[r].compute != nullptr && !rules[r].compute(bound))
+            {
+                continue;
+            }
+
+            window.resize(window.size() - table[r].pattern.size());
+            for (size_t i = table[r].replacement.size(); i > 0; i--)
+            {
+                command c = table[r].replacement[i - 1];
+                for (auto &word : c)
+                {
+                    if (is_variable(word))
+                    {
+                        word = bound[word[1] - 'a'];
+                    }
+                }
+                input.push_back(c);
+            }
+            hits[r]++;
+            break;
+        }
+    }
+
+    string optimised;
+    for (auto &c : window)
+    {
+        for (size_t w = 0; w < c.size(); w++)
+        {
+            optimised += (w == 0 ? "" : " ") + c[w];
+        }
+        optimised += "\n";
+    }
+    return optimised;
+}
@@ -1,14 +1,25 @@
 //AUTHOR: MONG YUAN SIM A1808469
 
+#include <cstdlib>
 #include "iobuffer.h"
 #include "symbols.h"
 #include "abstract-syntax-tree.h"
+#include "jackc.h"
+#include "ast-stats.h"
+#include "work-pool.h"
+#include "jack-index.h"
+#include "ast-analysis.h"
+#include "ast-visitor.h"
 
 // to shorten our code:
 using namespace std;
 using namespace CS_IO_Buffers;
 using namespace Jack_Compiler;
 
+// the pass is private to this file, jackc calls it through the entry point declared in jackc.h
+namespace
+{
+
 // ***** WHAT TO DO *****
 //
 // MODIFY the skeleton code below to walk an abstract syntax tree, ast, of a Jack class
@@ -25,56 +36,287 @@ using namespace Jack_Compiler;
 //  - you may want to change the parameters / results to suit your own logic
 //  - you can change it as much as you like
 
+// the label counters start from 0 in every subroutine
 static int this_counter = 0;
 static int if_counter = 0;
 static int while_counter = 0;
 static string myclassname;
 static string type;
 
-// forward declarations of one function per node in the abstract syntax tree
-void walk_class(ast t);
-void walk_class_var_decs(ast t);
-void walk_var_dec(ast t);
-void walk_subr_decs(ast t);
-void walk_subr(ast t);
-void walk_constructor(ast t);
-void walk_function(ast t);
-void walk_method(ast t);
-void walk_param_list(ast t);
-void walk_subr_body(ast t);
-void walk_var_decs(ast t);
-void walk_statements(ast t);
-void walk_statement(ast t);
-void walk_let(ast t);
-void walk_let_array(ast t);
-void walk_if(ast t);
-void walk_if_else(ast t);
-void walk_while(ast t);
-void walk_do(ast t);
-void walk_return(ast t);
-void walk_return_expr(ast t);
-void walk_expr(ast t);
-void walk_term(ast t);
-void walk_int(ast t);
-void walk_string(ast t);
-void walk_bool(ast t);
-void walk_null(ast t);
-void walk_this(ast t);
-void walk_unary_op(ast t);
-void walk_var(ast t);
-void walk_array_index(ast t);
-void walk_call_as_function(ast t);
-void walk_call_as_method(ast t);
-void walk_subr_call(ast t, string name, string type);
-void walk_expr_list(ast t);
-void walk_infix_op(ast t);
+// the VM code for the subroutine being walked
+static string *subr_output = nullptr;
+
+// append VM code to the current subroutine's output or write it directly if not walking a subroutine
+static void emit(string code)
+{
+    if (subr_output != nullptr)
+    {
+        *subr_output += code;
+    }
+    else
+    {
+        write_to_output(code);
+    }
+}
+
+// ***** strength reduction *****
+//
+// multiplying or dividing by an int constant can be done without calling Math.multiply or Math.divide
+// . x * c is replaced by doubling and adding x, eg x * 10 is ((x + x) * 2 + x) * 2, c * x is treated as x * c
+// . c is any term with a constant value in ast-analysis.h, eg x * -4 is x * 4 followed by neg
+// . x / 2^k is replaced by a call of a helper function written at the end of the class, <class>.divide$pow2,
+//   it shifts x right by counting over its bits once instead of Math.divide's repeated calls
+// . a cost model chooses between the call and the replacement, see strength_reduce()
+// . it is off by default so the output matches the tests, it is turned on by the environment variable
+//   JACK_STRENGTH_REDUCTION or by calling jack_strength_reduction(), jackc --strength-reduce does this
+//
+// the multiplication uses temp 1 and temp 2 and the result is left on the stack, they are not used across a call
+
+static bool &strength_reduction_on()
+{
+    static bool on = getenv("JACK_STRENGTH_REDUCTION") != nullptr;
+    return on;
+}
+
+// the cost model, costs are in VM commands
+// . one VM command is translated into about vm_command_size Hack instructions
+// . a call of Math.multiply runs about multiply_call_time commands and Math.divide about divide_call_time
+// . the divide helper runs about divide_helper_time commands plus divide_helper_step for each bit it shifts
+// . code inside a while loop is assumed to run loop_runs times for each level of nesting
+// the cost of some code is its size in Hack instructions plus the number of VM commands it runs
+static const int vm_command_size = 10;
+static const int multiply_call_time = 300;
+static const int divide_call_time = 600;
+static const int divide_helper_time = 40;
+static const int divide_helper_step = 25;
+static const int loop_runs = 10;
+
+// the while loop nesting depth of the code being walked
+static int loop_depth = 0;
+
+// true if a subroutine has called the divide helper so it must be written at the end of the class
+static bool divide_helper_used = false;
+
+// the number of times code at the current loop depth is assumed to run
+static int runs_per_call()
+{
+    int runs = 1;
+    for (int depth = 0; depth < loop_depth && depth < 4; depth++)
+    {
+        runs *= loop_runs;
+    }
+    return runs;
+}
+
+// the cost of code with the given number of VM commands that runs the given number of VM commands
+static int cost_of(int size, int time)
+{
+    return size * vm_command_size + runs_per_call() * time;
+}
+
+// the number of lines in some VM code
+static int vm_lines(const string &code)
+{
+    int n = 0;
+    for (char c : code)
+    {
+        if (c == '\n')
+        {
+            n++;
+        }
+    }
+    return n;
+}
+
+// VM code that multiplies the value on the top of the stack by c, c > 0, by doubling and adding
+// the value is saved in temp 1 and the partial product is doubled using temp 2
+static string multiply_sequence(int c)
+{
+    if (c == 1)
+    {
+        return "";
+    }
+
+    int top = 14;
+    while ((c >> top) == 0)
+    {
+        top--;
+    }
+
+    // the first doubling adds x to itself so it does not need temp 2
+    string code = "pop temp 1\npush temp 1\n";
+    for (int bit = top - 1; bit >= 0; bit--)
+    {
+        code += bit == top - 1 ? "push temp 1\nadd\n" : "pop temp 2\npush temp 2\npush temp 2\nadd\n";
+        if ((c >> bit) & 1)
+        {
+            code += "push temp 1\nadd\n";
+        }
+    }
+    return code;
+}
+
+// the VM code of the divide helper, it divides argument 0 by argument 1, a power of two > 1, rounding towards 0
+static string divide_helper()
+{
+    string name = myclassname + ".divide$pow2";
+    string code;
+    code += "function " + name + " 4\n";
+
+    // local 3 is true if x is negative, then x is made positive
+    code += "push argument 0\npush constant 0\nlt\npop local 3\n";
+    code += "push local 3\nnot\nif-goto DIVIDE_POSITIVE\n";
+    code += "push argument 0\nneg\npop argument 0\n";
+    code += "label DIVIDE_POSITIVE\n";
+
+    // local 1 is the bit of x being tested and local 2 is the bit of the result it becomes
+    code += "push argument 1\npop local 1\npush constant 1\npop local 2\n";
+    code += "label DIVIDE_LOOP\n";
+    code += "push local 1\npush constant 0\neq\nif-goto DIVIDE_END\n";
+    code += "push argument 0\npush local 1\nand\npush constant 0\neq\nif-goto DIVIDE_NEXT\n";
+    code += "push local 0\npush local 2\nadd\npop local 0\n";
+    code += "label DIVIDE_NEXT\n";
+    code += "push local 1\npush local 1\nadd\npop local 1\n";
+    code += "push local 2\npush local 2\nadd\npop local 2\n";
+    code += "goto DIVIDE_LOOP\n";
+    code += "label DIVIDE_END\n";
+
+    // the result has the sign of x
+    code += "push local 3\nnot\nif-goto DIVIDE_RETURN\n";
+    code += "push local 0\nneg\npop local 0\n";
+    code += "label DIVIDE_RETURN\n";
+    code += "push local 0\nreturn\n";
+    return code;
+}
+
+// the log base 2 of c if it is a power of two, otherwise -1
+static int log2_of(int c)
+{
+    for (int k = 0; k < 15; k++)
+    {
+        if (c == (1 << k))
+        {
+            return k;
+        }
+    }
+    return -1;
+}
+
+// write the VM code for multiplying or dividing the value on the top of the stack by the constant c
+// if the cost model says it is cheaper than calling Math.multiply or Math.divide, returns false if it is not
+static bool strength_reduce(char op, int c)
+{
+    if (c == -32768)
+    {
+        return false;
+    }
+
+    int magnitude = c < 0 ? -c : c;
+    string negate = c < 0 ? "neg\n" : "";
+
+    if (op == '*')
+    {
+        if (c == 0)
+        {
+            emit("pop temp 0\npush constant 0\n");
+            return true;
+        }
+
+        string code = multiply_sequence(magnitude) + negate;
+        if (cost_of(vm_lines(code), vm_lines(code)) >= cost_of(2, multiply_call_time))
+        {
+            return false;
+        }
+        emit(code);
+        return true;
+    }
+
+    int k = log2_of(magnitude);
+    if (op != '/' || k < 0)
+    {
+        return false;
+    }
+
+    // x / 1 is x
+    if (k == 0)
+    {
+        emit(negate);
+        return true;
+    }
+
+    // the helper is written once but its size is counted at every use so the choice does not depend on
+    // the order the subroutines are walked in
+    int helper_cost = cost_of(2 + vm_lines(negate), divide_helper_time + divide_helper_step * (16 - k) + vm_lines(negate));
+    if (helper_cost + vm_lines(divide_helper()) * vm_command_size >= cost_of(2, divide_call_time))
+    {
+        return false;
+    }
+
+    divide_helper_used = true;
+    emit("push constant " + to_string(magnitude) + "\ncall " + myclassname + ".divide$pow2 2\n" + negate);
+    return true;
+}
+
+// true if strength reduction is on and an ast term node is a constant, eg 10, -4 or (2 * 8), its value is recorded in value
+// a constant has no side effects so it does not matter that its code is replaced
+static bool is_reducible(ast term, int &value)
+{
+    optional<int> constant = ast_constant_value(term);
+    if (!strength_reduction_on() || !constant)
+    {
+        return false;
+    }
+    value = *constant;
+    return true;
+}
+
+// the code generator is an ast_walker, see ast-visitor.h, with one walk_*() function per node that writes VM code
+// the sub-trees of the other nodes, eg a statements node or a term node, are walked by ast_walker's walk_*() functions
+class codegen : public ast_walker<codegen>
+{
+public:
+    void walk_class(ast t);
+    void walk_var_dec(ast t);
+    void walk_subr_decs(ast t);
+    void walk_constructor(ast t);
+    void walk_function(ast t);
+    void walk_method(ast t);
+    void walk_param_list(ast t);
+    void walk_subr_body(ast t);
+    void walk_let(ast t);
+    void walk_let_array(ast t);
+    void walk_if(ast t);
+    void walk_if_else(ast t);
+    void walk_while(ast t);
+    void walk_do(ast t);
+    void walk_return(ast t);
+    void walk_return_expr(ast t);
+    void walk_expr(ast t);
+    void walk_int(ast t);
+    void walk_string(ast t);
+    void walk_bool(ast t);
+    void walk_null(ast t);
+    void walk_this(ast t);
+    void walk_unary_op(ast t);
+    void walk_var(ast t);
+    void walk_array_index(ast t);
+    void walk_call_as_function(ast t);
+    void walk_call_as_method(ast t);
+
+    // a subr call is walked by its call as function or call as method node, which pass it the class name
+    // and the kind of call, ast_walker's walk_subr_call() is never used but must be visible to ast_walker
+    using ast_walker<codegen>::walk_subr_call;
+    void walk_subr_call(ast t, string name, string type);
+
+    void walk_infix_op(ast t);
+};
 
 // walk an ast class node with fields:
 // class_name - a string
 // var_decs   - ast vector of variable declarations
 // subr_decs  - ast vector of subroutine declarations
 //
-void walk_class(ast t)
+void codegen::walk_class(ast t)
 {
     myclassname = get_class_class_name(t);
     ast var_decs = get_class_var_decs(t);
@@ -84,18 +326,6 @@ void walk_class(ast t)
     walk_subr_decs(subr_decs);
 }
 
-// walk an ast class var decs node
-// it is an ast vector of variable declarations
-//
-void walk_class_var_decs(ast t)
-{
-    int ndecs = size_of_class_var_decs(t);
-    for (int i = 0; i < ndecs; i++)
-    {
-        walk_var_dec(get_class_var_decs(t, i));
-    }
-}
-
 // walk an ast variable declaration with fields
 // name - a string
 // type - a string - "int", "char", "boolean" or a class name
@@ -103,7 +333,7 @@ void walk_class_var_decs(ast t)
 // offset - an int
 // this is used for statics, fields, parameters and local variables
 //
-void walk_var_dec(ast t)
+void codegen::walk_var_dec(ast t)
 {
     string name = get_var_dec_name(t);
     string type = get_var_dec_type(t);
@@ -118,37 +348,41 @@ void walk_var_dec(ast t)
 
 // walk an ast class var decs node
 // it is an ast vector of subroutine declarations
+// each subroutine is walked into its own output string, the AST is only read by this thread,
+// then if any peephole rules are selected the strings are optimised in parallel, see codegen-peephole.cpp,
+// and the output is written in declaration order
 //
-void walk_subr_decs(ast t)
+void codegen::walk_subr_decs(ast t)
 {
     int size = size_of_subr_decs(t);
+    vector<string> outputs(size);
+    divide_helper_used = false;
+
     for (int i = 0; i < size; i++)
     {
+        subr_output = &outputs[i];
         walk_subr(get_subr_decs(t, i));
+        subr_output = nullptr;
     }
-}
 
-// walk an ast subroutine node with a single field
-// subr - an ast constructor, ast function or ast method node
-//
-void walk_subr(ast t)
-{
-    ast subr = get_subr_subr(t);
+    // the peephole pass is the only work that runs on the pool, if no rules are selected it would not
+    // change anything so no threads are started
+    if (jack_peephole_selected())
+    {
+        parallel_for(size, [&](int i)
+        {
+            outputs[i] = jack_peephole(outputs[i]);
+        });
+    }
 
-    switch (ast_node_kind(subr))
+    for (int i = 0; i < size; i++)
     {
-    case ast_constructor:
-        walk_constructor(subr);
-        break;
-    case ast_function:
-        walk_function(subr);
-        break;
-    case ast_method:
-        walk_method(subr);
-        break;
-    default:
-        fatal_error(0, "Unexpected subroutine kind");
-        break;
+        write_to_output(outputs[i]);
+    }
+
+    if (divide_helper_used)
+    {
+        write_to_output(jack_peephole(divide_helper()));
     }
 }
 
@@ -158,7 +392,7 @@ void walk_subr(ast t)
 // param list - an ast vector of variable declarations
 // subr body - an ast subr body node
 //
-void walk_constructor(ast t)
+void codegen::walk_constructor(ast t)
 {
     type = "constructor";
 
@@ -176,7 +410,7 @@ void walk_constructor(ast t)
     output += "call Memory.alloc 1\n";
     output += "pop pointer 0\n";
 
-    write_to_output(output);
+    emit(output);
 
     walk_param_list(param_list);
     walk_subr_body(subr_body);
@@ -188,7 +422,7 @@ void walk_constructor(ast t)
 // param list - an ast vector of variable declarations
 // subr body - an ast subr body node
 //
-void walk_function(ast t)
+void codegen::walk_function(ast t)
 {
     type = "function";
 
@@ -203,7 +437,7 @@ void walk_function(ast t)
 
     output += "function " + myclassname + "." + name + " " + to_string(size_of_var_decs(var_decs)) + "\n";
 
-    write_to_output(output);
+    emit(output);
 
     walk_param_list(param_list);
     walk_subr_body(subr_body);
@@ -215,7 +449,7 @@ void walk_function(ast t)
 // param list - an ast vector of variable declarations
 // subr body - an ast subr body node
 //
-void walk_method(ast t)
+void codegen::walk_method(ast t)
 {
     //string vtype = get_method_vtype(t) ;
     string name = get_method_name(t);
@@ -231,7 +465,7 @@ void walk_method(ast t)
     output += "push argument 0\n";
     output += "pop pointer 0\n";
 
-    write_to_output(output);
+    emit(output);
 
     walk_param_list(param_list);
     walk_subr_body(subr_body);
@@ -240,7 +474,7 @@ void walk_method(ast t)
 // walk an ast param list node
 // it is an ast vector of variable declarations
 //
-void walk_param_list(ast t)
+void codegen::walk_param_list(ast t)
 {
     int ndecs = size_of_param_list(t);
     for (int i = 0; i < ndecs; i++)
@@ -253,96 +487,31 @@ void walk_param_list(ast t)
 // decs - an ast vector of variable declarations
 // body - an ast vector of statement nodes
 //
-void walk_subr_body(ast t)
+void codegen::walk_subr_body(ast t)
 {
     ast decs = get_subr_body_decs(t);
     ast body = get_subr_body_body(t);
 
     if_counter = 0;
     while_counter = 0;
+    loop_depth = 0;
 
     walk_var_decs(decs);
     walk_statements(body);
 }
 
-// walk an ast param list node
-// it is an ast vector of variable declarations
-//
-void walk_var_decs(ast t)
-{
-    int ndecs = size_of_var_decs(t);
-    for (int i = 0; i < ndecs; i++)
-    {
-        walk_var_dec(get_var_decs(t, i));
-    }
-}
-
-// walk an ast statements node
-// it is an ast vector of statement nodes
-//
-void walk_statements(ast t)
-{
-    int nstatements = size_of_statements(t);
-    for (int i = 0; i < nstatements; i++)
-    {
-        walk_statement(get_statements(t, i));
-    }
-}
-
-// walk an ast statement node with a single field
-// statement - one of the following ast nodes, let, let array, if, if else, while, do, return, return expr or statements
-//
-void walk_statement(ast t)
-{
-    ast statement = get_statement_statement(t);
-
-    switch (ast_node_kind(statement))
-    {
-    case ast_let:
-        walk_let(statement);
-        break;
-    case ast_let_array:
-        walk_let_array(statement);
-        break;
-    case ast_if:
-        walk_if(statement);
-        break;
-    case ast_if_else:
-        walk_if_else(statement);
-        break;
-    case ast_while:
-        walk_while(statement);
-        break;
-    case ast_do:
-        walk_do(statement);
-        break;
-    case ast_return:
-        walk_return(statement);
-        break;
-    case ast_return_expr:
-        walk_return_expr(statement);
-        break;
-    case ast_statements:
-        walk_statements(statement);
-        break;
-    default:
-        fatal_error(0, "Unexpected statement kind");
-        break;
-    }
-}
-
 // walk an ast let node with fields
 // var  - an ast variable
 // expr - an ast expr node
 //
-void walk_let(ast t)
+void codegen::walk_let(ast t)
 {
     ast var = get_let_var(t);
     ast expr = get_let_expr(t);
 
     // walk_var(var) ;
     walk_expr(expr);
-    write_to_output("pop " + get_var_segment(var) + " " + to_string(get_var_offset(var)) + "\n");
+    emit("pop " + get_var_segment(var) + " " + to_string(get_var_offset(var)) + "\n");
 }
 
 // walk an ast let array node with fields
@@ -350,7 +519,7 @@ void walk_let(ast t)
 // index  - an ast expr node
 // expr   - an ast expr node
 //
-void walk_let_array(ast t)
+void codegen::walk_let_array(ast t)
 {
     ast var = get_let_array_var(t);
     ast index = get_let_array_index(t);
@@ -361,7 +530,7 @@ void walk_let_array(ast t)
     walk_expr(index);
     walk_var(var);
 
-    write_to_output("add\n");
+    emit("add\n");
 
     walk_expr(expr);
 
@@ -370,14 +539,14 @@ void walk_let_array(ast t)
     output += "push temp 0\n";
     output += "pop that 0\n";
 
-    write_to_output(output);
+    emit(output);
 }
 
 // walk an ast if node with fields
 // condition - an ast expr node
 // if true   - an ast statements node
 //
-void walk_if(ast t)
+void codegen::walk_if(ast t)
 {
     ast condition = get_if_condition(t);
     ast if_true = get_if_if_true(t);
@@ -393,7 +562,7 @@ void walk_if(ast t)
     output += "goto IF_FALSE" + to_string(current_if) + "\n";
     output += "label IF_TRUE" + to_string(current_if) + "\n";
 
-    write_to_output(output);
+    emit(output);
 
     output = "";
 
@@ -401,7 +570,7 @@ void walk_if(ast t)
 
     output += "label IF_FALSE" + to_string(current_if) + "\n";
 
-    write_to_output(output);
+    emit(output);
 }
 
 // walk an ast if else node with fields
@@ -409,7 +578,7 @@ void walk_if(ast t)
 // if true   - an ast statements node
 // if else   - an ast statements node
 //
-void walk_if_else(ast t)
+void codegen::walk_if_else(ast t)
 {
     ast condition = get_if_else_condition(t);
     ast if_true = get_if_else_if_true(t);
@@ -425,7 +594,7 @@ void walk_if_else(ast t)
     output += "goto IF_FALSE" + to_string(current_if) + "\n";
     output += "label IF_TRUE" + to_string(current_if) + "\n";
 
-    write_to_output(output);
+    emit(output);
     output = "";
 
     walk_statements(if_true);
@@ -433,21 +602,21 @@ void walk_if_else(ast t)
     output += "goto IF_END" + to_string(current_if) + "\n";
     output += "label IF_FALSE" + to_string(current_if) + "\n";
 
-    write_to_output(output);
+    emit(output);
     output = "";
 
     walk_statements(if_false);
 
     output += "label IF_END" + to_string(current_if) + "\n";
 
-    write_to_output(output);
+    emit(output);
 }
 
 // walk an ast while node with fields
 // condition - an ast expr node
 // body      - an ast statements node
 //
-void walk_while(ast t)
+void codegen::walk_while(ast t)
 {
     ast condition = get_while_condition(t);
     ast body = get_while_body(t);
@@ -455,59 +624,51 @@ void walk_while(ast t)
     int current_while = while_counter;
     while_counter++;
 
-    write_to_output("label WHILE_EXP" + to_string(current_while) + "\n");
+    // the condition and body are run on every iteration
+    loop_depth++;
+
+    emit("label WHILE_EXP" + to_string(current_while) + "\n");
     walk_expr(condition);
 
-    write_to_output("not\n");
+    emit("not\n");
 
-    write_to_output("if-goto WHILE_END" + to_string(current_while) + "\n");
+    emit("if-goto WHILE_END" + to_string(current_while) + "\n");
     walk_statements(body);
 
-    write_to_output("goto WHILE_EXP" + to_string(current_while) + "\n");
+    emit("goto WHILE_EXP" + to_string(current_while) + "\n");
+
+    emit("label WHILE_END" + to_string(current_while) + "\n");
 
-    write_to_output("label WHILE_END" + to_string(current_while) + "\n");
+    loop_depth--;
 }
 
 // walk an ast do node with a single field
 // call - an ast call as function node or an ast call as method node
 //
-void walk_do(ast t)
+void codegen::walk_do(ast t)
 {
-    ast call = get_do_call(t);
-
-    switch (ast_node_kind(call))
-    {
-    case ast_call_as_function:
-        walk_call_as_function(call);
-        break;
-    case ast_call_as_method:
-        walk_call_as_method(call);
-        break;
-    default:
-        fatal_error(0, "Unexpected call kind");
-        break;
-    }
-    write_to_output("pop temp 0\n");
+    walk_fields<ast_do>(t);
+    emit("pop temp 0\n");
 }
 
 // walk an ast return node, it has not fields
 //
-void walk_return(ast t)
+void codegen::walk_return(ast t)
 {
-    write_to_output("push constant 0\n");
-    write_to_output("return\n");
+    emit("push constant 0\n");
+    emit("return\n");
 }
 
 // walk an ast return expr node with a single field
 // expr - an ast expr node
 //
-void walk_return_expr(ast t)
+void codegen::walk_return_expr(ast t)
 {
     ast expr = get_return_expr(t);
 
     walk_expr(expr);
 
-    write_to_output("return\n");
+    emit("return\n");
 }
 
 // walk an ast param list node
@@ -516,89 +677,72 @@ void walk_return_expr(ast t)
 // all elements at even indices are an ast term node
 // all elements at odd indices are an ast infix op
 //
-void walk_expr(ast t)
+void codegen::walk_expr(ast t)
 {
     int term_ops = size_of_expr(t);
+    int first = 1;
+    int c;
 
     //walk term first then (term infix)*
     //reference: 1 + 2 + 3
-    walk_term(get_expr(t, 0));
+    // c * x is walked as x * c so it can be strength reduced
+    if (term_ops >= 3 && get_infix_op_op(get_expr(t, 1)) == "*" && is_reducible(get_expr(t, 0), c))
+    {
+        walk_term(get_expr(t, 2));
+        if (!strength_reduce('*', c))
+        {
+            walk_term(get_expr(t, 0));
+            walk_infix_op(get_expr(t, 1));
+        }
+        first = 3;
+    }
+    else
+    {
+        walk_term(get_expr(t, 0));
+    }
 
-    for (int i = 1; i < term_ops; i += 2)
+    for (int i = first; i < term_ops; i += 2)
     {
         ast op = get_expr(t, i);
         ast term = get_expr(t, i + 1);
+        char infix = get_infix_op_op(op)[0];
+        if ((infix == '*' || infix == '/') && is_reducible(term, c) && strength_reduce(infix, c))
+        {
+            continue;
+        }
         walk_term(term);
         walk_infix_op(op);
     }
 }
 
-// walk an ast term node with a single field
-// term - one of the following ast nodes:
-//        int, string, bool, null, this, expr, unary op,
-//        variable, array index, call as function or call as method
-//
-void walk_term(ast t)
-{
-    ast term = get_term_term(t);
-
-    switch (ast_node_kind(term))
-    {
-    case ast_int:
-        walk_int(term);
-        break;
-    case ast_string:
-        walk_string(term);
-        break;
-    case ast_bool:
-        walk_bool(term);
-        break;
-    case ast_null:
-        walk_null(term);
-        break;
-    case ast_this:
-        walk_this(term);
-        break;
-    case ast_expr:
-        walk_expr(term);
-        break;
-    case ast_unary_op:
-        walk_unary_op(term);
-        break;
-    case ast_var:
-        walk_var(term);
-        break;
-    case ast_array_index:
-        walk_array_index(term);
-        break;
-    case ast_call_as_function:
-        walk_call_as_function(term);
-        break;
-    case ast_call_as_method:
-        walk_call_as_method(term);
-        break;
-    default:
-        fatal_error(0, "Unexpected term kind");
-        break;
-    }
-}
-
 // walk an ast int node with a single field
 // constant - an integer in the range -32,768 to 32,767
+// the parser only creates 0 to 32,767 but optimiser-e folds constants into negative numbers
 //
-void walk_int(ast t)
+void codegen::walk_int(ast t)
 {
     int _constant = get_int_constant(t);
     string output = "";
 
-    output += "push constant " + to_string(_constant) + "\n";
-    write_to_output(output);
+    if (_constant == -32768)
+    {
+        output += "push constant 32767\nneg\npush constant 1\nsub\n";
+    }
+    else if (_constant < 0)
+    {
+        output += "push constant " + to_string(-_constant) + "\nneg\n";
+    }
+    else
+    {
+        output += "push constant " + to_string(_constant) + "\n";
+    }
+    emit(output);
 }
 
 // walk an ast string node with a single field
 // constant - a string
 //
-void walk_string(ast t)
+void codegen::walk_string(ast t)
 {
     string _constant = get_string_constant(t);
 
@@ -611,35 +755,35 @@ void walk_string(ast t)
         result += "push constant " + to_string(int(tmp)) + "\n";
         result += "call String.appendChar 2\n";
     }
-    write_to_output(result);
+    emit(result);
 }
 
 // walk an ast bool node with a single field
 // constant - either true or false
 //
-void walk_bool(ast t)
+void codegen::walk_bool(ast t)
 {
     bool _constant = get_bool_t_or_f(t);
-    write_to_output("push constant 0\n");
+    emit("push constant 0\n");
 
     if (_constant)
     {
-        write_to_output("not\n");
+        emit("not\n");
     }
 }
 
 // walk an ast null node, it has not fields
 //
-void walk_null(ast t)
+void codegen::walk_null(ast t)
 {
-    write_to_output("push constant 0\n");
+    emit("push constant 0\n");
 }
 
 // walk an ast this node, it has not fields
 //
-void walk_this(ast t)
+void codegen::walk_this(ast t)
 {
-    write_to_output("push pointer 0\n");
+    emit("push pointer 0\n");
 }
 
 // walk an ast unary op node with fields
@@ -648,7 +792,7 @@ void walk_this(ast t)
 //        int, string, bool, null, this, expr, unary op,
 //        variable, array index, call as function or call as method
 //
-void walk_unary_op(ast t)
+void codegen::walk_unary_op(ast t)
 {
     string uop = get_unary_op_op(t);
     ast term = get_unary_op_term(t);
@@ -657,11 +801,11 @@ void walk_unary_op(ast t)
 
     if (uop == "-")
     {
-        write_to_output("neg\n");
+        emit("neg\n");
     }
     else if (uop == "~")
     {
-        write_to_output("not\n");
+        emit("not\n");
     }
 }
 
@@ -671,7 +815,7 @@ void walk_unary_op(ast t)
 // segment - a string
 // offset - an int
 //
-void walk_var(ast t)
+void codegen::walk_var(ast t)
 {
     string name = get_var_name(t);
     string type = get_var_type(t);
@@ -682,14 +826,14 @@ void walk_var(ast t)
 
     output += "push " + segment + " " + to_string(offset) + "\n";
 
-    write_to_output(output);
+    emit(output);
 }
 
 // walk an ast array index node with fields
 // var   - an ast variable node
 // index - an ast expr node
 //
-void walk_array_index(ast t)
+void codegen::walk_array_index(ast t)
 {
     ast var = get_array_index_var(t);
     ast index = get_array_index_index(t);
@@ -697,16 +841,16 @@ void walk_array_index(ast t)
     walk_expr(index);
     walk_var(var);
 
-    write_to_output("add\n");
-    write_to_output("pop pointer 1\n");
-    write_to_output("push that 0\n");
+    emit("add\n");
+    emit("pop pointer 1\n");
+    emit("push that 0\n");
 }
 
 // walk an ast subr call as method with fields
 // class name - a string
 // call       - an ast subr call node
 //
-void walk_call_as_function(ast t)
+void codegen::walk_call_as_function(ast t)
 {
     string class_name = get_call_as_function_class_name(t);
     ast subr_call = get_call_as_function_subr_call(t);
@@ -719,12 +863,26 @@ void walk_call_as_function(ast t)
 // var        - an ast variable or ast this node, hidden first parameter of the call
 // call       - an ast subr call node
 //
-void walk_call_as_method(ast t)
+// the parser treats every unqualified call as a method call on this, if the project index
+// says the subroutine is a function or constructor of this class it is called as a function
+//
+void codegen::walk_call_as_method(ast t)
 {
     string class_name = get_call_as_method_class_name(t);
     ast var = get_call_as_method_var(t);
     ast subr_call = get_call_as_method_subr_call(t);
 
+    const jack_index *index = jack_project_index();
+    if (index != nullptr && ast_node_kind(var) == ast_this)
+    {
+        const jack_subr_info *subr = index->find(class_name, get_subr_call_subr_name(subr_call));
+        if (subr != nullptr && subr->kind != tk_method)
+        {
+            walk_subr_call(subr_call, class_name, "function");
+            return;
+        }
+    }
+
     switch (ast_node_kind(var))
     {
     case ast_this:
@@ -744,7 +902,7 @@ void walk_call_as_method(ast t)
 // name      - a string
 // expr list - a vector of ast expr nodes
 //
-void walk_subr_call(ast t, string name, string type)
+void codegen::walk_subr_call(ast t, string name, string type)
 {
     string subr_name = get_subr_call_subr_name(t);
     ast expr_list = get_subr_call_expr_list(t);
@@ -760,56 +918,44 @@ void walk_subr_call(ast t, string name, string type)
 
     string temp_size = to_string(size);
 
-    write_to_output("call " + name + "." + subr_name + " " + temp_size + "\n");
-}
-
-// walk an ast expr list node
-// it is an ast vector of ast expr nodes
-//
-void walk_expr_list(ast t)
-{
-    int nexpressions = size_of_expr_list(t);
-    for (int i = 0; i < nexpressions; i++)
-    {
-        walk_expr(get_expr_list(t, i));
-    }
+    emit("call " + name + "." + subr_name + " " + temp_size + "\n");
 }
 
 // walk an ast infix op node with a single field
 // op - a string - one of "+", "-", "*", "/", "&", "|", "<", ">", "="
 //
-void walk_infix_op(ast t)
+void codegen::walk_infix_op(ast t)
 {
     char op = get_infix_op_op(t)[0];
 
     switch (op)
     {
     case '+':
-        write_to_output("add\n");
+        emit("add\n");
         break;
     case '-':
-        write_to_output("sub\n");
+        emit("sub\n");
         break;
     case '&':
-        write_to_output("and\n");
+        emit("and\n");
         break;
     case '|':
-        write_to_output("or\n");
+        emit("or\n");
         break;
     case '>':
-        write_to_output("gt\n");
+        emit("gt\n");
         break;
     case '<':
-        write_to_output("lt\n");
+        emit("lt\n");
         break;
     case '=':
-        write_to_output("eq\n");
+        emit("eq\n");
         break;
     case '*':
-        write_to_output("call Math.multiply 2\n");
+        emit("call Math.multiply 2\n");
         break;
     case '/':
-        write_to_output("call Math.divide 2\n");
+        emit("call Math.divide 2\n");
         break;
     default:
         fatal_error(0, "Unexpected infix_op");
@@ -817,13 +963,29 @@ void walk_infix_op(ast t)
     }
 }
 
-// main program
+} // namespace
+
+// turn strength reduction of * and / by constants on or off
+void Jack_Compiler::jack_strength_reduction(bool on)
+{
+    strength_reduction_on() = on;
+}
+
+// walk an ast of a Jack class and write the equivalent VM code to the output
+void Jack_Compiler::jack_codegen(ast t)
+{
+    codegen().walk_class(t);
+}
+
+// main program - omitted when the pass is linked into jackc
+#ifndef JACKC
 int main(int argc, char **argv)
 {
     // walk an AST parsed from XML and print VM code
-    walk_class(ast_parse_xml());
+    codegen().walk_class(ast_parse_xml_with_stats());
 
     // flush the output and any errors
     print_output();
     print_errors();
 }
+#endif
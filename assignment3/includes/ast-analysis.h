@@ -0,0 +1,469 @@
+#ifndef JACK_AST_ANALYSIS_H
+#define JACK_AST_ANALYSIS_H
+
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "iobuffer.h"
+#include "abstract-syntax-tree.h"
+
+// Memoised analyses of AST nodes
+//
+// - AST nodes are immutable so any fact about a node is fixed and can be cached by the node's ast handle
+// - an ast_analysis<T> computes a T for a node the first time it is asked for and caches the result,
+//   compute functions should ask for the facts about sub-trees through the same analysis so they are cached too
+// - analyses are created on first use and registered by name, the caches last for the rest of the process
+//   so a later pass, eg codegen after optimiser-e in jackc, reuses facts found by an earlier pass
+// - an analysis can be used by several threads at once, a fact may be computed twice but all threads see the same value
+// - if the environment variable JACK_AST_STATS is set the exit report in ast-stats.h lists every analysis
+//   with its cache size, hits and misses
+//
+// The analyses provided are:
+// . ast_constant_value(t) - the value of an expression if it is a constant, using 16-bit two's complement
+// . ast_has_calls(t) - true if a sub-tree contains a call as function or call as method node
+// . ast_max_stack_depth(t) - the maximum VM stack depth used by the code codegen generates for t
+// . ast_vm_instruction_count(t) - the number of VM commands, including labels, codegen generates for t
+//
+// The last two describe codegen's default output, without strength reduction, peephole rules or a project index,
+// the exit report in ast-stats.h uses them to describe each tree it lists
+//
+// Example: a new analysis that counts the nodes in a tree
+//
+//     int count_nodes(ast t) ;
+//     ast_analysis<int> node_count("node count",count_nodes) ;
+//     int count_nodes(ast t)
+//     {
+//         int n = 1 ;
+//         ... n += node_count(child) for each child ...
+//         return n ;
+//     }
+
+namespace Jack_Compiler
+{
+    // the interface shared by all analyses so they can be listed and cleared together
+    class ast_analysis_base
+    {
+    public:
+        virtual ~ast_analysis_base() {}
+        virtual std::string name() const = 0 ;
+        virtual int size() = 0 ;            // number of cached results
+        virtual int hits() = 0 ;            // number of lookups answered from the cache
+        virtual int misses() = 0 ;          // number of lookups that computed a result
+        virtual void clear() = 0 ;          // discard all cached results
+
+        // every analysis that has been created, it is never destroyed so the exit report can use it
+        static std::vector<ast_analysis_base *> &registry()
+        {
+            static auto analyses = new std::vector<ast_analysis_base *> ;
+            return *analyses ;
+        }
+    } ;
+
+    // discard the cached results of every analysis
+    inline void ast_analyses_clear()
+    {
+        for ( auto analysis : ast_analysis_base::registry() ) analysis->clear() ;
+    }
+
+    // an analysis that computes a T for any AST node
+    template <class T> class ast_analysis : public ast_analysis_base
+    {
+    public:
+        ast_analysis(std::string name,std::function<T(ast)> compute) :
+            analysis_name(name), compute(compute), nhits(0), nmisses(0)
+        {
+            registry().push_back(this) ;
+        }
+
+        ~ast_analysis()
+        {
+            auto &analyses = registry() ;
+            analyses.erase(std::remove(analyses.begin(),analyses.end(),this),analyses.end()) ;
+        }
+
+        // the result for t, computed on first use
+        // the result is returned by value because computing t may add sub-tree results to the cache
+        T operator()(ast t)
+        {
+            {
+                std::lock_guard<std::mutex> guard(lock) ;
+                auto found = cache.find(t) ;
+                if ( found != cache.end() )
+                {
+                    nhits++ ;
+                    return found->second ;
+                }
+                nmisses++ ;
+            }
+
+            T result = compute(t) ;
+
+            std::lock_guard<std::mutex> guard(lock) ;
+            return cache.emplace(t,result).first->second ;
+        }
+
+        std::string name() const { return analysis_name ; }
+        int size() { std::lock_guard<std::mutex> guard(lock) ; return cache.size() ; }
+        int hits() { std::lock_guard<std::mutex> guard(lock) ; return nhits ; }
+        int misses() { std::lock_guard<std::mutex> guard(lock) ; return nmisses ; }
+        void clear() { std::lock_guard<std::mutex> guard(lock) ; cache.clear() ; }
+
+    private:
+        std::string analysis_name ;
+        std::function<T(ast)> compute ;
+        std::unordered_map<ast,T> cache ;
+        std::mutex lock ;
+        int nhits ;
+        int nmisses ;
+    } ;
+
+    //***** 16-bit arithmetic *****//
+
+    // wrap an int to a 16-bit two's complement value in the range -32,768 to 32,767
+    inline int wrap16(int value)
+    {
+        value &= 0xFFFF ;
+        return value >= 0x8000 ? value - 0x10000 : value ;
+    }
+
+    // apply a Jack infix op to two 16-bit values the same way the Hack VM and Math class would
+    // returns no value if the result is not defined, eg division by zero
+    inline std::optional<int> jack_infix_value(char op,int lhs,int rhs)
+    {
+        switch(op)
+        {
+        case '+': return wrap16(lhs + rhs) ;
+        case '-': return wrap16(lhs - rhs) ;
+        case '*': return wrap16(lhs * rhs) ;
+        case '/':
+            // Math.divide is not defined for 0 and cannot represent 32,768
+            if ( rhs == 0 || (lhs == -32768 && rhs == -1) ) return std::nullopt ;
+            return wrap16(lhs / rhs) ;
+        case '&': return wrap16(lhs & rhs) ;
+        case '|': return wrap16(lhs | rhs) ;
+        case '<': return lhs < rhs ? -1 : 0 ;
+        case '>': return lhs > rhs ? -1 : 0 ;
+        case '=': return lhs == rhs ? -1 : 0 ;
+        default:  return std::nullopt ;
+        }
+    }
+
+    //***** the provided analyses *****//
+
+    inline std::optional<int> ast_constant_value(ast t) ;
+    inline bool ast_has_calls(ast t) ;
+    inline int ast_max_stack_depth(ast t) ;
+    inline int ast_vm_instruction_count(ast t) ;
+
+    // the constant value of an ast expr, term, int, bool, null or unary op node
+    // expressions are evaluated left to right as the Jack language specifies, true is -1, false and null are 0
+    inline std::optional<int> compute_constant_value(ast t)
+    {
+        switch(ast_node_kind(t))
+        {
+        case ast_int:
+            return wrap16(get_int_constant(t)) ;
+        case ast_bool:
+            return get_bool_t_or_f(t) ? -1 : 0 ;
+        case ast_null:
+            return 0 ;
+        case ast_term:
+            return ast_constant_value(get_term_term(t)) ;
+        case ast_unary_op:
+        {
+            std::optional<int> value = ast_constant_value(get_unary_op_term(t)) ;
+            if ( !value ) return std::nullopt ;
+            return get_unary_op_op(t) == "-" ? wrap16(-*value) : wrap16(~*value) ;
+        }
+        case ast_expr:
+        {
+            std::optional<int> value = ast_constant_value(get_expr(t,0)) ;
+            int size = size_of_expr(t) ;
+            for ( int i = 1 ; value && i < size ; i += 2 )
+            {
+                std::optional<int> rhs = ast_constant_value(get_expr(t,i + 1)) ;
+                if ( !rhs ) return std::nullopt ;
+                value = jack_infix_value(get_infix_op_op(get_expr(t,i))[0],*value,*rhs) ;
+            }
+            return value ;
+        }
+        default:
+            return std::nullopt ;
+        }
+    }
+
+    // true if any sub-tree of t is a call as function or call as method node
+    inline bool compute_has_calls(ast t)
+    {
+        switch(ast_node_kind(t))
+        {
+        case ast_call_as_function:
+        case ast_call_as_method:
+            return true ;
+        case ast_term:
+            return ast_has_calls(get_term_term(t)) ;
+        case ast_unary_op:
+            return ast_has_calls(get_unary_op_term(t)) ;
+        case ast_array_index:
+            return ast_has_calls(get_array_index_index(t)) ;
+        case ast_expr:
+        {
+            int size = size_of_expr(t) ;
+            for ( int i = 0 ; i < size ; i += 2 ) if ( ast_has_calls(get_expr(t,i)) ) return true ;
+            return false ;
+        }
+        case ast_statements:
+        {
+            int size = size_of_statements(t) ;
+            for ( int i = 0 ; i < size ; i++ ) if ( ast_has_calls(get_statements(t,i)) ) return true ;
+            return false ;
+        }
+        case ast_statement:
+            return ast_has_calls(get_statement_statement(t)) ;
+        case ast_let:
+            return ast_has_calls(get_let_expr(t)) ;
+        case ast_let_array:
+            return ast_has_calls(get_let_array_index(t)) || ast_has_calls(get_let_array_expr(t)) ;
+        case ast_if:
+            return ast_has_calls(get_if_condition(t)) || ast_has_calls(get_if_if_true(t)) ;
+        case ast_if_else:
+            return ast_has_calls(get_if_else_condition(t)) || ast_has_calls(get_if_else_if_true(t)) ||
+                   ast_has_calls(get_if_else_if_false(t)) ;
+        case ast_while:
+            return ast_has_calls(get_while_condition(t)) || ast_has_calls(get_while_body(t)) ;
+        case ast_do:
+            return true ;
+        case ast_return_expr:
+            return ast_has_calls(get_return_expr(t)) ;
+        default:
+            return false ;
+        }
+    }
+
+    // the maximum number of values codegen's code for t pushes on the stack at once
+    inline int compute_max_stack_depth(ast t)
+    {
+        switch(ast_node_kind(t))
+        {
+        case ast_int:
+            // -32768 is pushed as 32767, neg, then 1 is pushed and subtracted
+            return get_int_constant(t) == -32768 ? 2 : 1 ;
+        case ast_bool:
+        case ast_null:
+        case ast_this:
+        case ast_var:
+            return 1 ;
+        case ast_string:
+            // String.new then pairs of string, char for String.appendChar
+            return get_string_constant(t).size() == 0 ? 1 : 2 ;
+        case ast_term:
+            return ast_max_stack_depth(get_term_term(t)) ;
+        case ast_unary_op:
+            return ast_max_stack_depth(get_unary_op_term(t)) ;
+        case ast_expr:
+        {
+            // the first term then each term on top of the value so far
+            int depth = ast_max_stack_depth(get_expr(t,0)) ;
+            int size = size_of_expr(t) ;
+            for ( int i = 2 ; i < size ; i += 2 ) depth = std::max(depth,1 + ast_max_stack_depth(get_expr(t,i))) ;
+            return depth ;
+        }
+        case ast_array_index:
+            // index, then the array's base address, add
+            return std::max(ast_max_stack_depth(get_array_index_index(t)),2) ;
+        case ast_call_as_function:
+        case ast_call_as_method:
+        {
+            bool method = ast_node_kind(t) == ast_call_as_method ;
+            ast subr_call = method ? get_call_as_method_subr_call(t) : get_call_as_function_subr_call(t) ;
+            ast expr_list = get_subr_call_expr_list(subr_call) ;
+
+            // the object for a method then each argument on top of the previous ones
+            int below = method ? 1 : 0 ;
+            int depth = 1 ;
+            int nargs = size_of_expr_list(expr_list) ;
+            for ( int i = 0 ; i < nargs ; i++ )
+            {
+                depth = std::max(depth,below + ast_max_stack_depth(get_expr_list(expr_list,i))) ;
+                below++ ;
+            }
+            return std::max(depth,below) ;
+        }
+        case ast_statements:
+        {
+            int depth = 0 ;
+            int size = size_of_statements(t) ;
+            for ( int i = 0 ; i < size ; i++ ) depth = std::max(depth,ast_max_stack_depth(get_statements(t,i))) ;
+            return depth ;
+        }
+        case ast_statement:
+            return ast_max_stack_depth(get_statement_statement(t)) ;
+        case ast_let:
+            return ast_max_stack_depth(get_let_expr(t)) ;
+        case ast_let_array:
+            // the element address stays on the stack while the value is computed
+            return std::max(std::max(ast_max_stack_depth(get_let_array_index(t)),2),
+                            1 + ast_max_stack_depth(get_let_array_expr(t))) ;
+        case ast_if:
+            return std::max(ast_max_stack_depth(get_if_condition(t)),ast_max_stack_depth(get_if_if_true(t))) ;
+        case ast_if_else:
+            return std::max(ast_max_stack_depth(get_if_else_condition(t)),
+                            std::max(ast_max_stack_depth(get_if_else_if_true(t)),ast_max_stack_depth(get_if_else_if_false(t)))) ;
+        case ast_while:
+            return std::max(ast_max_stack_depth(get_while_condition(t)),ast_max_stack_depth(get_while_body(t))) ;
+        case ast_do:
+            return ast_max_stack_depth(get_do_call(t)) ;
+        case ast_return:
+            return 1 ;
+        case ast_return_expr:
+            return ast_max_stack_depth(get_return_expr(t)) ;
+        case ast_subr_body:
+            return ast_max_stack_depth(get_subr_body_body(t)) ;
+        case ast_subr:
+            return ast_max_stack_depth(get_subr_subr(t)) ;
+        case ast_constructor:
+            return std::max(1,ast_max_stack_depth(get_constructor_subr_body(t))) ;
+        case ast_function:
+            return ast_max_stack_depth(get_function_subr_body(t)) ;
+        case ast_method:
+            return std::max(1,ast_max_stack_depth(get_method_subr_body(t))) ;
+        case ast_subr_decs:
+        {
+            int depth = 0 ;
+            int size = size_of_subr_decs(t) ;
+            for ( int i = 0 ; i < size ; i++ ) depth = std::max(depth,ast_max_stack_depth(get_subr_decs(t,i))) ;
+            return depth ;
+        }
+        case ast_class:
+            return ast_max_stack_depth(get_class_subr_decs(t)) ;
+        default:
+            return 0 ;
+        }
+    }
+
+    // the number of VM commands, including labels, that codegen writes for t
+    inline int compute_vm_instruction_count(ast t)
+    {
+        switch(ast_node_kind(t))
+        {
+        case ast_int:
+        {
+            // see codegen's walk_int(), negative constants are pushed then negated
+            int constant = get_int_constant(t) ;
+            return constant == -32768 ? 4 : constant < 0 ? 2 : 1 ;
+        }
+        case ast_null:
+        case ast_this:
+        case ast_var:
+            return 1 ;
+        case ast_bool:
+            return get_bool_t_or_f(t) ? 2 : 1 ;
+        case ast_string:
+            return 2 + 2 * get_string_constant(t).size() ;
+        case ast_term:
+            return ast_vm_instruction_count(get_term_term(t)) ;
+        case ast_unary_op:
+            return ast_vm_instruction_count(get_unary_op_term(t)) + 1 ;
+        case ast_expr:
+        {
+            // every infix op is a single command
+            int count = size_of_expr(t) / 2 ;
+            int size = size_of_expr(t) ;
+            for ( int i = 0 ; i < size ; i += 2 ) count += ast_vm_instruction_count(get_expr(t,i)) ;
+            return count ;
+        }
+        case ast_array_index:
+            return ast_vm_instruction_count(get_array_index_index(t)) + 4 ;
+        case ast_call_as_function:
+            return ast_vm_instruction_count(get_subr_call_expr_list(get_call_as_function_subr_call(t))) + 1 ;
+        case ast_call_as_method:
+            return ast_vm_instruction_count(get_subr_call_expr_list(get_call_as_method_subr_call(t))) + 2 ;
+        case ast_expr_list:
+        {
+            int count = 0 ;
+            int size = size_of_expr_list(t) ;
+            for ( int i = 0 ; i < size ; i++ ) count += ast_vm_instruction_count(get_expr_list(t,i)) ;
+            return count ;
+        }
+        case ast_statements:
+        {
+            int count = 0 ;
+            int size = size_of_statements(t) ;
+            for ( int i = 0 ; i < size ; i++ ) count += ast_vm_instruction_count(get_statements(t,i)) ;
+            return count ;
+        }
+        case ast_statement:
+            return ast_vm_instruction_count(get_statement_statement(t)) ;
+        case ast_let:
+            return ast_vm_instruction_count(get_let_expr(t)) + 1 ;
+        case ast_let_array:
+            return ast_vm_instruction_count(get_let_array_index(t)) + ast_vm_instruction_count(get_let_array_expr(t)) + 6 ;
+        case ast_if:
+            return ast_vm_instruction_count(get_if_condition(t)) + ast_vm_instruction_count(get_if_if_true(t)) + 4 ;
+        case ast_if_else:
+            return ast_vm_instruction_count(get_if_else_condition(t)) + ast_vm_instruction_count(get_if_else_if_true(t)) +
+                   ast_vm_instruction_count(get_if_else_if_false(t)) + 6 ;
+        case ast_while:
+            return ast_vm_instruction_count(get_while_condition(t)) + ast_vm_instruction_count(get_while_body(t)) + 5 ;
+        case ast_do:
+            return ast_vm_instruction_count(get_do_call(t)) + 1 ;
+        case ast_return:
+            return 2 ;
+        case ast_return_expr:
+            return ast_vm_instruction_count(get_return_expr(t)) + 1 ;
+        case ast_subr_body:
+            return ast_vm_instruction_count(get_subr_body_body(t)) ;
+        case ast_subr:
+            return ast_vm_instruction_count(get_subr_subr(t)) ;
+        case ast_constructor:
+            return ast_vm_instruction_count(get_constructor_subr_body(t)) + 4 ;
+        case ast_function:
+            return ast_vm_instruction_count(get_function_subr_body(t)) + 1 ;
+        case ast_method:
+            return ast_vm_instruction_count(get_method_subr_body(t)) + 3 ;
+        case ast_subr_decs:
+        {
+            int count = 0 ;
+            int size = size_of_subr_decs(t) ;
+            for ( int i = 0 ; i < size ; i++ ) count += ast_vm_instruction_count(get_subr_decs(t,i)) ;
+            return count ;
+        }
+        case ast_class:
+            return ast_vm_instruction_count(get_class_subr_decs(t)) ;
+        default:
+            return 0 ;
+        }
+    }
+
+    // the analyses are created on first use so they are registered in the order they are used
+    // they are never destroyed so that the JACK_AST_STATS exit report can still use them
+    inline std::optional<int> ast_constant_value(ast t)
+    {
+        static auto analysis = new ast_analysis<std::optional<int>>("constant value",compute_constant_value) ;
+        return (*analysis)(t) ;
+    }
+
+    inline bool ast_has_calls(ast t)
+    {
+        static auto analysis = new ast_analysis<bool>("has calls",compute_has_calls) ;
+        return (*analysis)(t) ;
+    }
+
+    inline int ast_max_stack_depth(ast t)
+    {
+        static auto analysis = new ast_analysis<int>("max stack depth",compute_max_stack_depth) ;
+        return (*analysis)(t) ;
+    }
+
+    inline int ast_vm_instruction_count(ast t)
+    {
+        static auto analysis = new ast_analysis<int>("vm instruction count",compute_vm_instruction_count) ;
+        return (*analysis)(t) ;
+    }
+}
+
+#endif //JACK_AST_ANALYSIS_H
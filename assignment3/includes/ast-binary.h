@@ -0,0 +1,447 @@
+#ifndef JACK_AST_BINARY_H
+#define JACK_AST_BINARY_H
+
+#include <string>
+#include <vector>
+#include "iobuffer.h"
+#include "abstract-syntax-tree.h"
+
+// A compact binary encoding of an abstract syntax tree, for storing trees between runs
+//
+// - ast_write_binary() appends the encoding of a tree to a string
+// - an ast_binary_reader creates the AST nodes described by an encoding, it is the same tree that was written
+// - the encoding is much smaller than the XML printed by ast_print_as_xml() and is read without any text matching
+//
+// Example:
+//
+//     std::string bytes ;
+//     ast_write_binary(bytes,t) ;
+//     ast copy = ast_binary_reader(bytes,0,bytes.size()).read() ;
+//
+// The encoding, one record per AST node in pre-order:
+// . a kind byte, ast_kind - ast_alpha, with 0x80 added if the node has a non-empty annotation
+// . if 0x80 was added, the annotation as three string lists: comments, warnings and errors
+// . a list is its number of elements followed by the elements
+// . vector like nodes are a list of nodes
+// . other nodes are their fields in the order of their create_*() function's parameters
+// . strings are their length in bytes followed by their bytes
+// . numbers are unsigned LEB128 varints, ints are zig-zag encoded first
+
+namespace Jack_Compiler
+{
+    // append the binary encoding of t to bytes
+    class ast_binary_writer
+    {
+    public:
+        explicit ast_binary_writer(std::string &bytes) : out(bytes) {}
+
+        void write(ast t)
+        {
+            ast_kind kind = ast_node_kind(t) ;
+            ann a = get_ann(t) ;
+            bool annotated = size_of_ann_comments(a) + size_of_ann_warnings(a) + size_of_ann_errors(a) > 0 ;
+
+            out += (char)((kind - ast_alpha) | (annotated ? 0x80 : 0)) ;
+            if ( annotated ) write_annotation(a) ;
+
+            switch(kind)
+            {
+            case ast_empty:
+            case ast_return:
+            case ast_null:
+            case ast_this:
+                return ;
+            case ast_class:
+                write_string(get_class_class_name(t)) ;
+                write(get_class_var_decs(t)) ;
+                write(get_class_subr_decs(t)) ;
+                return ;
+            case ast_class_var_decs:
+                write_list(size_of_class_var_decs(t),[&](int i) { return get_class_var_decs(t,i) ; }) ;
+                return ;
+            case ast_var_decs:
+                write_list(size_of_var_decs(t),[&](int i) { return get_var_decs(t,i) ; }) ;
+                return ;
+            case ast_subr_decs:
+                write_list(size_of_subr_decs(t),[&](int i) { return get_subr_decs(t,i) ; }) ;
+                return ;
+            case ast_param_list:
+                write_list(size_of_param_list(t),[&](int i) { return get_param_list(t,i) ; }) ;
+                return ;
+            case ast_statements:
+                write_list(size_of_statements(t),[&](int i) { return get_statements(t,i) ; }) ;
+                return ;
+            case ast_expr_list:
+                write_list(size_of_expr_list(t),[&](int i) { return get_expr_list(t,i) ; }) ;
+                return ;
+            case ast_expr:
+                write_list(size_of_expr(t),[&](int i) { return get_expr(t,i) ; }) ;
+                return ;
+            case ast_var_dec:
+                write_string(get_var_dec_name(t)) ;
+                write_string(get_var_dec_segment(t)) ;
+                write_int(get_var_dec_offset(t)) ;
+                write_string(get_var_dec_type(t)) ;
+                return ;
+            case ast_var:
+                write_string(get_var_name(t)) ;
+                write_string(get_var_segment(t)) ;
+                write_int(get_var_offset(t)) ;
+                write_string(get_var_type(t)) ;
+                return ;
+            case ast_subr:
+                write(get_subr_subr(t)) ;
+                return ;
+            case ast_constructor:
+                write_subr(get_constructor_vtype(t),get_constructor_name(t),get_constructor_param_list(t),get_constructor_subr_body(t)) ;
+                return ;
+            case ast_function:
+                write_subr(get_function_vtype(t),get_function_name(t),get_function_param_list(t),get_function_subr_body(t)) ;
+                return ;
+            case ast_method:
+                write_subr(get_method_vtype(t),get_method_name(t),get_method_param_list(t),get_method_subr_body(t)) ;
+                return ;
+            case ast_subr_body:
+                write(get_subr_body_decs(t)) ;
+                write(get_subr_body_body(t)) ;
+                return ;
+            case ast_statement:
+                write(get_statement_statement(t)) ;
+                return ;
+            case ast_let:
+                write(get_let_var(t)) ;
+                write(get_let_expr(t)) ;
+                return ;
+            case ast_let_array:
+                write(get_let_array_var(t)) ;
+                write(get_let_array_index(t)) ;
+                write(get_let_array_expr(t)) ;
+                return ;
+            case ast_if:
+                write(get_if_condition(t)) ;
+                write(get_if_if_true(t)) ;
+                return ;
+            case ast_if_else:
+                write(get_if_else_condition(t)) ;
+                write(get_if_else_if_true(t)) ;
+                write(get_if_else_if_false(t)) ;
+                return ;
+            case ast_while:
+                write(get_while_condition(t)) ;
+                write(get_while_body(t)) ;
+                return ;
+            case ast_do:
+                write(get_do_call(t)) ;
+                return ;
+            case ast_return_expr:
+                write(get_return_expr(t)) ;
+                return ;
+            case ast_term:
+                write(get_term_term(t)) ;
+                return ;
+            case ast_int:
+                write_int(get_int_constant(t)) ;
+                return ;
+            case ast_string:
+                write_string(get_string_constant(t)) ;
+                return ;
+            case ast_bool:
+                write_number(get_bool_t_or_f(t) ? 1 : 0) ;
+                return ;
+            case ast_unary_op:
+                write_string(get_unary_op_op(t)) ;
+                write(get_unary_op_term(t)) ;
+                return ;
+            case ast_array_index:
+                write(get_array_index_var(t)) ;
+                write(get_array_index_index(t)) ;
+                return ;
+            case ast_call_as_function:
+                write_string(get_call_as_function_class_name(t)) ;
+                write(get_call_as_function_subr_call(t)) ;
+                return ;
+            case ast_call_as_method:
+                write_string(get_call_as_method_class_name(t)) ;
+                write(get_call_as_method_var(t)) ;
+                write(get_call_as_method_subr_call(t)) ;
+                return ;
+            case ast_subr_call:
+                write_string(get_subr_call_subr_name(t)) ;
+                write(get_subr_call_expr_list(t)) ;
+                return ;
+            case ast_infix_op:
+                write_string(get_infix_op_op(t)) ;
+                return ;
+            default:
+                CS_IO_Buffers::fatal_error(0,"ast_write_binary: unexpected ast node kind " + ast_kind_to_string(kind)) ;
+            }
+        }
+
+        void write_number(unsigned long long n)
+        {
+            while ( n >= 0x80 )
+            {
+                out += (char)(0x80 | (n & 0x7f)) ;
+                n >>= 7 ;
+            }
+            out += (char)n ;
+        }
+
+        void write_int(long long n) { write_number(((unsigned long long)n << 1) ^ (unsigned long long)(n >> 63)) ; }
+
+        void write_string(const std::string &s)
+        {
+            write_number(s.size()) ;
+            out += s ;
+        }
+
+    private:
+        std::string &out ;
+
+        template <class Get> void write_list(int size,Get get)
+        {
+            write_number(size) ;
+            for ( int i = 0 ; i < size ; i++ ) write(get(i)) ;
+        }
+
+        void write_subr(const std::string &vtype,const std::string &name,ast params,ast body)
+        {
+            write_string(vtype) ;
+            write_string(name) ;
+            write(params) ;
+            write(body) ;
+        }
+
+        void write_annotation(ann a)
+        {
+            write_number(size_of_ann_comments(a)) ;
+            for ( int i = 0 ; i < size_of_ann_comments(a) ; i++ ) write_string(get_ann_comments(a,i)) ;
+            write_number(size_of_ann_warnings(a)) ;
+            for ( int i = 0 ; i < size_of_ann_warnings(a) ; i++ ) write_string(get_ann_warnings(a,i)) ;
+            write_number(size_of_ann_errors(a)) ;
+            for ( int i = 0 ; i < size_of_ann_errors(a) ; i++ ) write_string(get_ann_errors(a,i)) ;
+        }
+    } ;
+
+    // append the binary encoding of t to bytes
+    inline void ast_write_binary(std::string &bytes,ast t)
+    {
+        ast_binary_writer(bytes).write(t) ;
+    }
+
+    // create AST nodes from the binary encoding between two byte offsets
+    // an invalid encoding is a fatal error unless fatal is false, then failed() becomes true and every later read
+    // returns 0, "" or nullptr, this is for files of numbers and strings that can be ignored if they are corrupt
+    class ast_binary_reader
+    {
+    public:
+        ast_binary_reader(const std::string &bytes,size_t begin,size_t end,bool fatal = true)
+            : in(bytes), pos(begin), end(end), fatal(fatal), bad(false) {}
+
+        // the offset of the next byte to be read
+        size_t position() const { return pos ; }
+
+        // true if the encoding was found to be invalid
+        bool failed() const { return bad ; }
+
+        ast read()
+        {
+            int byte = read_byte() ;
+            if ( bad ) return nullptr ;
+            ann a = (byte & 0x80) ? read_annotation() : nullptr ;
+            ast_kind kind = (ast_kind)(ast_alpha + (byte & 0x7f)) ;
+
+            switch(kind)
+            {
+            case ast_empty:             return create_empty(a) ;
+            case ast_return:            return create_return(a) ;
+            case ast_null:              return create_null(a) ;
+            case ast_this:              return create_this(a) ;
+            case ast_class:
+            {
+                std::string name = read_string() ;
+                ast decs = read() ;
+                return create_class(a,name,decs,read()) ;
+            }
+            case ast_class_var_decs:    return create_class_var_decs(a,read_list()) ;
+            case ast_var_decs:          return create_var_decs(a,read_list()) ;
+            case ast_subr_decs:         return create_subr_decs(a,read_list()) ;
+            case ast_param_list:        return create_param_list(a,read_list()) ;
+            case ast_statements:        return create_statements(a,read_list()) ;
+            case ast_expr_list:         return create_expr_list(a,read_list()) ;
+            case ast_expr:              return create_expr(a,read_list()) ;
+            case ast_var_dec:
+            case ast_var:
+            {
+                std::string name = read_string() ;
+                std::string segment = read_string() ;
+                int offset = read_int() ;
+                std::string type = read_string() ;
+                if ( kind == ast_var ) return create_var(a,name,segment,offset,type) ;
+                return create_var_dec(a,name,segment,offset,type) ;
+            }
+            case ast_subr:              return create_subr(a,read()) ;
+            case ast_constructor:
+            case ast_function:
+            case ast_method:
+            {
+                std::string vtype = read_string() ;
+                std::string name = read_string() ;
+                ast params = read() ;
+                ast body = read() ;
+                if ( kind == ast_constructor ) return create_constructor(a,vtype,name,params,body) ;
+                if ( kind == ast_function ) return create_function(a,vtype,name,params,body) ;
+                return create_method(a,vtype,name,params,body) ;
+            }
+            case ast_subr_body:
+            {
+                ast decs = read() ;
+                return create_subr_body(a,decs,read()) ;
+            }
+            case ast_statement:         return create_statement(a,read()) ;
+            case ast_let:
+            {
+                ast var = read() ;
+                return create_let(a,var,read()) ;
+            }
+            case ast_let_array:
+            {
+                ast var = read() ;
+                ast index = read() ;
+                return create_let_array(a,var,index,read()) ;
+            }
+            case ast_if:
+            {
+                ast condition = read() ;
+                return create_if(a,condition,read()) ;
+            }
+            case ast_if_else:
+            {
+                ast condition = read() ;
+                ast if_true = read() ;
+                return create_if_else(a,condition,if_true,read()) ;
+            }
+            case ast_while:
+            {
+                ast condition = read() ;
+                return create_while(a,condition,read()) ;
+            }
+            case ast_do:                return create_do(a,read()) ;
+            case ast_return_expr:       return create_return_expr(a,read()) ;
+            case ast_term:              return create_term(a,read()) ;
+            case ast_int:               return create_int(a,read_int()) ;
+            case ast_string:            return create_string(a,read_string()) ;
+            case ast_bool:              return create_bool(a,read_number() != 0) ;
+            case ast_unary_op:
+            {
+                std::string op = read_string() ;
+                return create_unary_op(a,op,read()) ;
+            }
+            case ast_array_index:
+            {
+                ast var = read() ;
+                return create_array_index(a,var,read()) ;
+            }
+            case ast_call_as_function:
+            {
+                std::string class_name = read_string() ;
+                return create_call_as_function(a,class_name,read()) ;
+            }
+            case ast_call_as_method:
+            {
+                std::string class_name = read_string() ;
+                ast var = read() ;
+                return create_call_as_method(a,class_name,var,read()) ;
+            }
+            case ast_subr_call:
+            {
+                std::string subr_name = read_string() ;
+                return create_subr_call(a,subr_name,read()) ;
+            }
+            case ast_infix_op:          return create_infix_op(a,read_string()) ;
+            default:
+                fail("unexpected ast node kind") ;
+                return nullptr ;
+            }
+        }
+
+        unsigned long long read_number()
+        {
+            unsigned long long n = 0 ;
+            for ( int shift = 0 ; shift < 64 ; shift += 7 )
+            {
+                int byte = read_byte() ;
+                n |= (unsigned long long)(byte & 0x7f) << shift ;
+                if ( byte < 0x80 ) return n ;
+            }
+            fail("number is too long") ;
+            return 0 ;
+        }
+
+        long long read_int()
+        {
+            unsigned long long n = read_number() ;
+            return (long long)(n >> 1) ^ -(long long)(n & 1) ;
+        }
+
+        std::string read_string()
+        {
+            unsigned long long size = read_number() ;
+            if ( size > end - pos ) { fail("string is past the end") ; return "" ; }
+            std::string s = in.substr(pos,size) ;
+            pos += size ;
+            return s ;
+        }
+
+    private:
+        const std::string &in ;
+        size_t pos ;
+        size_t end ;
+        bool fatal ;
+        bool bad ;
+
+        void fail(std::string message)
+        {
+            if ( fatal ) CS_IO_Buffers::fatal_error(0,"Invalid binary AST at byte " + std::to_string(pos) + ": " + message) ;
+            bad = true ;
+            pos = end ;
+        }
+
+        int read_byte()
+        {
+            if ( pos >= end ) { fail("unexpected end") ; return 0 ; }
+            return (unsigned char)in[pos++] ;
+        }
+
+        // the number of elements in a list, every element is at least one byte
+        size_t read_size()
+        {
+            unsigned long long size = read_number() ;
+            if ( size > end - pos ) { fail("list is past the end") ; return 0 ; }
+            return size ;
+        }
+
+        std::vector<ast> read_list()
+        {
+            std::vector<ast> nodes(read_size()) ;
+            for ( auto &node : nodes ) node = read() ;
+            return nodes ;
+        }
+
+        std::vector<std::string> read_strings()
+        {
+            std::vector<std::string> strings(read_size()) ;
+            for ( auto &s : strings ) s = read_string() ;
+            return strings ;
+        }
+
+        ann read_annotation()
+        {
+            std::vector<std::string> comments = read_strings() ;
+            std::vector<std::string> warnings = read_strings() ;
+            return create_ann(comments,warnings,read_strings()) ;
+        }
+    } ;
+}
+
+#endif //JACK_AST_BINARY_H
@@ -0,0 +1,124 @@
+#ifndef JACK_AST_BUILDERS_H
+#define JACK_AST_BUILDERS_H
+
+#include <string>
+#include <vector>
+#include "abstract-syntax-tree.h"
+#include "ast-visitor.h"
+
+// Batch builders for annotations and vector like AST nodes
+//
+// - every add_ann_*() call returns a complete copy of an annotation object and every create_*() call
+//   for a vector like node copies all of its elements, so k small changes to a large object cost O(k * n)
+// - a builder collects all of the changes in std::vectors, each change costs O(1),
+//   and only creates the annotation object or AST node once when build() is called
+// - builders are values, a copy of a builder does not share later changes
+//
+// Example: a lint pass adding several warnings to a node
+//
+//     ann_builder a(get_ann(t)) ;
+//     a.add_warning("unused variable x") ;
+//     a.add_warning("unused variable y") ;
+//     return create_var_decs(a.build(),elements) ;
+//
+// Example: replacing some statements in a long statement list
+//
+//     ast_vector_builder<ast_statements> body(get_subr_body_body(t)) ;
+//     for ( int i = 0 ; i < body.size() ; i++ )
+//         if ( is_dead(body.get(i)) ) body.set(i,create_statement(create_statements(vector<ast>{}))) ;
+//     ast new_body = body.build() ;      // the original node if nothing was set
+
+namespace Jack_Compiler
+{
+    // collect comments, warnings and errors then create one annotation object
+    class ann_builder
+    {
+    public:
+        // start with an empty annotation
+        ann_builder() : original(nullptr), changed(false) {}
+
+        // start with the contents of an existing annotation
+        explicit ann_builder(ann a) : original(a), changed(false)
+        {
+            int ncomments = size_of_ann_comments(a) ;
+            for ( int i = 0 ; i < ncomments ; i++ ) comments.push_back(get_ann_comments(a,i)) ;
+
+            int nwarnings = size_of_ann_warnings(a) ;
+            for ( int i = 0 ; i < nwarnings ; i++ ) warnings.push_back(get_ann_warnings(a,i)) ;
+
+            int nerrors = size_of_ann_errors(a) ;
+            for ( int i = 0 ; i < nerrors ; i++ ) errors.push_back(get_ann_errors(a,i)) ;
+        }
+
+        void add_comment(std::string s) { comments.push_back(s) ; changed = true ; }
+        void add_warning(std::string s) { warnings.push_back(s) ; changed = true ; }
+        void add_error(std::string s) { errors.push_back(s) ; changed = true ; }
+
+        int size_of_comments() const { return comments.size() ; }
+        int size_of_warnings() const { return warnings.size() ; }
+        int size_of_errors() const { return errors.size() ; }
+
+        // return the annotation object, the original annotation is returned if nothing was added
+        ann build() const
+        {
+            if ( !changed ) return original ;
+            return create_ann(comments,warnings,errors) ;
+        }
+
+    private:
+        ann original ;
+        bool changed ;
+        std::vector<std::string> comments ;
+        std::vector<std::string> warnings ;
+        std::vector<std::string> errors ;
+    } ;
+
+    // collect the elements of a vector like AST node of kind K then create the node once
+    // K must be one of ast_class_var_decs, ast_var_decs, ast_subr_decs, ast_param_list,
+    // ast_statements, ast_expr_list or ast_expr
+    template <ast_kind K> class ast_vector_builder
+    {
+        typedef ast_node<K> node ;
+        static_assert(node::is_vector,"ast_vector_builder requires a vector like ast_kind") ;
+
+    public:
+        // start with no elements and an empty annotation
+        ast_vector_builder() : original(nullptr), changed(false), annotation(nullptr) {}
+
+        // start with the elements and annotation of an existing node
+        explicit ast_vector_builder(ast t) : original(t), changed(false), annotation(get_ann(t))
+        {
+            int size = node::size(t) ;
+            for ( int i = 0 ; i < size ; i++ ) elements.push_back(node::get(t,i)) ;
+        }
+
+        int size() const { return elements.size() ; }
+        ast get(int i) const { return elements[i] ; }
+
+        void set(int i,ast element)
+        {
+            if ( elements[i] == element ) return ;
+            elements[i] = element ;
+            changed = true ;
+        }
+
+        void push_back(ast element) { elements.push_back(element) ; changed = true ; }
+
+        void set_ann(ann a) { annotation = a ; changed = true ; }
+
+        // return the node, the original node is returned if nothing was changed
+        ast build() const
+        {
+            if ( original != nullptr && !changed ) return original ;
+            return node::create(annotation,elements) ;
+        }
+
+    private:
+        ast original ;
+        bool changed ;
+        ann annotation ;
+        std::vector<ast> elements ;
+    } ;
+}
+
+#endif //JACK_AST_BUILDERS_H
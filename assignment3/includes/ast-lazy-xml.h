@@ -0,0 +1,428 @@
+#ifndef JACK_AST_LAZY_XML_H
+#define JACK_AST_LAZY_XML_H
+
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+#include "iobuffer.h"
+#include "abstract-syntax-tree.h"
+
+// Lazy loading of an abstract syntax tree printed as XML by ast_print_as_xml()
+//
+// - ast_parse_xml() builds the whole tree of a class before a pass can look at any of it
+// - an ast_lazy_class reads the XML text and skims it once, recording the byte offsets of the class
+//   name, the class var decs, each subr and the statements of each subr body, no AST nodes are created
+// - AST nodes are only created for the parts that are asked for, each part is created at most once
+// - tree() creates any parts not created yet and returns the complete class, as ast_parse_xml() would
+//
+// Example: pretty print one subroutine of a large class without building the rest
+//
+//     ast_lazy_class lazy(ast_read_xml_text()) ;
+//     int i = lazy.find_subr("main") ;
+//     if ( i >= 0 ) walk_subr(lazy.get_subr_decs(i)) ;
+//
+// The XML format, one element per AST node, fields are child elements in the order shown:
+// . an optional <annotation> of <ann-comment>, <ann-warning> and <ann-error> elements is the first child of any node
+// . <class> <class-name> <class-var-decs> <subr-decs>
+// . <var-dec> and <var> both have <var-segment> <var-name> <var-offset> <var-type>
+// . <constructor>, <function> and <method> have <vtype> <name> <param-list> <subr-body>
+// . <int> <ic>, <string> <sc>, <bool> <tf>, <unary-op> <op> <term>, <op> <i-op> for an infix op
+// . <call-as-function> <class-name> <subr-call>, <call-as-method> <class-name> <var> or <this> <subr-call>
+// . <subr-call> <subr-name> <expr-list>
+// . the remaining elements are named after their ast_kind with '_' replaced by '-'
+
+namespace Jack_Compiler
+{
+    // read all of standard input
+    inline std::string ast_read_xml_text()
+    {
+        return std::string(std::istreambuf_iterator<char>(std::cin),std::istreambuf_iterator<char>()) ;
+    }
+
+    // create AST nodes from the XML text between two byte offsets
+    class ast_xml_reader
+    {
+    public:
+        ast_xml_reader(const std::string &xml,size_t begin,size_t end) : xml(xml), pos(begin), end(end) {}
+
+        // read the next element and return the AST node it describes
+        ast read()
+        {
+            element e ;
+            read_element(e) ;
+            return to_ast(e) ;
+        }
+
+        // read the next element, it must be an <annotation>, and return the annotation object it describes
+        ann read_annotation()
+        {
+            element wrapper ;
+            wrapper.children.emplace_back() ;
+            read_element(wrapper.children.back()) ;
+
+            size_t first ;
+            return annotation(wrapper,first) ;
+        }
+
+    private:
+        const std::string &xml ;
+        size_t pos ;
+        size_t end ;
+
+        // an XML element, text is only used if there are no children
+        struct element
+        {
+            std::string name ;
+            std::string text ;
+            std::vector<element> children ;
+        } ;
+
+        void fail(std::string message)
+        {
+            CS_IO_Buffers::fatal_error(0,"Invalid AST XML at byte " + std::to_string(pos) + ": " + message) ;
+        }
+
+        // read the name of a tag, pos is just after the '<', leaves pos after the '>'
+        std::string read_tag_name()
+        {
+            size_t close = xml.find('>',pos) ;
+            if ( close == std::string::npos || close >= end ) fail("unterminated tag") ;
+            std::string name = xml.substr(pos,close - pos) ;
+            pos = close + 1 ;
+            return name ;
+        }
+
+        // replace the XML character entities in text
+        static std::string decode(const std::string &text)
+        {
+            if ( text.find('&') == std::string::npos ) return text ;
+
+            std::string result ;
+            for ( size_t i = 0 ; i < text.size() ; i++ )
+            {
+                if ( text[i] != '&' ) { result += text[i] ; continue ; }
+
+                size_t semi = text.find(';',i) ;
+                std::string entity = semi == std::string::npos ? "" : text.substr(i + 1,semi - i - 1) ;
+                if ( entity == "lt" ) result += '<' ;
+                else if ( entity == "gt" ) result += '>' ;
+                else if ( entity == "amp" ) result += '&' ;
+                else if ( entity == "quot" ) result += '"' ;
+                else if ( entity == "apos" ) result += '\'' ;
+                else { result += '&' ; continue ; }
+                i = semi ;
+            }
+            return result ;
+        }
+
+        // read an element and all of its children
+        void read_element(element &e)
+        {
+            pos = xml.find('<',pos) ;
+            if ( pos == std::string::npos || pos >= end ) fail("missing element") ;
+            pos++ ;
+            e.name = read_tag_name() ;
+            if ( e.name.empty() || e.name[0] == '/' ) fail("expected an opening tag") ;
+
+            size_t text_start = pos ;
+            for (;;)
+            {
+                size_t next = xml.find('<',pos) ;
+                if ( next == std::string::npos || next >= end ) fail("missing </" + e.name + ">") ;
+
+                if ( xml[next + 1] == '/' )
+                {
+                    if ( e.children.empty() ) e.text = decode(xml.substr(text_start,next - text_start)) ;
+                    pos = next + 2 ;
+                    if ( read_tag_name() != e.name ) fail("mismatched </" + e.name + ">") ;
+                    return ;
+                }
+
+                pos = next ;
+                e.children.emplace_back() ;
+                read_element(e.children.back()) ;
+            }
+        }
+
+        // the annotation, if any, is the first child, first is set to the index of the first field
+        ann annotation(const element &e,size_t &first)
+        {
+            first = 0 ;
+            if ( e.children.empty() || e.children[0].name != "annotation" ) return nullptr ;
+
+            first = 1 ;
+            std::vector<std::string> comments, warnings, errors ;
+            for ( auto &a : e.children[0].children )
+            {
+                if ( a.name == "ann-comment" ) comments.push_back(a.text) ;
+                else if ( a.name == "ann-warning" ) warnings.push_back(a.text) ;
+                else if ( a.name == "ann-error" ) errors.push_back(a.text) ;
+            }
+            return create_ann(comments,warnings,errors) ;
+        }
+
+        // the field at index i, after any annotation
+        const element &field(const element &e,size_t first,size_t i,const char *name)
+        {
+            if ( first + i >= e.children.size() ) fail("<" + e.name + "> is missing a field") ;
+            const element &f = e.children[first + i] ;
+            if ( name != nullptr && f.name != name ) fail("<" + e.name + "> expected <" + name + "> found <" + f.name + ">") ;
+            return f ;
+        }
+
+        // the AST nodes for the fields from index i onwards
+        std::vector<ast> elements(const element &e,size_t first)
+        {
+            std::vector<ast> result ;
+            for ( size_t i = first ; i < e.children.size() ; i++ ) result.push_back(to_ast(e.children[i])) ;
+            return result ;
+        }
+
+        ast to_ast(const element &e)
+        {
+            size_t f ;
+            ann a = annotation(e,f) ;
+            const std::string &n = e.name ;
+
+            if ( n == "class" )
+                return create_class(a,field(e,f,0,"class-name").text,to_ast(field(e,f,1,"class-var-decs")),
+                                    to_ast(field(e,f,2,"subr-decs"))) ;
+            if ( n == "class-var-decs" ) return create_class_var_decs(a,elements(e,f)) ;
+            if ( n == "var-decs" ) return create_var_decs(a,elements(e,f)) ;
+            if ( n == "subr-decs" ) return create_subr_decs(a,elements(e,f)) ;
+            if ( n == "param-list" ) return create_param_list(a,elements(e,f)) ;
+            if ( n == "statements" ) return create_statements(a,elements(e,f)) ;
+            if ( n == "expr-list" ) return create_expr_list(a,elements(e,f)) ;
+            if ( n == "expr" ) return create_expr(a,elements(e,f)) ;
+            if ( n == "var-dec" || n == "var" )
+            {
+                std::string segment = field(e,f,0,"var-segment").text ;
+                std::string name = field(e,f,1,"var-name").text ;
+                int offset = std::stoi(field(e,f,2,"var-offset").text) ;
+                std::string type = field(e,f,3,"var-type").text ;
+                if ( n == "var" ) return create_var(a,name,segment,offset,type) ;
+                return create_var_dec(a,name,segment,offset,type) ;
+            }
+            if ( n == "subr" ) return create_subr(a,to_ast(field(e,f,0,nullptr))) ;
+            if ( n == "constructor" || n == "function" || n == "method" )
+            {
+                std::string vtype = field(e,f,0,"vtype").text ;
+                std::string name = field(e,f,1,"name").text ;
+                ast params = to_ast(field(e,f,2,"param-list")) ;
+                ast body = to_ast(field(e,f,3,"subr-body")) ;
+                if ( n == "constructor" ) return create_constructor(a,vtype,name,params,body) ;
+                if ( n == "function" ) return create_function(a,vtype,name,params,body) ;
+                return create_method(a,vtype,name,params,body) ;
+            }
+            if ( n == "subr-body" )
+                return create_subr_body(a,to_ast(field(e,f,0,"var-decs")),to_ast(field(e,f,1,"statements"))) ;
+            if ( n == "statement" ) return create_statement(a,to_ast(field(e,f,0,nullptr))) ;
+            if ( n == "let" ) return create_let(a,to_ast(field(e,f,0,"var")),to_ast(field(e,f,1,"expr"))) ;
+            if ( n == "let-array" )
+                return create_let_array(a,to_ast(field(e,f,0,"var")),to_ast(field(e,f,1,"expr")),to_ast(field(e,f,2,"expr"))) ;
+            if ( n == "if" ) return create_if(a,to_ast(field(e,f,0,"expr")),to_ast(field(e,f,1,"statements"))) ;
+            if ( n == "if-else" )
+                return create_if_else(a,to_ast(field(e,f,0,"expr")),to_ast(field(e,f,1,"statements")),
+                                      to_ast(field(e,f,2,"statements"))) ;
+            if ( n == "while" ) return create_while(a,to_ast(field(e,f,0,"expr")),to_ast(field(e,f,1,"statements"))) ;
+            if ( n == "do" ) return create_do(a,to_ast(field(e,f,0,nullptr))) ;
+            if ( n == "return" ) return create_return(a) ;
+            if ( n == "return-expr" ) return create_return_expr(a,to_ast(field(e,f,0,"expr"))) ;
+            if ( n == "term" ) return create_term(a,to_ast(field(e,f,0,nullptr))) ;
+            if ( n == "int" ) return create_int(a,std::stoi(field(e,f,0,"ic").text)) ;
+            if ( n == "string" ) return create_string(a,field(e,f,0,"sc").text) ;
+            if ( n == "bool" ) return create_bool(a,field(e,f,0,"tf").text == "true") ;
+            if ( n == "null" ) return create_null(a) ;
+            if ( n == "this" ) return create_this(a) ;
+            if ( n == "unary-op" ) return create_unary_op(a,field(e,f,0,"op").text,to_ast(field(e,f,1,"term"))) ;
+            if ( n == "array-index" ) return create_array_index(a,to_ast(field(e,f,0,"var")),to_ast(field(e,f,1,"expr"))) ;
+            if ( n == "call-as-function" )
+                return create_call_as_function(a,field(e,f,0,"class-name").text,to_ast(field(e,f,1,"subr-call"))) ;
+            if ( n == "call-as-method" )
+                return create_call_as_method(a,field(e,f,0,"class-name").text,to_ast(field(e,f,1,nullptr)),
+                                             to_ast(field(e,f,2,"subr-call"))) ;
+            if ( n == "subr-call" )
+                return create_subr_call(a,field(e,f,0,"subr-name").text,to_ast(field(e,f,1,"expr-list"))) ;
+            if ( n == "op" ) return create_infix_op(a,field(e,f,0,"i-op").text) ;
+
+            fail("unexpected element <" + n + ">") ;
+            return nullptr ;
+        }
+    } ;
+
+    // a class read from XML text that only creates AST nodes for the parts that are used
+    class ast_lazy_class
+    {
+    public:
+        // skim the XML for a single class, xml must be the complete output of ast_print_as_xml()
+        explicit ast_lazy_class(std::string text) : xml(std::move(text)), whole_class(nullptr), var_decs(nullptr)
+        {
+            skim() ;
+        }
+
+        std::string class_name() const { return name ; }
+
+        // the class var decs node, created on first use
+        ast get_class_var_decs()
+        {
+            if ( var_decs == nullptr ) var_decs = read(var_decs_span) ;
+            return var_decs ;
+        }
+
+        // the number of subroutine declarations, no nodes are created
+        int size_of_subr_decs() const { return subrs.size() ; }
+
+        // the name of subroutine declaration i, no nodes are created
+        std::string subr_name(int i) const { return subrs.at(i).name ; }
+
+        // the index of the subroutine declaration with the given name or -1
+        int find_subr(std::string subr_name) const
+        {
+            for ( size_t i = 0 ; i < subrs.size() ; i++ ) if ( subrs[i].name == subr_name ) return i ;
+            return -1 ;
+        }
+
+        // the ast subr node of subroutine declaration i, created on first use
+        ast get_subr_decs(int i)
+        {
+            lazy_subr &s = subrs.at(i) ;
+            if ( s.subr == nullptr ) s.subr = read(s.span) ;
+            return s.subr ;
+        }
+
+        // the statements of the body of subroutine declaration i, created on first use
+        // if the whole subr has already been created its statements node is returned
+        ast get_subr_statements(int i)
+        {
+            lazy_subr &s = subrs.at(i) ;
+            if ( s.statements != nullptr ) return s.statements ;
+
+            if ( s.subr != nullptr )
+            {
+                ast subr = get_subr_subr(s.subr) ;
+                switch(ast_node_kind(subr))
+                {
+                case ast_constructor: s.statements = get_subr_body_body(get_constructor_subr_body(subr)) ; break ;
+                case ast_function:    s.statements = get_subr_body_body(get_function_subr_body(subr)) ; break ;
+                default:              s.statements = get_subr_body_body(get_method_subr_body(subr)) ; break ;
+                }
+            }
+            else
+            {
+                s.statements = read(s.statements_span) ;
+            }
+            return s.statements ;
+        }
+
+        // the complete class, creating any parts that have not been created yet
+        ast tree()
+        {
+            if ( whole_class != nullptr ) return whole_class ;
+
+            std::vector<ast> decs ;
+            for ( size_t i = 0 ; i < subrs.size() ; i++ ) decs.push_back(get_subr_decs(i)) ;
+
+            whole_class = create_class(read_annotation(class_span),name,get_class_var_decs(),
+                                       create_subr_decs(read_annotation(subr_decs_span),decs)) ;
+            return whole_class ;
+        }
+
+    private:
+        struct xml_span { size_t begin = 0 ; size_t end = 0 ; } ;
+
+        struct lazy_subr
+        {
+            std::string name ;
+            xml_span span ;
+            xml_span statements_span ;
+            ast subr = nullptr ;
+            ast statements = nullptr ;
+        } ;
+
+        std::string xml ;
+        std::string name ;
+        xml_span class_span ;
+        xml_span var_decs_span ;
+        xml_span subr_decs_span ;
+        std::vector<lazy_subr> subrs ;
+        ast whole_class ;
+        ast var_decs ;
+
+        void fail(std::string message)
+        {
+            CS_IO_Buffers::fatal_error(0,"Invalid AST XML: " + message) ;
+        }
+
+        // the byte offset of the next occurrence of s at or after from and before to
+        size_t find(const std::string &s,size_t from,size_t to)
+        {
+            size_t at = xml.find(s,from) ;
+            if ( at == std::string::npos || at >= to ) fail("cannot find " + s) ;
+            return at ;
+        }
+
+        // the span from the opening tag to the end of the closing tag of the first element called tag after from
+        // tag must not contain nested elements with the same name
+        xml_span element_span(const std::string &tag,size_t from,size_t to)
+        {
+            xml_span s ;
+            s.begin = find("<" + tag + ">",from,to) ;
+            s.end = find("</" + tag + ">",s.begin,to) + tag.size() + 3 ;
+            return s ;
+        }
+
+        // text of the first <tag>text</tag> after from
+        std::string text_of(const std::string &tag,size_t from,size_t to)
+        {
+            size_t begin = find("<" + tag + ">",from,to) + tag.size() + 2 ;
+            return xml.substr(begin,find("</",begin,to) - begin) ;
+        }
+
+        // record the offsets of the parts of the class without creating any nodes
+        void skim()
+        {
+            class_span = element_span("class",0,xml.size()) ;
+            name = text_of("class-name",class_span.begin,class_span.end) ;
+            var_decs_span = element_span("class-var-decs",class_span.begin,class_span.end) ;
+            subr_decs_span = element_span("subr-decs",var_decs_span.end,class_span.end) ;
+
+            // each subr contains exactly one constructor, function or method with a <name>, a <var-decs>
+            // and then the body's <statements>, the body's </statements> is the last one before </subr-body>
+            size_t from = subr_decs_span.begin ;
+            for (;;)
+            {
+                size_t next = xml.find("<subr>",from) ;
+                if ( next == std::string::npos || next >= subr_decs_span.end ) break ;
+
+                lazy_subr s ;
+                s.span = element_span("subr",next,subr_decs_span.end) ;
+                s.name = text_of("name",s.span.begin,s.span.end) ;
+
+                size_t body_end = find("</subr-body>",s.span.begin,s.span.end) ;
+                size_t decs_end = find("</var-decs>",s.span.begin,body_end) ;
+                s.statements_span.begin = find("<statements>",decs_end,body_end) ;
+                s.statements_span.end = xml.rfind("</statements>",body_end) + 13 ;
+
+                subrs.push_back(s) ;
+                from = s.span.end ;
+            }
+        }
+
+        ast read(xml_span s)
+        {
+            return ast_xml_reader(xml,s.begin,s.end).read() ;
+        }
+
+        // the annotation of the element in span s, only reads the <annotation> element if there is one
+        ann read_annotation(xml_span s)
+        {
+            size_t first_child = xml.find('<',xml.find('>',s.begin)) ;
+            if ( xml.compare(first_child,12,"<annotation>") != 0 ) return nullptr ;
+            return ast_xml_reader(xml,first_child,s.end).read_annotation() ;
+        }
+    } ;
+}
+
+#endif //JACK_AST_LAZY_XML_H
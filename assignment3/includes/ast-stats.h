@@ -0,0 +1,233 @@
+#ifndef JACK_AST_STATS_H
+#define JACK_AST_STATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "abstract-syntax-tree.h"
+#include "ast-visitor.h"
+#include "ast-analysis.h"
+
+// Statistics about the size and shape of abstract syntax trees
+//
+// - ast_stats(t) walks a tree once and counts its nodes, strings and annotations
+// - a sub-tree that is reachable more than once, eg shared by an optimised copy, is only counted once
+//   but every extra reference to it is counted as shared
+// - the AST library is precompiled so the bytes per node are an estimate based on each node's fields:
+//   one handle per sub-tree, one int per int or bool field and one std::string per string field
+//
+// - ast_parse_xml_with_stats() and ast_print_as_xml_with_stats() time the library calls and remember
+//   the trees read and printed, if the environment variable JACK_AST_STATS is set a report on them
+//   is written to std::cerr when the program exits, it also lists the VM code codegen would write for each tree
+//   and the cache of every analysis in ast-analysis.h
+
+namespace Jack_Compiler
+{
+    struct ast_statistics
+    {
+        int unique_nodes = 0 ;                  // number of distinct nodes
+        int references = 0 ;                   // number of times a node is reached from its parents, including the root
+        int shared_nodes = 0 ;                  // number of distinct nodes reachable more than once
+        int max_depth = 0 ;                     // the number of nodes on the longest path from the root
+        long string_bytes = 0 ;                 // total characters in string fields
+        long annotated_nodes = 0 ;              // number of nodes with a non-empty annotation
+        long comments = 0 ;                     // total annotation comments
+        long warnings = 0 ;                     // total annotation warnings
+        long errors = 0 ;                       // total annotation errors
+        std::map<ast_kind,int> nodes ;          // distinct nodes by kind
+        std::map<ast_kind,long> bytes ;         // estimated bytes by kind
+    } ;
+
+    // the string fields of t
+    inline std::vector<std::string> ast_string_fields(ast t)
+    {
+        switch(ast_node_kind(t))
+        {
+        case ast_class:             return { get_class_class_name(t) } ;
+        case ast_var_dec:           return { get_var_dec_name(t), get_var_dec_segment(t), get_var_dec_type(t) } ;
+        case ast_var:               return { get_var_name(t), get_var_segment(t), get_var_type(t) } ;
+        case ast_constructor:       return { get_constructor_vtype(t), get_constructor_name(t) } ;
+        case ast_function:          return { get_function_vtype(t), get_function_name(t) } ;
+        case ast_method:            return { get_method_vtype(t), get_method_name(t) } ;
+        case ast_string:            return { get_string_constant(t) } ;
+        case ast_unary_op:          return { get_unary_op_op(t) } ;
+        case ast_infix_op:          return { get_infix_op_op(t) } ;
+        case ast_call_as_function:  return { get_call_as_function_class_name(t) } ;
+        case ast_call_as_method:    return { get_call_as_method_class_name(t) } ;
+        case ast_subr_call:         return { get_subr_call_subr_name(t) } ;
+        default:                    return {} ;
+        }
+    }
+
+    // count the nodes, strings and annotations of the tree t, empty nodes are not counted
+    inline ast_statistics ast_stats(ast t)
+    {
+        ast_statistics stats ;
+
+        // the height and number of references of each distinct node
+        struct seen { int height ; int references ; } ;
+        std::unordered_map<ast,seen> nodes ;
+
+        std::function<int(ast)> visit = [&](ast n)
+        {
+            ast_kind kind = ast_node_kind(n) ;
+            if ( kind == ast_empty ) return 0 ;
+
+            stats.references++ ;
+            auto found = nodes.find(n) ;
+            if ( found != nodes.end() )
+            {
+                if ( found->second.references++ == 1 ) stats.shared_nodes++ ;
+                return found->second.height ;
+            }
+
+            stats.unique_nodes++ ;
+            stats.nodes[kind]++ ;
+
+            long bytes = sizeof(ast) + sizeof(ann) ;
+            for ( auto &s : ast_string_fields(n) )
+            {
+                stats.string_bytes += s.size() ;
+                bytes += sizeof(std::string) + s.size() ;
+            }
+            if ( kind == ast_int || kind == ast_bool || kind == ast_var_dec || kind == ast_var ) bytes += sizeof(int) ;
+
+            ann a = get_ann(n) ;
+            int ncomments = size_of_ann_comments(a) ;
+            int nwarnings = size_of_ann_warnings(a) ;
+            int nerrors = size_of_ann_errors(a) ;
+            if ( ncomments + nwarnings + nerrors > 0 ) stats.annotated_nodes++ ;
+            stats.comments += ncomments ;
+            stats.warnings += nwarnings ;
+            stats.errors += nerrors ;
+
+            int height = 0 ;
+            ast_for_each_child(n,[&](ast child)
+            {
+                bytes += sizeof(ast) ;
+                height = std::max(height,visit(child)) ;
+            }) ;
+
+            stats.bytes[kind] += bytes ;
+            nodes[n] = { height + 1, 1 } ;
+            return height + 1 ;
+        } ;
+
+        stats.max_depth = visit(t) ;
+        return stats ;
+    }
+
+    // write a report of the statistics for a tree to out
+    inline void ast_stats_print(std::ostream &out,std::string label,const ast_statistics &stats)
+    {
+        out << "AST statistics: " << label << "\n" ;
+        out << "  unique nodes:    " << stats.unique_nodes << "\n" ;
+        out << "  references:      " << stats.references << "\n" ;
+        out << "  shared nodes:    " << stats.shared_nodes << "\n" ;
+        out << "  max depth:       " << stats.max_depth << "\n" ;
+        out << "  string bytes:    " << stats.string_bytes << "\n" ;
+        out << "  annotated nodes: " << stats.annotated_nodes << " (" << stats.comments << " comments, "
+            << stats.warnings << " warnings, " << stats.errors << " errors)\n" ;
+        out << "  " << std::left << std::setw(24) << "kind" << std::right << std::setw(10) << "nodes"
+            << std::setw(14) << "est. bytes" << "\n" ;
+        for ( auto &kind : stats.nodes )
+        {
+            out << "  " << std::left << std::setw(24) << ast_kind_to_string(kind.first) << std::right
+                << std::setw(10) << kind.second << std::setw(14) << stats.bytes.at(kind.first) << "\n" ;
+        }
+    }
+
+    //***** timed library calls and the exit report *****//
+
+    // the trees and times to report when the program exits
+    struct ast_stats_log
+    {
+        double parse_seconds = 0 ;
+        double print_seconds = 0 ;
+        int parse_calls = 0 ;
+        int print_calls = 0 ;
+        std::vector<std::pair<std::string,ast>> trees ;
+
+        static ast_stats_log &get()
+        {
+            static ast_stats_log log ;
+            return log ;
+        }
+
+        // true if JACK_AST_STATS is set, the first call registers the exit report
+        // the log is created first so that it is still there when the report runs
+        static bool enabled()
+        {
+            static bool on = std::getenv("JACK_AST_STATS") != nullptr && (get(), std::atexit(report) == 0) ;
+            return on ;
+        }
+
+        static void report()
+        {
+            ast_stats_log &log = get() ;
+            for ( auto &tree : log.trees )
+            {
+                ast_stats_print(std::cerr,tree.first,ast_stats(tree.second)) ;
+                std::cerr << "  VM commands:     " << ast_vm_instruction_count(tree.second) << "\n" ;
+                std::cerr << "  max stack depth: " << ast_max_stack_depth(tree.second) << "\n" ;
+            }
+            for ( auto analysis : ast_analysis_base::registry() )
+            {
+                std::cerr << "analysis " << analysis->name() << ": " << analysis->size() << " cached, "
+                          << analysis->hits() << " hits, " << analysis->misses() << " misses\n" ;
+            }
+            std::cerr << "ast_parse_xml:    " << log.parse_calls << " calls, " << log.parse_seconds << " seconds\n" ;
+            std::cerr << "ast_print_as_xml: " << log.print_calls << " calls, " << log.print_seconds << " seconds\n" ;
+        }
+    } ;
+
+    // ast_parse_xml(), timed and remembered for the exit report
+    inline ast ast_parse_xml_with_stats()
+    {
+        if ( !ast_stats_log::enabled() ) return ast_parse_xml() ;
+
+        auto start = std::chrono::steady_clock::now() ;
+        ast t = ast_parse_xml() ;
+        std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start ;
+
+        ast_stats_log &log = ast_stats_log::get() ;
+        log.parse_seconds += seconds.count() ;
+        log.parse_calls++ ;
+        log.trees.push_back({"ast_parse_xml",t}) ;
+        return t ;
+    }
+
+    // ast_print_as_xml(), timed and remembered for the exit report
+    inline void ast_print_as_xml_with_stats(ast t,int indent_by)
+    {
+        if ( !ast_stats_log::enabled() )
+        {
+            ast_print_as_xml(t,indent_by) ;
+            return ;
+        }
+
+        auto start = std::chrono::steady_clock::now() ;
+        ast_print_as_xml(t,indent_by) ;
+        std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start ;
+
+        ast_stats_log &log = ast_stats_log::get() ;
+        log.print_seconds += seconds.count() ;
+        log.print_calls++ ;
+        log.trees.push_back({"ast_print_as_xml",t}) ;
+    }
+
+    // remember a tree that was not read or printed as XML, eg the tree built by the parser, for the exit report
+    inline void ast_stats_on_exit(std::string label,ast t)
+    {
+        if ( ast_stats_log::enabled() ) ast_stats_log::get().trees.push_back({label,t}) ;
+    }
+}
+
+#endif //JACK_AST_STATS_H
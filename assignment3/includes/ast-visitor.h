@@ -0,0 +1,768 @@
+#ifndef JACK_AST_VISITOR_H
+#define JACK_AST_VISITOR_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include "iobuffer.h"
+#include "abstract-syntax-tree.h"
+
+// Compile time visitors for Jack_Compiler abstract syntax trees
+// - ast_node<K> describes the sub-trees of an AST node of kind K and how to rebuild it
+// - ast_walker<Pass> walks a tree, Pass replaces the walk_*() functions for the nodes it is interested in
+// - ast_rewriter<Pass> copies a tree, Pass replaces the copy_*() functions for the nodes it changes
+// - Pass inherits from ast_walker<Pass> or ast_rewriter<Pass> so all calls are resolved at compile time
+// - Pass must make any replacement walk_*() or copy_*() functions public
+//
+// - a sub-tree that can only be one kind of node is walked or copied without calling ast_node_kind(),
+//   eg the condition of a while statement is always an ast_expr node
+// - a sub-tree that can be one of several kinds of node uses ast_node_kind() to select a walk_*() or copy_*() function,
+//   eg the node inside an ast_term node
+//
+// - the rewriter only creates a new node if one of its sub-trees changed, all other fields are copied unchanged,
+//   otherwise the original node is returned, so unchanged sub-trees are shared with the original tree
+//
+// Example: a pass that counts the while statements in a class
+//
+//     class count_whiles : public ast_walker<count_whiles>
+//     {
+//     public:
+//         int whiles = 0 ;
+//         void walk_while(ast t) { whiles++ ; walk_fields<ast_while>(t) ; }
+//     } ;
+//
+//     count_whiles counter ;
+//     counter.walk(ast_parse_xml()) ;
+//
+// Example: a pass that replaces every null with the integer 0
+//
+//     class null_to_zero : public ast_rewriter<null_to_zero>
+//     {
+//     public:
+//         ast copy_null(ast t) { return create_int(get_ann(t),0) ; }
+//     } ;
+//
+//     ast_print_as_xml(null_to_zero().copy(ast_parse_xml()),2) ;
+
+namespace Jack_Compiler
+{
+    // a sub-tree field of an AST node
+    // Get is the function that returns the sub-tree
+    // K is the kind of node the sub-tree must be or ast_alpha if it can be one of several kinds
+    template <ast (*Get)(ast),ast_kind K> struct ast_slot
+    {
+        static constexpr ast_kind kind = K ;
+        static ast get(ast t) { return Get(t) ; }
+    } ;
+
+    // the list of sub-tree fields of an AST node, in the order they are walked
+    template <class... Slots> struct ast_slots
+    {
+        static constexpr int size = sizeof...(Slots) ;
+    } ;
+
+    // ast_node<K> - the description of an AST node of kind K
+    //
+    // nodes with a fixed number of fields provide:
+    // . is_vector - false
+    // . slots - an ast_slots list of the sub-tree fields
+    // . rebuild(t,...) - return a copy of t with new sub-trees, one per slot, all other fields are copied from t
+    //
+    // vector like nodes provide:
+    // . is_vector - true
+    // . even, odd - the kinds of node at even and odd indices
+    // . size(t), get(t,i) - the number of elements and the element at index i
+    // . create(a,elements) - return a new node with annotation a
+    // . rebuild(t,elements) - return a copy of t with new elements
+    //
+    // the default is a node with no sub-trees
+    template <ast_kind K> struct ast_node
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<> slots ;
+    } ;
+
+    //***** vector like AST nodes *****//
+
+    template <> struct ast_node<ast_class_var_decs>
+    {
+        static constexpr bool is_vector = true ;
+        static constexpr ast_kind even = ast_var_dec ;
+        static constexpr ast_kind odd = ast_var_dec ;
+        static int size(ast t) { return size_of_class_var_decs(t) ; }
+        static ast get(ast t,int i) { return get_class_var_decs(t,i) ; }
+        static ast create(ann a,const vector<ast> &v) { return create_class_var_decs(a,v) ; }
+        static ast rebuild(ast t,const vector<ast> &v) { return create(get_ann(t),v) ; }
+    } ;
+
+    template <> struct ast_node<ast_var_decs>
+    {
+        static constexpr bool is_vector = true ;
+        static constexpr ast_kind even = ast_var_dec ;
+        static constexpr ast_kind odd = ast_var_dec ;
+        static int size(ast t) { return size_of_var_decs(t) ; }
+        static ast get(ast t,int i) { return get_var_decs(t,i) ; }
+        static ast create(ann a,const vector<ast> &v) { return create_var_decs(a,v) ; }
+        static ast rebuild(ast t,const vector<ast> &v) { return create(get_ann(t),v) ; }
+    } ;
+
+    template <> struct ast_node<ast_subr_decs>
+    {
+        static constexpr bool is_vector = true ;
+        static constexpr ast_kind even = ast_subr ;
+        static constexpr ast_kind odd = ast_subr ;
+        static int size(ast t) { return size_of_subr_decs(t) ; }
+        static ast get(ast t,int i) { return get_subr_decs(t,i) ; }
+        static ast create(ann a,const vector<ast> &v) { return create_subr_decs(a,v) ; }
+        static ast rebuild(ast t,const vector<ast> &v) { return create(get_ann(t),v) ; }
+    } ;
+
+    template <> struct ast_node<ast_param_list>
+    {
+        static constexpr bool is_vector = true ;
+        static constexpr ast_kind even = ast_var_dec ;
+        static constexpr ast_kind odd = ast_var_dec ;
+        static int size(ast t) { return size_of_param_list(t) ; }
+        static ast get(ast t,int i) { return get_param_list(t,i) ; }
+        static ast create(ann a,const vector<ast> &v) { return create_param_list(a,v) ; }
+        static ast rebuild(ast t,const vector<ast> &v) { return create(get_ann(t),v) ; }
+    } ;
+
+    template <> struct ast_node<ast_statements>
+    {
+        static constexpr bool is_vector = true ;
+        static constexpr ast_kind even = ast_statement ;
+        static constexpr ast_kind odd = ast_statement ;
+        static int size(ast t) { return size_of_statements(t) ; }
+        static ast get(ast t,int i) { return get_statements(t,i) ; }
+        static ast create(ann a,const vector<ast> &v) { return create_statements(a,v) ; }
+        static ast rebuild(ast t,const vector<ast> &v) { return create(get_ann(t),v) ; }
+    } ;
+
+    template <> struct ast_node<ast_expr_list>
+    {
+        static constexpr bool is_vector = true ;
+        static constexpr ast_kind even = ast_expr ;
+        static constexpr ast_kind odd = ast_expr ;
+        static int size(ast t) { return size_of_expr_list(t) ; }
+        static ast get(ast t,int i) { return get_expr_list(t,i) ; }
+        static ast create(ann a,const vector<ast> &v) { return create_expr_list(a,v) ; }
+        static ast rebuild(ast t,const vector<ast> &v) { return create(get_ann(t),v) ; }
+    } ;
+
+    // terms are at even indices, infix ops are at odd indices
+    template <> struct ast_node<ast_expr>
+    {
+        static constexpr bool is_vector = true ;
+        static constexpr ast_kind even = ast_term ;
+        static constexpr ast_kind odd = ast_infix_op ;
+        static int size(ast t) { return size_of_expr(t) ; }
+        static ast get(ast t,int i) { return get_expr(t,i) ; }
+        static ast create(ann a,const vector<ast> &v) { return create_expr(a,v) ; }
+        static ast rebuild(ast t,const vector<ast> &v) { return create(get_ann(t),v) ; }
+    } ;
+
+    //***** AST nodes with a fixed number of fields *****//
+
+    template <> struct ast_node<ast_class>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_class_var_decs,ast_class_var_decs>,
+                          ast_slot<get_class_subr_decs,ast_subr_decs>> slots ;
+        static ast rebuild(ast t,ast decs,ast subrs)
+        {
+            return create_class(get_ann(t),get_class_class_name(t),decs,subrs) ;
+        }
+    } ;
+
+    template <> struct ast_node<ast_subr>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_subr_subr,ast_alpha>> slots ;
+        static ast rebuild(ast t,ast subr) { return create_subr(get_ann(t),subr) ; }
+    } ;
+
+    template <> struct ast_node<ast_constructor>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_constructor_param_list,ast_param_list>,
+                          ast_slot<get_constructor_subr_body,ast_subr_body>> slots ;
+        static ast rebuild(ast t,ast params,ast body)
+        {
+            return create_constructor(get_ann(t),get_constructor_vtype(t),get_constructor_name(t),params,body) ;
+        }
+    } ;
+
+    template <> struct ast_node<ast_function>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_function_param_list,ast_param_list>,
+                          ast_slot<get_function_subr_body,ast_subr_body>> slots ;
+        static ast rebuild(ast t,ast params,ast body)
+        {
+            return create_function(get_ann(t),get_function_vtype(t),get_function_name(t),params,body) ;
+        }
+    } ;
+
+    template <> struct ast_node<ast_method>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_method_param_list,ast_param_list>,
+                          ast_slot<get_method_subr_body,ast_subr_body>> slots ;
+        static ast rebuild(ast t,ast params,ast body)
+        {
+            return create_method(get_ann(t),get_method_vtype(t),get_method_name(t),params,body) ;
+        }
+    } ;
+
+    template <> struct ast_node<ast_subr_body>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_subr_body_decs,ast_var_decs>,
+                          ast_slot<get_subr_body_body,ast_statements>> slots ;
+        static ast rebuild(ast t,ast decs,ast body) { return create_subr_body(get_ann(t),decs,body) ; }
+    } ;
+
+    template <> struct ast_node<ast_statement>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_statement_statement,ast_alpha>> slots ;
+        static ast rebuild(ast t,ast statement) { return create_statement(get_ann(t),statement) ; }
+    } ;
+
+    template <> struct ast_node<ast_let>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_let_var,ast_var>,
+                          ast_slot<get_let_expr,ast_expr>> slots ;
+        static ast rebuild(ast t,ast var,ast expr) { return create_let(get_ann(t),var,expr) ; }
+    } ;
+
+    template <> struct ast_node<ast_let_array>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_let_array_var,ast_var>,
+                          ast_slot<get_let_array_index,ast_expr>,
+                          ast_slot<get_let_array_expr,ast_expr>> slots ;
+        static ast rebuild(ast t,ast var,ast index,ast expr) { return create_let_array(get_ann(t),var,index,expr) ; }
+    } ;
+
+    template <> struct ast_node<ast_if>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_if_condition,ast_expr>,
+                          ast_slot<get_if_if_true,ast_statements>> slots ;
+        static ast rebuild(ast t,ast condition,ast if_true) { return create_if(get_ann(t),condition,if_true) ; }
+    } ;
+
+    template <> struct ast_node<ast_if_else>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_if_else_condition,ast_expr>,
+                          ast_slot<get_if_else_if_true,ast_statements>,
+                          ast_slot<get_if_else_if_false,ast_statements>> slots ;
+        static ast rebuild(ast t,ast condition,ast if_true,ast if_false)
+        {
+            return create_if_else(get_ann(t),condition,if_true,if_false) ;
+        }
+    } ;
+
+    template <> struct ast_node<ast_while>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_while_condition,ast_expr>,
+                          ast_slot<get_while_body,ast_statements>> slots ;
+        static ast rebuild(ast t,ast condition,ast body) { return create_while(get_ann(t),condition,body) ; }
+    } ;
+
+    template <> struct ast_node<ast_do>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_do_call,ast_alpha>> slots ;
+        static ast rebuild(ast t,ast call) { return create_do(get_ann(t),call) ; }
+    } ;
+
+    template <> struct ast_node<ast_return_expr>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_return_expr,ast_expr>> slots ;
+        static ast rebuild(ast t,ast expr) { return create_return_expr(get_ann(t),expr) ; }
+    } ;
+
+    template <> struct ast_node<ast_term>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_term_term,ast_alpha>> slots ;
+        static ast rebuild(ast t,ast term) { return create_term(get_ann(t),term) ; }
+    } ;
+
+    template <> struct ast_node<ast_unary_op>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_unary_op_term,ast_term>> slots ;
+        static ast rebuild(ast t,ast term) { return create_unary_op(get_ann(t),get_unary_op_op(t),term) ; }
+    } ;
+
+    template <> struct ast_node<ast_array_index>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_array_index_var,ast_var>,
+                          ast_slot<get_array_index_index,ast_expr>> slots ;
+        static ast rebuild(ast t,ast var,ast index) { return create_array_index(get_ann(t),var,index) ; }
+    } ;
+
+    template <> struct ast_node<ast_call_as_function>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_call_as_function_subr_call,ast_subr_call>> slots ;
+        static ast rebuild(ast t,ast subr_call)
+        {
+            return create_call_as_function(get_ann(t),get_call_as_function_class_name(t),subr_call) ;
+        }
+    } ;
+
+    // the var is either an ast_var or an ast_this node
+    template <> struct ast_node<ast_call_as_method>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_call_as_method_var,ast_alpha>,
+                          ast_slot<get_call_as_method_subr_call,ast_subr_call>> slots ;
+        static ast rebuild(ast t,ast var,ast subr_call)
+        {
+            return create_call_as_method(get_ann(t),get_call_as_method_class_name(t),var,subr_call) ;
+        }
+    } ;
+
+    template <> struct ast_node<ast_subr_call>
+    {
+        static constexpr bool is_vector = false ;
+        typedef ast_slots<ast_slot<get_subr_call_expr_list,ast_expr_list>> slots ;
+        static ast rebuild(ast t,ast expr_list)
+        {
+            return create_subr_call(get_ann(t),get_subr_call_subr_name(t),expr_list) ;
+        }
+    } ;
+
+    //***** ast_for_each_child *****//
+
+    template <class F,class... Slots> void ast_for_each_slot(ast t,F &f,ast_slots<Slots...>)
+    {
+        (f(Slots::get(t)), ...) ;
+    }
+
+    // call f(child) for every sub-tree of a node of kind K in order
+    template <ast_kind K,class F> void ast_for_each_child_as(ast t,F &f)
+    {
+        typedef ast_node<K> node ;
+
+        if constexpr ( node::is_vector )
+        {
+            int size = node::size(t) ;
+            for ( int i = 0 ; i < size ; i++ ) f(node::get(t,i)) ;
+        }
+        else
+        {
+            ast_for_each_slot(t,f,typename node::slots()) ;
+        }
+    }
+
+    // call f(child) for every sub-tree of t in order, for passes that treat all nodes alike, eg counting nodes
+    template <class F> void ast_for_each_child(ast t,F f)
+    {
+        switch(ast_node_kind(t))
+        {
+            case ast_class:                  ast_for_each_child_as<ast_class>(t,f) ; return ;
+            case ast_class_var_decs:         ast_for_each_child_as<ast_class_var_decs>(t,f) ; return ;
+            case ast_subr_decs:              ast_for_each_child_as<ast_subr_decs>(t,f) ; return ;
+            case ast_subr:                   ast_for_each_child_as<ast_subr>(t,f) ; return ;
+            case ast_constructor:            ast_for_each_child_as<ast_constructor>(t,f) ; return ;
+            case ast_function:               ast_for_each_child_as<ast_function>(t,f) ; return ;
+            case ast_method:                 ast_for_each_child_as<ast_method>(t,f) ; return ;
+            case ast_param_list:             ast_for_each_child_as<ast_param_list>(t,f) ; return ;
+            case ast_subr_body:              ast_for_each_child_as<ast_subr_body>(t,f) ; return ;
+            case ast_var_decs:               ast_for_each_child_as<ast_var_decs>(t,f) ; return ;
+            case ast_statements:             ast_for_each_child_as<ast_statements>(t,f) ; return ;
+            case ast_statement:              ast_for_each_child_as<ast_statement>(t,f) ; return ;
+            case ast_let:                    ast_for_each_child_as<ast_let>(t,f) ; return ;
+            case ast_let_array:              ast_for_each_child_as<ast_let_array>(t,f) ; return ;
+            case ast_if:                     ast_for_each_child_as<ast_if>(t,f) ; return ;
+            case ast_if_else:                ast_for_each_child_as<ast_if_else>(t,f) ; return ;
+            case ast_while:                  ast_for_each_child_as<ast_while>(t,f) ; return ;
+            case ast_do:                     ast_for_each_child_as<ast_do>(t,f) ; return ;
+            case ast_return_expr:            ast_for_each_child_as<ast_return_expr>(t,f) ; return ;
+            case ast_expr_list:              ast_for_each_child_as<ast_expr_list>(t,f) ; return ;
+            case ast_expr:                   ast_for_each_child_as<ast_expr>(t,f) ; return ;
+            case ast_term:                   ast_for_each_child_as<ast_term>(t,f) ; return ;
+            case ast_unary_op:               ast_for_each_child_as<ast_unary_op>(t,f) ; return ;
+            case ast_array_index:            ast_for_each_child_as<ast_array_index>(t,f) ; return ;
+            case ast_call_as_function:       ast_for_each_child_as<ast_call_as_function>(t,f) ; return ;
+            case ast_call_as_method:         ast_for_each_child_as<ast_call_as_method>(t,f) ; return ;
+            case ast_subr_call:              ast_for_each_child_as<ast_subr_call>(t,f) ; return ;
+        default:                        return ;
+        }
+    }
+
+    //***** ast_walker *****//
+
+    // walk a tree, every walk_*() function walks all the sub-trees of its node by default
+    template <class Pass> class ast_walker
+    {
+    public:
+        // walk any node, ast_node_kind() selects the walk_*() function
+        void walk(ast t)
+        {
+            switch(ast_node_kind(t))
+            {
+            case ast_empty:             return ;
+            case ast_class:             walk_as<ast_class>(t) ; return ;
+            case ast_class_var_decs:    walk_as<ast_class_var_decs>(t) ; return ;
+            case ast_var_dec:           walk_as<ast_var_dec>(t) ; return ;
+            case ast_subr_decs:         walk_as<ast_subr_decs>(t) ; return ;
+            case ast_subr:              walk_as<ast_subr>(t) ; return ;
+            case ast_constructor:       walk_as<ast_constructor>(t) ; return ;
+            case ast_function:          walk_as<ast_function>(t) ; return ;
+            case ast_method:            walk_as<ast_method>(t) ; return ;
+            case ast_param_list:        walk_as<ast_param_list>(t) ; return ;
+            case ast_subr_body:         walk_as<ast_subr_body>(t) ; return ;
+            case ast_var_decs:          walk_as<ast_var_decs>(t) ; return ;
+            case ast_statements:        walk_as<ast_statements>(t) ; return ;
+            case ast_statement:         walk_as<ast_statement>(t) ; return ;
+            case ast_let:               walk_as<ast_let>(t) ; return ;
+            case ast_let_array:         walk_as<ast_let_array>(t) ; return ;
+            case ast_if:                walk_as<ast_if>(t) ; return ;
+            case ast_if_else:           walk_as<ast_if_else>(t) ; return ;
+            case ast_while:             walk_as<ast_while>(t) ; return ;
+            case ast_do:                walk_as<ast_do>(t) ; return ;
+            case ast_return:            walk_as<ast_return>(t) ; return ;
+            case ast_return_expr:       walk_as<ast_return_expr>(t) ; return ;
+            case ast_expr_list:         walk_as<ast_expr_list>(t) ; return ;
+            case ast_expr:              walk_as<ast_expr>(t) ; return ;
+            case ast_term:              walk_as<ast_term>(t) ; return ;
+            case ast_int:               walk_as<ast_int>(t) ; return ;
+            case ast_string:            walk_as<ast_string>(t) ; return ;
+            case ast_bool:              walk_as<ast_bool>(t) ; return ;
+            case ast_null:              walk_as<ast_null>(t) ; return ;
+            case ast_this:              walk_as<ast_this>(t) ; return ;
+            case ast_unary_op:          walk_as<ast_unary_op>(t) ; return ;
+            case ast_var:               walk_as<ast_var>(t) ; return ;
+            case ast_array_index:       walk_as<ast_array_index>(t) ; return ;
+            case ast_call_as_function:  walk_as<ast_call_as_function>(t) ; return ;
+            case ast_call_as_method:    walk_as<ast_call_as_method>(t) ; return ;
+            case ast_subr_call:         walk_as<ast_subr_call>(t) ; return ;
+            case ast_infix_op:          walk_as<ast_infix_op>(t) ; return ;
+            default:
+                CS_IO_Buffers::fatal_error(0,"Unexpected ast node kind") ;
+                return ;
+            }
+        }
+
+        // walk a node of kind K, ast_alpha means the kind is not known until run time
+        template <ast_kind K> void walk_as(ast t)
+        {
+            if constexpr ( K == ast_alpha )                 walk(t) ;
+            else if constexpr ( K == ast_class )            pass().walk_class(t) ;
+            else if constexpr ( K == ast_class_var_decs )   pass().walk_class_var_decs(t) ;
+            else if constexpr ( K == ast_var_dec )          pass().walk_var_dec(t) ;
+            else if constexpr ( K == ast_subr_decs )        pass().walk_subr_decs(t) ;
+            else if constexpr ( K == ast_subr )             pass().walk_subr(t) ;
+            else if constexpr ( K == ast_constructor )      pass().walk_constructor(t) ;
+            else if constexpr ( K == ast_function )         pass().walk_function(t) ;
+            else if constexpr ( K == ast_method )           pass().walk_method(t) ;
+            else if constexpr ( K == ast_param_list )       pass().walk_param_list(t) ;
+            else if constexpr ( K == ast_subr_body )        pass().walk_subr_body(t) ;
+            else if constexpr ( K == ast_var_decs )         pass().walk_var_decs(t) ;
+            else if constexpr ( K == ast_statements )       pass().walk_statements(t) ;
+            else if constexpr ( K == ast_statement )        pass().walk_statement(t) ;
+            else if constexpr ( K == ast_let )              pass().walk_let(t) ;
+            else if constexpr ( K == ast_let_array )        pass().walk_let_array(t) ;
+            else if constexpr ( K == ast_if )               pass().walk_if(t) ;
+            else if constexpr ( K == ast_if_else )          pass().walk_if_else(t) ;
+            else if constexpr ( K == ast_while )            pass().walk_while(t) ;
+            else if constexpr ( K == ast_do )               pass().walk_do(t) ;
+            else if constexpr ( K == ast_return )           pass().walk_return(t) ;
+            else if constexpr ( K == ast_return_expr )      pass().walk_return_expr(t) ;
+            else if constexpr ( K == ast_expr_list )        pass().walk_expr_list(t) ;
+            else if constexpr ( K == ast_expr )             pass().walk_expr(t) ;
+            else if constexpr ( K == ast_term )             pass().walk_term(t) ;
+            else if constexpr ( K == ast_int )              pass().walk_int(t) ;
+            else if constexpr ( K == ast_string )           pass().walk_string(t) ;
+            else if constexpr ( K == ast_bool )             pass().walk_bool(t) ;
+            else if constexpr ( K == ast_null )             pass().walk_null(t) ;
+            else if constexpr ( K == ast_this )             pass().walk_this(t) ;
+            else if constexpr ( K == ast_unary_op )         pass().walk_unary_op(t) ;
+            else if constexpr ( K == ast_var )              pass().walk_var(t) ;
+            else if constexpr ( K == ast_array_index )      pass().walk_array_index(t) ;
+            else if constexpr ( K == ast_call_as_function ) pass().walk_call_as_function(t) ;
+            else if constexpr ( K == ast_call_as_method )   pass().walk_call_as_method(t) ;
+            else if constexpr ( K == ast_subr_call )        pass().walk_subr_call(t) ;
+            else if constexpr ( K == ast_infix_op )         pass().walk_infix_op(t) ;
+            else static_assert(K == ast_alpha,"walk_as: no walk function for this ast_kind") ;
+        }
+
+        // walk all the sub-trees of a node of kind K in order
+        template <ast_kind K> void walk_fields(ast t)
+        {
+            typedef ast_node<K> node ;
+
+            if constexpr ( node::is_vector )
+            {
+                int size = node::size(t) ;
+                for ( int i = 0 ; i < size ; i++ )
+                {
+                    if ( i % 2 == 0 ) walk_as<node::even>(node::get(t,i)) ;
+                    else walk_as<node::odd>(node::get(t,i)) ;
+                }
+            }
+            else
+            {
+                walk_slots(t,typename node::slots()) ;
+            }
+        }
+
+        // the default walk_*() functions, one per node kind
+        void walk_class(ast t) { walk_fields<ast_class>(t) ; }
+        void walk_class_var_decs(ast t) { walk_fields<ast_class_var_decs>(t) ; }
+        void walk_var_dec(ast t) { }
+        void walk_subr_decs(ast t) { walk_fields<ast_subr_decs>(t) ; }
+        void walk_subr(ast t) { walk_fields<ast_subr>(t) ; }
+        void walk_constructor(ast t) { walk_fields<ast_constructor>(t) ; }
+        void walk_function(ast t) { walk_fields<ast_function>(t) ; }
+        void walk_method(ast t) { walk_fields<ast_method>(t) ; }
+        void walk_param_list(ast t) { walk_fields<ast_param_list>(t) ; }
+        void walk_subr_body(ast t) { walk_fields<ast_subr_body>(t) ; }
+        void walk_var_decs(ast t) { walk_fields<ast_var_decs>(t) ; }
+        void walk_statements(ast t) { walk_fields<ast_statements>(t) ; }
+        void walk_statement(ast t) { walk_fields<ast_statement>(t) ; }
+        void walk_let(ast t) { walk_fields<ast_let>(t) ; }
+        void walk_let_array(ast t) { walk_fields<ast_let_array>(t) ; }
+        void walk_if(ast t) { walk_fields<ast_if>(t) ; }
+        void walk_if_else(ast t) { walk_fields<ast_if_else>(t) ; }
+        void walk_while(ast t) { walk_fields<ast_while>(t) ; }
+        void walk_do(ast t) { walk_fields<ast_do>(t) ; }
+        void walk_return(ast t) { }
+        void walk_return_expr(ast t) { walk_fields<ast_return_expr>(t) ; }
+        void walk_expr_list(ast t) { walk_fields<ast_expr_list>(t) ; }
+        void walk_expr(ast t) { walk_fields<ast_expr>(t) ; }
+        void walk_term(ast t) { walk_fields<ast_term>(t) ; }
+        void walk_int(ast t) { }
+        void walk_string(ast t) { }
+        void walk_bool(ast t) { }
+        void walk_null(ast t) { }
+        void walk_this(ast t) { }
+        void walk_unary_op(ast t) { walk_fields<ast_unary_op>(t) ; }
+        void walk_var(ast t) { }
+        void walk_array_index(ast t) { walk_fields<ast_array_index>(t) ; }
+        void walk_call_as_function(ast t) { walk_fields<ast_call_as_function>(t) ; }
+        void walk_call_as_method(ast t) { walk_fields<ast_call_as_method>(t) ; }
+        void walk_subr_call(ast t) { walk_fields<ast_subr_call>(t) ; }
+        void walk_infix_op(ast t) { }
+
+    private:
+        Pass &pass() { return static_cast<Pass &>(*this) ; }
+
+        template <class... Slots> void walk_slots(ast t,ast_slots<Slots...>)
+        {
+            (walk_as<Slots::kind>(Slots::get(t)), ...) ;
+        }
+    } ;
+
+    //***** ast_rewriter *****//
+
+    // copy a tree, every copy_*() function copies all the sub-trees of its node by default
+    // a new node is only created if one of its sub-trees changed, otherwise the original node is returned
+    template <class Pass> class ast_rewriter
+    {
+    public:
+        // copy any node, ast_node_kind() selects the copy_*() function
+        ast copy(ast t)
+        {
+            switch(ast_node_kind(t))
+            {
+            case ast_empty:             return t ;
+            case ast_class:             return copy_as<ast_class>(t) ;
+            case ast_class_var_decs:    return copy_as<ast_class_var_decs>(t) ;
+            case ast_var_dec:           return copy_as<ast_var_dec>(t) ;
+            case ast_subr_decs:         return copy_as<ast_subr_decs>(t) ;
+            case ast_subr:              return copy_as<ast_subr>(t) ;
+            case ast_constructor:       return copy_as<ast_constructor>(t) ;
+            case ast_function:          return copy_as<ast_function>(t) ;
+            case ast_method:            return copy_as<ast_method>(t) ;
+            case ast_param_list:        return copy_as<ast_param_list>(t) ;
+            case ast_subr_body:         return copy_as<ast_subr_body>(t) ;
+            case ast_var_decs:          return copy_as<ast_var_decs>(t) ;
+            case ast_statements:        return copy_as<ast_statements>(t) ;
+            case ast_statement:         return copy_as<ast_statement>(t) ;
+            case ast_let:               return copy_as<ast_let>(t) ;
+            case ast_let_array:         return copy_as<ast_let_array>(t) ;
+            case ast_if:                return copy_as<ast_if>(t) ;
+            case ast_if_else:           return copy_as<ast_if_else>(t) ;
+            case ast_while:             return copy_as<ast_while>(t) ;
+            case ast_do:                return copy_as<ast_do>(t) ;
+            case ast_return:            return copy_as<ast_return>(t) ;
+            case ast_return_expr:       return copy_as<ast_return_expr>(t) ;
+            case ast_expr_list:         return copy_as<ast_expr_list>(t) ;
+            case ast_expr:              return copy_as<ast_expr>(t) ;
+            case ast_term:              return copy_as<ast_term>(t) ;
+            case ast_int:               return copy_as<ast_int>(t) ;
+            case ast_string:            return copy_as<ast_string>(t) ;
+            case ast_bool:              return copy_as<ast_bool>(t) ;
+            case ast_null:              return copy_as<ast_null>(t) ;
+            case ast_this:              return copy_as<ast_this>(t) ;
+            case ast_unary_op:          return copy_as<ast_unary_op>(t) ;
+            case ast_var:               return copy_as<ast_var>(t) ;
+            case ast_array_index:       return copy_as<ast_array_index>(t) ;
+            case ast_call_as_function:  return copy_as<ast_call_as_function>(t) ;
+            case ast_call_as_method:    return copy_as<ast_call_as_method>(t) ;
+            case ast_subr_call:         return copy_as<ast_subr_call>(t) ;
+            case ast_infix_op:          return copy_as<ast_infix_op>(t) ;
+            default:
+                CS_IO_Buffers::fatal_error(0,"Unexpected ast node kind") ;
+                return nullptr ;
+            }
+        }
+
+        // copy a node of kind K, ast_alpha means the kind is not known until run time
+        template <ast_kind K> ast copy_as(ast t)
+        {
+            if constexpr ( K == ast_alpha )                 return copy(t) ;
+            else if constexpr ( K == ast_class )            return pass().copy_class(t) ;
+            else if constexpr ( K == ast_class_var_decs )   return pass().copy_class_var_decs(t) ;
+            else if constexpr ( K == ast_var_dec )          return pass().copy_var_dec(t) ;
+            else if constexpr ( K == ast_subr_decs )        return pass().copy_subr_decs(t) ;
+            else if constexpr ( K == ast_subr )             return pass().copy_subr(t) ;
+            else if constexpr ( K == ast_constructor )      return pass().copy_constructor(t) ;
+            else if constexpr ( K == ast_function )         return pass().copy_function(t) ;
+            else if constexpr ( K == ast_method )           return pass().copy_method(t) ;
+            else if constexpr ( K == ast_param_list )       return pass().copy_param_list(t) ;
+            else if constexpr ( K == ast_subr_body )        return pass().copy_subr_body(t) ;
+            else if constexpr ( K == ast_var_decs )         return pass().copy_var_decs(t) ;
+            else if constexpr ( K == ast_statements )       return pass().copy_statements(t) ;
+            else if constexpr ( K == ast_statement )        return pass().copy_statement(t) ;
+            else if constexpr ( K == ast_let )              return pass().copy_let(t) ;
+            else if constexpr ( K == ast_let_array )        return pass().copy_let_array(t) ;
+            else if constexpr ( K == ast_if )               return pass().copy_if(t) ;
+            else if constexpr ( K == ast_if_else )          return pass().copy_if_else(t) ;
+            else if constexpr ( K == ast_while )            return pass().copy_while(t) ;
+            else if constexpr ( K == ast_do )               return pass().copy_do(t) ;
+            else if constexpr ( K == ast_return )           return pass().copy_return(t) ;
+            else if constexpr ( K == ast_return_expr )      return pass().copy_return_expr(t) ;
+            else if constexpr ( K == ast_expr_list )        return pass().copy_expr_list(t) ;
+            else if constexpr ( K == ast_expr )             return pass().copy_expr(t) ;
+            else if constexpr ( K == ast_term )             return pass().copy_term(t) ;
+            else if constexpr ( K == ast_int )              return pass().copy_int(t) ;
+            else if constexpr ( K == ast_string )           return pass().copy_string(t) ;
+            else if constexpr ( K == ast_bool )             return pass().copy_bool(t) ;
+            else if constexpr ( K == ast_null )             return pass().copy_null(t) ;
+            else if constexpr ( K == ast_this )             return pass().copy_this(t) ;
+            else if constexpr ( K == ast_unary_op )         return pass().copy_unary_op(t) ;
+            else if constexpr ( K == ast_var )              return pass().copy_var(t) ;
+            else if constexpr ( K == ast_array_index )      return pass().copy_array_index(t) ;
+            else if constexpr ( K == ast_call_as_function ) return pass().copy_call_as_function(t) ;
+            else if constexpr ( K == ast_call_as_method )   return pass().copy_call_as_method(t) ;
+            else if constexpr ( K == ast_subr_call )        return pass().copy_subr_call(t) ;
+            else if constexpr ( K == ast_infix_op )         return pass().copy_infix_op(t) ;
+            else static_assert(K == ast_alpha,"copy_as: no copy function for this ast_kind") ;
+        }
+
+        // copy all the sub-trees of a node of kind K
+        // returns t if no sub-tree changed, otherwise a new node with the same annotation and non-tree fields as t
+        template <ast_kind K> ast copy_fields(ast t)
+        {
+            typedef ast_node<K> node ;
+
+            if constexpr ( node::is_vector )
+            {
+                // the copies vector is only filled once the first element changes
+                vector<ast> copies ;
+                bool copied = false ;
+
+                int size = node::size(t) ;
+                for ( int i = 0 ; i < size ; i++ )
+                {
+                    ast element = node::get(t,i) ;
+                    ast copy = i % 2 == 0 ? copy_as<node::even>(element) : copy_as<node::odd>(element) ;
+
+                    if ( !copied )
+                    {
+                        if ( copy == element ) continue ;
+
+                        copied = true ;
+                        copies.reserve(size) ;
+                        for ( int j = 0 ; j < i ; j++ ) copies.push_back(node::get(t,j)) ;
+                    }
+                    copies.push_back(copy) ;
+                }
+
+                if ( !copied ) return t ;
+
+                return node::rebuild(t,copies) ;
+            }
+            else
+            {
+                typedef typename node::slots slots ;
+                return copy_slots<K>(t,slots(),std::make_index_sequence<slots::size>()) ;
+            }
+        }
+
+        // the default copy_*() functions, one per node kind
+        ast copy_class(ast t) { return copy_fields<ast_class>(t) ; }
+        ast copy_class_var_decs(ast t) { return copy_fields<ast_class_var_decs>(t) ; }
+        ast copy_var_dec(ast t) { return t ; }
+        ast copy_subr_decs(ast t) { return copy_fields<ast_subr_decs>(t) ; }
+        ast copy_subr(ast t) { return copy_fields<ast_subr>(t) ; }
+        ast copy_constructor(ast t) { return copy_fields<ast_constructor>(t) ; }
+        ast copy_function(ast t) { return copy_fields<ast_function>(t) ; }
+        ast copy_method(ast t) { return copy_fields<ast_method>(t) ; }
+        ast copy_param_list(ast t) { return copy_fields<ast_param_list>(t) ; }
+        ast copy_subr_body(ast t) { return copy_fields<ast_subr_body>(t) ; }
+        ast copy_var_decs(ast t) { return copy_fields<ast_var_decs>(t) ; }
+        ast copy_statements(ast t) { return copy_fields<ast_statements>(t) ; }
+        ast copy_statement(ast t) { return copy_fields<ast_statement>(t) ; }
+        ast copy_let(ast t) { return copy_fields<ast_let>(t) ; }
+        ast copy_let_array(ast t) { return copy_fields<ast_let_array>(t) ; }
+        ast copy_if(ast t) { return copy_fields<ast_if>(t) ; }
+        ast copy_if_else(ast t) { return copy_fields<ast_if_else>(t) ; }
+        ast copy_while(ast t) { return copy_fields<ast_while>(t) ; }
+        ast copy_do(ast t) { return copy_fields<ast_do>(t) ; }
+        ast copy_return(ast t) { return t ; }
+        ast copy_return_expr(ast t) { return copy_fields<ast_return_expr>(t) ; }
+        ast copy_expr_list(ast t) { return copy_fields<ast_expr_list>(t) ; }
+        ast copy_expr(ast t) { return copy_fields<ast_expr>(t) ; }
+        ast copy_term(ast t) { return copy_fields<ast_term>(t) ; }
+        ast copy_int(ast t) { return t ; }
+        ast copy_string(ast t) { return t ; }
+        ast copy_bool(ast t) { return t ; }
+        ast copy_null(ast t) { return t ; }
+        ast copy_this(ast t) { return t ; }
+        ast copy_unary_op(ast t) { return copy_fields<ast_unary_op>(t) ; }
+        ast copy_var(ast t) { return t ; }
+        ast copy_array_index(ast t) { return copy_fields<ast_array_index>(t) ; }
+        ast copy_call_as_function(ast t) { return copy_fields<ast_call_as_function>(t) ; }
+        ast copy_call_as_method(ast t) { return copy_fields<ast_call_as_method>(t) ; }
+        ast copy_subr_call(ast t) { return copy_fields<ast_subr_call>(t) ; }
+        ast copy_infix_op(ast t) { return t ; }
+
+    private:
+        Pass &pass() { return static_cast<Pass &>(*this) ; }
+
+        template <ast_kind K,class... Slots,size_t... I>
+        ast copy_slots(ast t,ast_slots<Slots...>,std::index_sequence<I...>)
+        {
+            if constexpr ( sizeof...(Slots) == 0 )
+            {
+                return t ;
+            }
+            else
+            {
+                ast fields[] = { Slots::get(t)... } ;
+                ast copies[] = { copy_as<Slots::kind>(fields[I])... } ;
+
+                if ( ((copies[I] == fields[I]) && ...) ) return t ;
+
+                return ast_node<K>::rebuild(t,copies[I]...) ;
+            }
+        }
+    } ;
+}
+
+#endif //JACK_AST_VISITOR_H
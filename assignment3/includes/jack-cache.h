@@ -0,0 +1,254 @@
+#ifndef JACK_CACHE_H
+#define JACK_CACHE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "abstract-syntax-tree.h"
+#include "ast-binary.h"
+#include "ast-visitor.h"
+
+// A content addressed cache of compiled Jack classes, for rebuilding a project after a few classes change
+//
+// - an entry is found by a key, the hash of the class's source, the compiler version and the compiler options,
+//   an entry can only be found again if none of these have changed
+// - an entry records the class's VM code
+// - an entry also records the signature of every subroutine the class declares and the signature seen
+//   when it was compiled of every subroutine in another class that it calls
+// - an entry is only valid while every subroutine it calls still has the same signature, so changing a
+//   subroutine's parameters invalidates the classes that call it but changing its body does not
+// - each entry is a file in the cache directory named after its key, the files are written to a temporary
+//   name and renamed so that a partly written entry is never read, an entry that cannot be read is not found
+//
+// Example:
+//
+//     jack_cache cache(".jackc-cache","--optimise") ;
+//     jack_cache_entry entry ;
+//     if ( !cache.find(cache.key_of(source),entry) ) ... compile the class and cache.store(entry) ...
+//     write_to_output(entry.vm) ;
+
+namespace Jack_Compiler
+{
+    // the version of the compiler, it is part of every key, jackc is rebuilt whenever any pass changes
+    static const std::string jack_cache_version = "jackc-cache 2 " __DATE__ " " __TIME__ ;
+
+    // 64 bit FNV-1a hash of s, continuing from hash
+    inline uint64_t jack_hash(const std::string &s,uint64_t hash = 14695981039346656037ull)
+    {
+        for ( unsigned char c : s )
+        {
+            hash ^= c ;
+            hash *= 1099511628211ull ;
+        }
+        return hash ;
+    }
+
+    // the signature of an ast_subr node's subroutine: its kind, return type and number of parameters, eg "method int 2"
+    inline std::string jack_subr_signature(ast subr)
+    {
+        ast s = get_subr_subr(subr) ;
+        switch(ast_node_kind(s))
+        {
+        case ast_constructor:
+            return "constructor " + get_constructor_vtype(s) + " " + std::to_string(size_of_param_list(get_constructor_param_list(s))) ;
+        case ast_function:
+            return "function " + get_function_vtype(s) + " " + std::to_string(size_of_param_list(get_function_param_list(s))) ;
+        default:
+            return "method " + get_method_vtype(s) + " " + std::to_string(size_of_param_list(get_method_param_list(s))) ;
+        }
+    }
+
+    // the name of an ast_subr node's subroutine
+    inline std::string jack_subr_name(ast subr)
+    {
+        ast s = get_subr_subr(subr) ;
+        switch(ast_node_kind(s))
+        {
+        case ast_constructor: return get_constructor_name(s) ;
+        case ast_function:    return get_function_name(s) ;
+        default:              return get_method_name(s) ;
+        }
+    }
+
+    // the calls in a class to subroutines of other classes, as "class_name.subr_name"
+    class jack_external_calls : public ast_walker<jack_external_calls>
+    {
+    public:
+        std::string class_name ;
+        std::map<std::string,std::string> calls ;
+
+        void walk_class(ast t)
+        {
+            class_name = get_class_class_name(t) ;
+            walk_fields<ast_class>(t) ;
+        }
+
+        void walk_call_as_function(ast t)
+        {
+            add(get_call_as_function_class_name(t),get_call_as_function_subr_call(t)) ;
+            walk_fields<ast_call_as_function>(t) ;
+        }
+
+        void walk_call_as_method(ast t)
+        {
+            add(get_call_as_method_class_name(t),get_call_as_method_subr_call(t)) ;
+            walk_fields<ast_call_as_method>(t) ;
+        }
+
+    private:
+        void add(const std::string &callee,ast subr_call)
+        {
+            if ( callee != class_name ) calls[callee + "." + get_subr_call_subr_name(subr_call)] = "" ;
+        }
+    } ;
+
+    // a compiled class
+    struct jack_cache_entry
+    {
+        uint64_t key = 0 ;                              // the key it is stored under
+        std::string class_name ;                        // the name of the class
+        std::map<std::string,std::string> subrs ;       // the signature of each subroutine it declares, by name
+        std::map<std::string,std::string> uses ;        // the signature of each subroutine of another class it calls
+                                                        // by "class_name.subr_name", "" if it was not known
+        std::string vm ;                                // the VM code
+
+        // an entry for the final AST of a class and its VM code, the signatures in uses are not known yet
+        jack_cache_entry() {}
+        jack_cache_entry(uint64_t key,ast t,std::string vm) : key(key), vm(std::move(vm))
+        {
+            class_name = get_class_class_name(t) ;
+
+            ast decs = get_class_subr_decs(t) ;
+            int ndecs = size_of_subr_decs(decs) ;
+            for ( int i = 0 ; i < ndecs ; i++ )
+                subrs[jack_subr_name(get_subr_decs(decs,i))] = jack_subr_signature(get_subr_decs(decs,i)) ;
+
+            jack_external_calls calls ;
+            calls.walk(t) ;
+            uses = calls.calls ;
+        }
+    } ;
+
+    // the signatures of every subroutine of a set of classes, by "class_name.subr_name"
+    typedef std::map<std::string,std::string> jack_signatures ;
+
+    // true if every subroutine the class calls still has the signature it had when the class was compiled
+    inline bool jack_uses_unchanged(const jack_cache_entry &entry,const jack_signatures &signatures)
+    {
+        for ( auto &use : entry.uses )
+        {
+            auto now = signatures.find(use.first) ;
+            if ( use.second != (now == signatures.end() ? "" : now->second) ) return false ;
+        }
+        return true ;
+    }
+
+    // record the current signatures of the subroutines the class calls
+    inline void jack_record_uses(jack_cache_entry &entry,const jack_signatures &signatures)
+    {
+        for ( auto &use : entry.uses )
+        {
+            auto now = signatures.find(use.first) ;
+            use.second = now == signatures.end() ? "" : now->second ;
+        }
+    }
+
+    // the cache directory for one set of compiler options
+    class jack_cache
+    {
+    public:
+        // the directory is created if it does not exist
+        jack_cache(std::string directory,std::string options) : directory(directory), options(options)
+        {
+            mkdir(directory.c_str(),0777) ;
+        }
+
+        // the key for a class with the given source
+        uint64_t key_of(const std::string &source) const
+        {
+            return jack_hash(source,jack_hash(options + '\n',jack_hash(jack_cache_version + '\n'))) ;
+        }
+
+        // read the entry for key, returns false if there is no entry or it cannot be read
+        bool find(uint64_t key,jack_cache_entry &entry) const
+        {
+            std::ifstream file(path_of(key),std::ios::binary) ;
+            if ( !file ) return false ;
+
+            std::stringstream contents ;
+            contents << file.rdbuf() ;
+            std::string bytes = contents.str() ;
+            if ( bytes.compare(0,magic.size(),magic) != 0 ) return false ;
+
+            // a truncated or corrupt file is a miss, not an error
+            ast_binary_reader in(bytes,magic.size(),bytes.size(),false) ;
+            entry.key = in.read_number() ;
+            if ( entry.key != key ) return false ;
+
+            entry.class_name = in.read_string() ;
+            entry.subrs = read_map(in) ;
+            entry.uses = read_map(in) ;
+            entry.vm = in.read_string() ;
+            return !in.failed() && in.position() == bytes.size() ;
+        }
+
+        // write an entry, replacing any entry with the same key
+        void store(const jack_cache_entry &entry) const
+        {
+            std::string bytes = magic ;
+            ast_binary_writer out(bytes) ;
+            out.write_number(entry.key) ;
+            out.write_string(entry.class_name) ;
+            write_map(out,entry.subrs) ;
+            write_map(out,entry.uses) ;
+            out.write_string(entry.vm) ;
+
+            std::string path = path_of(entry.key) ;
+            std::string temporary = path + "." + std::to_string(getpid()) ;
+            std::ofstream file(temporary,std::ios::binary) ;
+            file.write(bytes.data(),bytes.size()) ;
+            file.close() ;
+            if ( !file || std::rename(temporary.c_str(),path.c_str()) != 0 ) std::remove(temporary.c_str()) ;
+        }
+
+    private:
+        const std::string magic = "jackc-cache 2\n" ;
+        std::string directory ;
+        std::string options ;
+
+        std::string path_of(uint64_t key) const
+        {
+            char name[17] ;
+            snprintf(name,sizeof(name),"%016llx",(unsigned long long)key) ;
+            return directory + "/" + name ;
+        }
+
+        static void write_map(ast_binary_writer &out,const std::map<std::string,std::string> &map)
+        {
+            out.write_number(map.size()) ;
+            for ( auto &item : map )
+            {
+                out.write_string(item.first) ;
+                out.write_string(item.second) ;
+            }
+        }
+
+        static std::map<std::string,std::string> read_map(ast_binary_reader &in)
+        {
+            std::map<std::string,std::string> map ;
+            for ( unsigned long long n = in.read_number() ; n > 0 && !in.failed() ; n-- )
+            {
+                std::string name = in.read_string() ;
+                map[name] = in.read_string() ;
+            }
+            return map ;
+        }
+    } ;
+}
+
+#endif //JACK_CACHE_H
@@ -0,0 +1,416 @@
+#ifndef JACK_JACK_DOCUMENT_H
+#define JACK_JACK_DOCUMENT_H
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+#include "abstract-syntax-tree.h"
+#include "ast-visitor.h"
+#include "keywords.h"
+#include "tokeniser.h"
+
+// Incremental re-parsing of a Jack class that is being edited
+//
+// - a jack_document holds the source text of one class and the AST that was last parsed from it
+// - the source is skimmed to record the byte offsets of the class header, ie everything before the first
+//   subroutine, and of each subroutine, the skim only tracks comments, strings and braces, it creates no AST nodes
+// - an edit replaces a range of bytes, the damaged subroutine is re-skimmed from its first token until its
+//   closing '}', if that '}' is where the old one moved to the token stream has resynchronised and only that
+//   subroutine is re-parsed, otherwise the rest of the class is re-skimmed
+// - ASTs are immutable so the AST of every subroutine whose text did not change is reused as it is and
+//   the class node is rebuilt around them
+// - a change to the class header changes the symbol table of every subroutine so the whole class is re-parsed
+//
+// The parser is passed in as a function that parses the text of a whole class, a subroutine is parsed as
+// the class header followed by the subroutine, with the text in between blanked out so that line numbers
+// and columns in error messages match the document.
+//
+// Example:
+//
+//     jack_document doc(parse_class_text) ;
+//     doc.open(text) ;
+//     doc.edit(120,125,"while") ;
+//     if ( doc.errors() == "" ) jack_codegen(doc.tree()) ;
+//
+namespace Jack_Compiler
+{
+    // a Jack token found by skimming, the kind is tk_eoi at the end of the text
+    // and tk_oops for an unterminated comment or string or a character that cannot start a token
+    struct jack_skim_token
+    {
+        TokenKind kind ;
+        int offset ;
+        int length ;
+    } ;
+
+    // read tokens from Jack source text starting at any offset outside of a comment or string
+    class jack_skimmer
+    {
+    public:
+        jack_skimmer(const std::string &text,int pos) : text(text), pos(pos) {}
+
+        jack_skim_token next()
+        {
+            if ( !skip_wspace_and_comments() ) return fail() ;
+            jack_skim_token t = { tk_oops, pos, 0 } ;
+            if ( pos < 0 ) return t ;
+
+            int end = text.size() ;
+            if ( pos >= end )
+            {
+                t.kind = tk_eoi ;
+                return t ;
+            }
+
+            char c = text[pos] ;
+            if ( is_letter(c) )
+            {
+                while ( pos < end && (is_letter(text[pos]) || is_digit(text[pos])) ) pos++ ;
+                t.kind = keywords.find(text.data() + t.offset,pos - t.offset,tk_identifier) ;
+            }
+            else
+            if ( is_digit(c) )
+            {
+                while ( pos < end && is_digit(text[pos]) ) pos++ ;
+                t.kind = tk_integerConstant ;
+            }
+            else
+            if ( c == '"' )
+            {
+                int close = pos + 1 ;
+                while ( close < end && text[close] != '"' && text[close] != '\n' ) close++ ;
+                if ( close == end || text[close] != '"' ) return fail() ;
+                pos = close + 1 ;
+                t.kind = tk_stringConstant ;
+            }
+            else
+            {
+                t.kind = symbol(c) ;
+                if ( t.kind == tk_oops ) return fail() ;
+                pos++ ;
+            }
+
+            t.length = pos - t.offset ;
+            return t ;
+        }
+
+        // offset of the next character to be skimmed
+        int position() const { return pos ; }
+
+        // continue skimming from offset p, it must be outside of a comment or string
+        void skip_to(int p) { pos = p ; }
+
+    private:
+        const std::string &text ;
+        int pos ;                       // offset of the next character, -1 after an error
+
+        static bool is_letter(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ; }
+        static bool is_digit(char c) { return c >= '0' && c <= '9' ; }
+
+        jack_skim_token fail()
+        {
+            jack_skim_token t = { tk_oops, pos, 0 } ;
+            pos = -1 ;
+            return t ;
+        }
+
+        // returns false if a /* comment is not closed, pos is left at the /*
+        bool skip_wspace_and_comments()
+        {
+            int end = text.size() ;
+            while ( pos >= 0 && pos < end )
+            {
+                char c = text[pos] ;
+                if ( c == ' ' || c == '\t' || c == '\r' || c == '\n' ) pos++ ;
+                else
+                if ( c == '/' && pos + 1 < end && text[pos + 1] == '/' )
+                {
+                    size_t eol = text.find('\n',pos) ;
+                    pos = eol == std::string::npos ? end : eol + 1 ;
+                }
+                else
+                if ( c == '/' && pos + 1 < end && text[pos + 1] == '*' )
+                {
+                    size_t close = text.find("*/",pos + 2) ;
+                    if ( close == std::string::npos ) return false ;
+                    pos = close + 2 ;
+                }
+                else return true ;
+            }
+            return true ;
+        }
+
+        static TokenKind symbol(char c)
+        {
+            switch(c)
+            {
+            case '{': return tk_lcb ;
+            case '}': return tk_rcb ;
+            case '(': return tk_lrb ;
+            case ')': return tk_rrb ;
+            case '[': return tk_lsb ;
+            case ']': return tk_rsb ;
+            case '.': return tk_stop ;
+            case ',': return tk_comma ;
+            case ';': return tk_semi ;
+            case '+': return tk_add ;
+            case '-': return tk_sub ;
+            case '*': return tk_times ;
+            case '/': return tk_divide ;
+            case '&': return tk_and ;
+            case '|': return tk_or ;
+            case '<': return tk_lt ;
+            case '>': return tk_gt ;
+            case '=': return tk_eq ;
+            case '~': return tk_not ;
+            default:  return tk_oops ;
+            }
+        }
+    } ;
+
+    // the source text and AST of one Jack class
+    class jack_document
+    {
+    public:
+        // parse the text of a whole class, return the class AST or nullptr and set errors
+        typedef std::function<ast(const std::string &text,std::string &errors)> class_parser ;
+
+        explicit jack_document(class_parser parser) : parser(parser), header_end(-1), class_tree(nullptr),
+                                                      last_good(nullptr), nparsed(0) {}
+
+        // replace the whole document, the class is skimmed and parsed
+        // returns false if it could not be parsed, errors() describes why
+        bool open(std::string text)
+        {
+            source = std::move(text) ;
+            skim(source,header_end,spans) ;
+            return parse_class() ;
+        }
+
+        // replace the bytes from begin up to end with replacement and re-parse what the edit damaged
+        // returns false if the range is not in the document or the class could not be parsed
+        bool edit(int begin,int end,const std::string &replacement)
+        {
+            if ( begin < 0 || begin > end || end > (int)source.size() )
+            {
+                error_text = "edit range " + std::to_string(begin) + " to " + std::to_string(end) + " is not in the document\n" ;
+                return false ;
+            }
+
+            std::string old_header = source.substr(0,std::max(header_end,0)) ;
+            std::vector<subr_span> old_spans = std::move(spans) ;
+            int delta = replacement.size() - (end - begin) ;
+            source.replace(begin,end - begin,replacement) ;
+            nparsed = 0 ;
+
+            // an edit inside one subroutine that still closes where its old '}' moved to only damages that subroutine
+            int i = enclosing_subr(old_spans,begin,end) ;
+            if ( i >= 0 && skim_subr(source,old_spans[i].begin) == old_spans[i].end + delta )
+            {
+                spans = std::move(old_spans) ;
+                spans[i].end += delta ;
+                for ( int j = i + 1 ; j < (int)spans.size() ; j++ )
+                {
+                    spans[j].begin += delta ;
+                    spans[j].end += delta ;
+                }
+                parse_subr(i) ;
+                return build() ;
+            }
+
+            // otherwise skim the whole class again, if the header has changed every subroutine must be re-parsed
+            if ( !skim(source,header_end,spans) || source.compare(0,header_end,old_header) != 0 ) return parse_class() ;
+
+            // reuse the AST of every subroutine that lies wholly before or after the edit, re-parse the rest
+            for ( int j = 0 ; j < (int)spans.size() ; j++ )
+            {
+                const subr_span *old = reused(old_spans,spans[j],begin,end,delta) ;
+                if ( old != nullptr )
+                {
+                    spans[j].tree = old->tree ;
+                    spans[j].errors = old->errors ;
+                }
+                else parse_subr(j) ;
+            }
+            return build() ;
+        }
+
+        // the source text
+        const std::string &text() const { return source ; }
+
+        // the AST of the class the last time it was parsed without errors or nullptr
+        ast tree() const { return last_good ; }
+
+        // the error messages from the last open() or edit(), "" if there were none
+        std::string errors() const { return error_text ; }
+
+        // the number of subroutines in the class and the number that the last open() or edit() parsed
+        int size_of_subrs() const { return spans.size() ; }
+        int parsed_subrs() const { return nparsed ; }
+
+    private:
+        // a subroutine from the first character of its 'constructor', 'function' or 'method' keyword
+        // to just after its closing '}', its AST or nullptr if it has not been parsed without errors
+        // and the errors from the last time it was parsed
+        struct subr_span
+        {
+            int begin ;
+            int end ;
+            ast tree ;
+            std::string errors ;
+        } ;
+
+        class_parser parser ;
+        std::string source ;            // the text of the class
+        int header_end ;                // offset of the first subroutine, or of the class's closing '}', or -1
+        std::vector<subr_span> spans ;  // every subroutine in the order they appear
+        ast class_tree ;                // a class node with the current header, any subr decs
+        ast last_good ;                 // the last complete AST
+        std::string error_text ;        // errors from the last update
+        int nparsed ;                   // the number of subroutines parsed by the last update
+
+        // skim a subroutine starting at the keyword at offset begin, return the offset after its closing '}' or -1
+        static int skim_subr(const std::string &text,int begin)
+        {
+            jack_skimmer skimmer(text,begin) ;
+            jack_skim_token t = skimmer.next() ;
+            if ( t.kind != tk_constructor && t.kind != tk_function && t.kind != tk_method ) return -1 ;
+
+            int depth = 0 ;
+            for ( t = skimmer.next() ; t.kind != tk_eoi && t.kind != tk_oops ; t = skimmer.next() )
+            {
+                if ( t.kind == tk_lcb ) depth++ ;
+                else
+                if ( t.kind == tk_rcb && --depth == 0 ) return skimmer.position() ;
+                else
+                if ( depth == 0 && (t.kind == tk_constructor || t.kind == tk_function || t.kind == tk_method) ) return -1 ;
+            }
+            return -1 ;
+        }
+
+        // skim a whole class, recording the end of its header and the span of each subroutine
+        // returns false if the braces do not match or a token cannot be formed
+        static bool skim(const std::string &text,int &header_end,std::vector<subr_span> &spans)
+        {
+            header_end = -1 ;
+            spans.clear() ;
+
+            jack_skimmer skimmer(text,0) ;
+            jack_skim_token t = skimmer.next() ;
+            for ( int depth = 0 ; t.kind != tk_eoi && t.kind != tk_oops ; t = skimmer.next() )
+            {
+                if ( depth == 1 && (t.kind == tk_constructor || t.kind == tk_function || t.kind == tk_method) )
+                {
+                    int end = skim_subr(text,t.offset) ;
+                    if ( end < 0 ) return false ;
+                    if ( header_end < 0 ) header_end = t.offset ;
+                    spans.push_back({ t.offset, end, nullptr, "" }) ;
+                    skimmer.skip_to(end) ;
+                }
+                else
+                if ( t.kind == tk_lcb ) depth++ ;
+                else
+                if ( t.kind == tk_rcb && --depth == 0 )
+                {
+                    if ( header_end < 0 ) header_end = t.offset ;
+                    return skimmer.next().kind == tk_eoi ;
+                }
+            }
+            return false ;
+        }
+
+        // the index of the subroutine that contains all of the bytes from begin to end or -1
+        static int enclosing_subr(const std::vector<subr_span> &spans,int begin,int end)
+        {
+            for ( int i = 0 ; i < (int)spans.size() ; i++ )
+            {
+                if ( spans[i].begin <= begin && end <= spans[i].end ) return i ;
+            }
+            return -1 ;
+        }
+
+        // the old span of subroutine s if the edit did not touch its text, otherwise nullptr
+        static const subr_span *reused(const std::vector<subr_span> &old_spans,const subr_span &s,int begin,int end,int delta)
+        {
+            for ( auto &old : old_spans )
+            {
+                if ( old.end <= begin && old.begin == s.begin && old.end == s.end ) return &old ;
+                if ( old.begin >= end && old.begin + delta == s.begin && old.end + delta == s.end ) return &old ;
+            }
+            return nullptr ;
+        }
+
+        // parse the whole class and split its subr decs between the subroutine spans
+        // if the skim does not agree with the parser the spans are dropped so the next edit parses the whole class
+        bool parse_class()
+        {
+            error_text = "" ;
+            nparsed = 0 ;
+            for ( auto &s : spans )
+            {
+                s.tree = nullptr ;
+                s.errors = "" ;
+            }
+
+            ast t = parser(source,error_text) ;
+            if ( t == nullptr ) return false ;
+
+            class_tree = t ;
+            ast subrs = get_class_subr_decs(t) ;
+            if ( size_of_subr_decs(subrs) == (int)spans.size() )
+            {
+                for ( int i = 0 ; i < (int)spans.size() ; i++ ) spans[i].tree = get_subr_decs(subrs,i) ;
+            }
+            else
+            {
+                header_end = -1 ;
+                spans.clear() ;
+            }
+            nparsed = size_of_subr_decs(subrs) ;
+            last_good = t ;
+            return true ;
+        }
+
+        // parse subroutine i on its own as the only subroutine of the class, its tree is nullptr if it has errors
+        void parse_subr(int i)
+        {
+            nparsed++ ;
+
+            // blank out everything between the header and the subroutine but keep the line breaks
+            std::string text = source.substr(0,header_end) ;
+            for ( int c = header_end ; c < spans[i].begin ; c++ ) text += source[c] == '\n' ? '\n' : ' ' ;
+            text.append(source,spans[i].begin,spans[i].end - spans[i].begin) ;
+            text += "\n}\n" ;
+
+            spans[i].errors = "" ;
+            ast t = parser(text,spans[i].errors) ;
+            spans[i].tree = t == nullptr ? nullptr : get_subr_decs(get_class_subr_decs(t),0) ;
+            if ( t != nullptr ) class_tree = t ;
+        }
+
+        // rebuild the class around the subroutine ASTs, the tree is only replaced if every subroutine has one
+        bool build()
+        {
+            error_text = "" ;
+            std::vector<ast> subrs ;
+            bool unknown = class_tree == nullptr ;
+            for ( auto &s : spans )
+            {
+                error_text += s.errors ;
+                if ( s.tree == nullptr && s.errors == "" ) unknown = true ;
+                subrs.push_back(s.tree) ;
+            }
+            if ( error_text != "" ) return false ;
+
+            // a subroutine that has never been parsed on its own because the last whole class parse failed
+            if ( unknown ) return parse_class() ;
+
+            ast decs = ast_node<ast_subr_decs>::rebuild(get_class_subr_decs(class_tree),subrs) ;
+            last_good = ast_node<ast_class>::rebuild(class_tree,get_class_var_decs(class_tree),decs) ;
+            return true ;
+        }
+    } ;
+}
+
+#endif //JACK_JACK_DOCUMENT_H
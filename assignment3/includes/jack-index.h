@@ -0,0 +1,205 @@
+#ifndef JACK_INDEX_H
+#define JACK_INDEX_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include "ast-binary.h"
+#include "jack-document.h"
+
+// A whole program index of the classes of a Jack project and the signatures of their subroutines
+//
+// - a pass working on one class cannot tell if Foo.bar() is a function or a method, or how many arguments
+//   it takes, the index records this for every class in the project
+// - skim_class() builds a class's entry by skimming its source with a jack_skimmer, it only reads the class
+//   name and each subroutine's kind, return type, name and parameter list, the bodies are skipped by counting
+//   braces and no AST nodes are created
+// - the index is stored in a compact binary file, see write() for the format
+// - jackc builds the index for a project before compiling its classes, the passes find it by calling
+//   jack_project_index(), a pass run on its own reads the index file named by the environment variable JACK_INDEX
+//
+// Example:
+//
+//     jack_index index ;
+//     index.skim_class(text_of_Foo) ;
+//     const jack_subr_info *bar = index.find("Foo","bar") ;
+//     if ( bar != nullptr && bar->kind == tk_method ) ...
+//
+namespace Jack_Compiler
+{
+    // the signature of a subroutine
+    struct jack_subr_info
+    {
+        TokenKind kind ;                // tk_constructor, tk_function or tk_method
+        std::string vtype ;             // the return type
+        int params ;                    // the number of parameters
+
+        // the same as jack_subr_signature() in jack-cache.h, eg "method int 2"
+        std::string signature() const
+        {
+            std::string k = kind == tk_constructor ? "constructor" : kind == tk_function ? "function" : "method" ;
+            return k + " " + vtype + " " + std::to_string(params) ;
+        }
+    } ;
+
+    class jack_index
+    {
+    public:
+        // the number of classes
+        int size() const { return classes.size() ; }
+
+        // true if the class is in the index
+        bool has_class(const std::string &class_name) const { return classes.count(class_name) > 0 ; }
+
+        // the signature of a subroutine or nullptr if it is not in the index
+        const jack_subr_info *find(const std::string &class_name,const std::string &subr_name) const
+        {
+            auto c = classes.find(class_name) ;
+            if ( c == classes.end() ) return nullptr ;
+            auto s = c->second.find(subr_name) ;
+            return s == c->second.end() ? nullptr : &s->second ;
+        }
+
+        // the signature of every subroutine by "class_name.subr_name"
+        std::map<std::string,std::string> signatures() const
+        {
+            std::map<std::string,std::string> all ;
+            for ( auto &c : classes )
+                for ( auto &s : c.second ) all[c.first + "." + s.first] = s.second.signature() ;
+            return all ;
+        }
+
+        // add or replace the entry for the class in text, returns false and changes nothing if
+        // the text does not start with a class declaration whose braces match
+        bool skim_class(const std::string &text)
+        {
+            jack_skimmer skimmer(text,0) ;
+            if ( skimmer.next().kind != tk_class ) return false ;
+
+            jack_skim_token name = skimmer.next() ;
+            if ( name.kind != tk_identifier || skimmer.next().kind != tk_lcb ) return false ;
+
+            std::map<std::string,jack_subr_info> subrs ;
+            for ( jack_skim_token t = skimmer.next() ; t.kind != tk_rcb ; t = skimmer.next() )
+            {
+                if ( t.kind == tk_eoi || t.kind == tk_oops ) return false ;
+                if ( t.kind != tk_constructor && t.kind != tk_function && t.kind != tk_method ) continue ;
+
+                jack_skim_token vtype = skimmer.next() ;
+                jack_skim_token subr = skimmer.next() ;
+                if ( subr.kind != tk_identifier || skimmer.next().kind != tk_lrb ) return false ;
+
+                // the parameters are separated by commas
+                int params = 0 ;
+                jack_skim_token p = skimmer.next() ;
+                if ( p.kind != tk_rrb ) params = 1 ;
+                for ( ; p.kind != tk_rrb ; p = skimmer.next() )
+                {
+                    if ( p.kind == tk_eoi || p.kind == tk_oops ) return false ;
+                    if ( p.kind == tk_comma ) params++ ;
+                }
+
+                // skip the body
+                if ( skimmer.next().kind != tk_lcb ) return false ;
+                for ( int depth = 1 ; depth > 0 ; )
+                {
+                    jack_skim_token b = skimmer.next() ;
+                    if ( b.kind == tk_eoi || b.kind == tk_oops ) return false ;
+                    if ( b.kind == tk_lcb ) depth++ ;
+                    if ( b.kind == tk_rcb ) depth-- ;
+                }
+
+                subrs[text.substr(subr.offset,subr.length)] = { t.kind, text.substr(vtype.offset,vtype.length), params } ;
+            }
+
+            classes[text.substr(name.offset,name.length)] = subrs ;
+            return true ;
+        }
+
+        // write the index to a file, returns false if it could not be written
+        // the format is a magic line followed by the number of classes, then for each class its name and
+        // number of subroutines, then for each subroutine its name, a kind byte, its return type and number of
+        // parameters, numbers and strings are encoded as in ast-binary.h
+        bool write(const std::string &path) const
+        {
+            std::string bytes = magic ;
+            ast_binary_writer out(bytes) ;
+            out.write_number(classes.size()) ;
+            for ( auto &c : classes )
+            {
+                out.write_string(c.first) ;
+                out.write_number(c.second.size()) ;
+                for ( auto &s : c.second )
+                {
+                    out.write_string(s.first) ;
+                    out.write_number(s.second.kind == tk_constructor ? 0 : s.second.kind == tk_function ? 1 : 2) ;
+                    out.write_string(s.second.vtype) ;
+                    out.write_number(s.second.params) ;
+                }
+            }
+
+            std::ofstream file(path,std::ios::binary) ;
+            file.write(bytes.data(),bytes.size()) ;
+            return (bool)file.flush() ;
+        }
+
+        // replace the index with the contents of a file written by write(), returns false if it cannot be read
+        bool read(const std::string &path)
+        {
+            std::ifstream file(path,std::ios::binary) ;
+            if ( !file ) return false ;
+
+            std::stringstream contents ;
+            contents << file.rdbuf() ;
+            std::string bytes = contents.str() ;
+            if ( bytes.compare(0,magic.size(),magic) != 0 ) return false ;
+
+            classes.clear() ;
+            ast_binary_reader in(bytes,magic.size(),bytes.size()) ;
+            for ( unsigned long long nclasses = in.read_number() ; nclasses > 0 ; nclasses-- )
+            {
+                std::map<std::string,jack_subr_info> &subrs = classes[in.read_string()] ;
+                for ( unsigned long long nsubrs = in.read_number() ; nsubrs > 0 ; nsubrs-- )
+                {
+                    std::string name = in.read_string() ;
+                    unsigned long long kind = in.read_number() ;
+                    std::string vtype = in.read_string() ;
+                    int params = in.read_number() ;
+                    subrs[name] = { kind == 0 ? tk_constructor : kind == 1 ? tk_function : tk_method, vtype, params } ;
+                }
+            }
+            return in.position() == bytes.size() ;
+        }
+
+    private:
+        const std::string magic = "jack-index 1\n" ;
+        std::map<std::string,std::map<std::string,jack_subr_info>> classes ;
+    } ;
+
+    // the index used by the passes, nullptr if there is none
+    inline const jack_index *&jack_project_index_slot()
+    {
+        static const jack_index *index = []() -> const jack_index *
+        {
+            const char *path = std::getenv("JACK_INDEX") ;
+            if ( path == nullptr ) return nullptr ;
+
+            jack_index *index = new jack_index() ;
+            if ( index->read(path) ) return index ;
+            delete index ;
+            return nullptr ;
+        }() ;
+        return index ;
+    }
+
+    // the index of the project being compiled or nullptr, read from the file named by JACK_INDEX on first use
+    inline const jack_index *jack_project_index() { return jack_project_index_slot() ; }
+
+    // make index the index used by the passes, it must outlive them
+    inline void jack_set_project_index(const jack_index *index) { jack_project_index_slot() = index ; }
+}
+
+#endif //JACK_INDEX_H
@@ -0,0 +1,26 @@
+#ifndef JACK_JACKC_H
+#define JACK_JACKC_H
+
+#include <string>
+#include "abstract-syntax-tree.h"
+
+// The Jack compiler passes as functions over a single in-memory abstract syntax tree
+// - each pass is implemented by its own program's .cpp file and is private to that file except for its entry point
+// - jackc links all of the passes into one program, they are compiled with -DJACKC to omit their main programs
+
+namespace Jack_Compiler
+{
+    extern ast jack_parser() ;              // parse a Jack class read from standard input - parser.cpp
+    extern ast jack_lint(ast t) ;           // return an annotated copy of the ast of a Jack class - lint.cpp
+    extern ast jack_optimiser(ast t) ;      // return an optimised copy of the ast of a Jack class - optimiser-e.cpp
+    extern void jack_codegen(ast t) ;       // write the VM code for the ast of a Jack class to the output - codegen.cpp
+    extern void jack_strength_reduction(bool on) ;  // replace * and / by constants when cheaper than a call - codegen.cpp
+    extern void jack_pretty(ast t) ;        // write the ast of a Jack class as Jack code to the output - pretty.cpp
+
+    // peephole optimisation of the VM code written by codegen - codegen-peephole.cpp
+    extern std::string jack_peephole(std::string vm) ;      // apply the selected rules to a subroutine's VM code
+    extern bool jack_peephole_rules(std::string names) ;    // select rules, eg "all" or "not-not,branch", false if unknown
+    extern bool jack_peephole_selected() ;                  // true if any rule is selected, otherwise jack_peephole() changes nothing
+}
+
+#endif //JACK_JACKC_H
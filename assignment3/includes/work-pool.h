@@ -0,0 +1,101 @@
+#ifndef JACK_WORK_POOL_H
+#define JACK_WORK_POOL_H
+
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A work stealing pool for running independent jobs, eg peephole optimising each subroutine's VM code
+//
+// - the AST library does not promise that it is thread safe so jobs must not read or create AST nodes,
+//   a pass walks the AST on one thread and uses the pool for work on what it produced
+// - so lint, optimiser-e and codegen's AST walks are serial until the AST library is thread safe,
+//   only codegen's peephole pass uses the pool and only when a peephole rule is selected
+//
+// - jobs are numbered 0 to n-1 and job(i) must only write its results to a slot i that it owns,
+//   so the results can be combined in order after parallel_for() returns
+// - each worker starts with its own contiguous block of jobs and takes them from the front of its queue,
+//   when its queue is empty it steals a job from the back of another worker's queue
+// - the calling thread is worker 0, parallel_for() returns when all jobs have finished
+// - the maximum number of workers is set by the environment variable JACK_THREADS,
+//   the default is the number of hardware threads
+// - if there is only one worker or only one job, all jobs are run in order on the calling thread
+
+namespace Jack_Compiler
+{
+    // the maximum number of workers to use, JACK_THREADS or the number of hardware threads
+    inline int work_pool_threads()
+    {
+        const char *env = std::getenv("JACK_THREADS") ;
+        int threads = env == nullptr ? 0 : std::atoi(env) ;
+        if ( threads <= 0 ) threads = std::thread::hardware_concurrency() ;
+        return threads <= 0 ? 1 : threads ;
+    }
+
+    // run job(0) .. job(n-1) on at most max_threads workers
+    inline void parallel_for(int n,const std::function<void(int)> &job,int max_threads = work_pool_threads())
+    {
+        int nworkers = n < max_threads ? n : max_threads ;
+
+        if ( nworkers <= 1 )
+        {
+            for ( int i = 0 ; i < n ; i++ ) job(i) ;
+            return ;
+        }
+
+        // one queue of job numbers per worker
+        struct job_queue
+        {
+            std::mutex lock ;
+            std::deque<int> jobs ;
+        } ;
+        std::vector<job_queue> queues(nworkers) ;
+
+        for ( int w = 0 ; w < nworkers ; w++ )
+        {
+            for ( int i = n * w / nworkers ; i < n * (w + 1) / nworkers ; i++ ) queues[w].jobs.push_back(i) ;
+        }
+
+        // take the next job from the front of our own queue
+        auto take = [&](int w,int &i)
+        {
+            std::lock_guard<std::mutex> guard(queues[w].lock) ;
+            if ( queues[w].jobs.empty() ) return false ;
+            i = queues[w].jobs.front() ;
+            queues[w].jobs.pop_front() ;
+            return true ;
+        } ;
+
+        // steal a job from the back of another worker's queue, no new jobs are ever added
+        // so if every other queue is empty there is nothing left to do
+        auto steal = [&](int w,int &i)
+        {
+            for ( int k = 1 ; k < nworkers ; k++ )
+            {
+                job_queue &victim = queues[(w + k) % nworkers] ;
+                std::lock_guard<std::mutex> guard(victim.lock) ;
+                if ( victim.jobs.empty() ) continue ;
+                i = victim.jobs.back() ;
+                victim.jobs.pop_back() ;
+                return true ;
+            }
+            return false ;
+        } ;
+
+        auto worker = [&](int w)
+        {
+            int i ;
+            while ( take(w,i) || steal(w,i) ) job(i) ;
+        } ;
+
+        std::vector<std::thread> threads ;
+        for ( int w = 1 ; w < nworkers ; w++ ) threads.emplace_back(worker,w) ;
+        worker(0) ;
+        for ( auto &thread : threads ) thread.join() ;
+    }
+}
+
+#endif //JACK_WORK_POOL_H
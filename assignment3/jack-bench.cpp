@@ -0,0 +1,182 @@
+//AUTHOR: MONG YUAN SIM A1808469
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#include "iobuffer.h"
+#include "abstract-syntax-tree.h"
+#include "jackc.h"
+#include "ast-stats.h"
+#include "jack-document.h"
+
+// to shorten our code:
+using namespace std;
+using namespace CS_IO_Buffers;
+using namespace Jack_Compiler;
+
+// jack-bench - measure the throughput of each pass of the compiler on one Jack class
+//
+// usage: jack-bench <workload> <class.jack>
+//
+// The class is compiled once in the same order as jackc: parser, lint, optimiser-e, codegen, then pretty prints
+// the final tree. One CSV line is written per pass in the same style as the workshop12 loop programs, each line
+// ends with a ',' and measure.bash appends the details of the computer to it:
+//
+//  Stage,Workload,Bytes,Tokens,Nodes,VM Lines,Time,Tokens / Second,Nodes / Second,VM Lines / Second,Peak RSS KB
+//
+// . workload is a label for the class, eg the jack-workload options used to generate it
+// . bytes and tokens are the size of the source, tokens are counted by skimming it, comments are not tokens
+// . nodes is the number of distinct nodes in the tree the pass works on, for the parser it is the tree it creates
+// . VM lines and VM lines / second are only reported for codegen
+// . tokens / second is only reported for the parser
+// . time is in seconds and peak RSS is the largest resident set size so far in KB
+//
+// The parser is precompiled and reads standard input, so the class is opened as standard input before it is called.
+// The VM code and pretty printed code are written to output buffers that are discarded, they are not timed.
+
+static const string usage = "usage: jack-bench <workload> <class.jack>";
+
+static double real_time()
+{
+    struct timespec realtime;
+
+    clock_gettime(CLOCK_REALTIME, &realtime);
+
+    return realtime.tv_sec + realtime.tv_nsec / 1000000000.0;
+}
+
+// the largest resident set size of this process so far in KB
+static long peak_rss()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+// the number of tokens in Jack source text
+static long count_tokens(const string &text)
+{
+    long tokens = 0;
+    jack_skimmer skimmer(text, 0);
+    for (jack_skim_token t = skimmer.next(); t.kind != tk_eoi && t.kind != tk_oops; t = skimmer.next())
+    {
+        tokens++;
+    }
+    return tokens;
+}
+
+// the number of lines in the output buffer, the buffer is printed to a temporary file and erased
+static long count_output_lines()
+{
+    FILE *lines = tmpfile();
+    cout.flush();
+    int saved = dup(1);
+    dup2(fileno(lines), 1);
+    print_output();
+    cout.flush();
+    dup2(saved, 1);
+    close(saved);
+
+    long n = 0;
+    rewind(lines);
+    for (int c = fgetc(lines); c != EOF; c = fgetc(lines))
+    {
+        if (c == '\n')
+        {
+            n++;
+        }
+    }
+    fclose(lines);
+    return n;
+}
+
+// a rate or "" if it was not measured
+static string rate(long count, double time)
+{
+    if (count < 0)
+    {
+        return "";
+    }
+    return to_string((long)(count / (time > 0 ? time : 1e-9)));
+}
+
+// write one CSV line, counts that were not measured are -1
+static void report(string stage, string workload, long bytes, long tokens, long nodes, long vm_lines, double time)
+{
+    cout << stage << "," << workload << "," << bytes << ","
+         << (tokens < 0 ? "" : to_string(tokens)) << "," << nodes << "," << (vm_lines < 0 ? "" : to_string(vm_lines)) << ","
+         << time << "," << rate(tokens, time) << "," << rate(nodes, time) << "," << rate(vm_lines, time) << ","
+         << peak_rss() << "," << endl;
+}
+
+// main program
+int main(int argc, char **argv)
+{
+    if (argc != 3)
+    {
+        cerr << usage << endl;
+        return 1;
+    }
+    string workload = argv[1];
+    string path = argv[2];
+
+    ifstream file(path);
+    if (!file)
+    {
+        cerr << "cannot open " << path << endl;
+        return 1;
+    }
+    stringstream source;
+    source << file.rdbuf();
+    string text = source.str();
+    long tokens = count_tokens(text);
+
+    // the parser reads standard input
+    int in = open(path.c_str(), O_RDONLY);
+    dup2(in, 0);
+    close(in);
+
+    // nothing the passes write is printed until it is counted
+    config_output(iob_buffer);
+
+    double start = real_time();
+    ast t = jack_parser();
+    double time = real_time() - start;
+    long nodes = ast_stats(t).unique_nodes;
+    report("parser", workload, text.size(), tokens, nodes, -1, time);
+
+    start = real_time();
+    ast linted = jack_lint(t);
+    time = real_time() - start;
+    report("lint", workload, text.size(), -1, nodes, -1, time);
+
+    start = real_time();
+    ast optimised = jack_optimiser(linted);
+    time = real_time() - start;
+    report("optimiser-e", workload, text.size(), -1, ast_stats(linted).unique_nodes, -1, time);
+
+    nodes = ast_stats(optimised).unique_nodes;
+    erase_output();
+    start = real_time();
+    jack_codegen(optimised);
+    time = real_time() - start;
+    report("codegen", workload, text.size(), -1, nodes, count_output_lines(), time);
+
+    start = real_time();
+    jack_pretty(optimised);
+    time = real_time() - start;
+    erase_output();
+    report("pretty", workload, text.size(), -1, nodes, -1, time);
+
+    print_errors();
+}
@@ -0,0 +1,235 @@
+//AUTHOR: MONG YUAN SIM A1808469
+
+// jack-workload - write a large synthetic Jack class for measuring the compiler's passes
+//
+// usage: jack-workload [--subrs=n] [--statements=n] [--depth=n] [--locals=n] [--seed=n] [--class=name]
+//
+//  --subrs=n      - the number of methods, the default is 1000
+//  --statements=n - the number of statements in each method's body, the default is 20
+//  --depth=n      - how deeply expressions are nested, the default is 8
+//  --locals=n     - the number of local variables in each method, the default is 10
+//  --seed=n       - the seed for the choice of statements and expressions, the default is 1
+//  --class=name   - the name of the class, the default is Workload
+//
+// The class is valid Jack: every variable is declared before it is used, non-void methods return a value,
+// calls name methods of the class that have already been declared and the OS classes Math, Output and Array.
+// The same options always produce the same class.
+//
+// The class has a constructor, one method per --subrs with two int parameters, and a main function that calls
+// the first method. Each method body cycles through let, let array, if, if else, while and do statements,
+// the body of each if, else and while is a single let or let array statement.
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+static const string usage = "usage: jack-workload [--subrs=n] [--statements=n] [--depth=n] [--locals=n] [--seed=n] [--class=name]";
+
+// a small deterministic random number generator, xorshift64
+static unsigned long long state = 1;
+static int random_below(int n)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return (int)(state % n);
+}
+
+static int nlocals = 10;
+static int depth = 8;
+
+// the name of a random int variable, parameter or field
+static string int_variable()
+{
+    switch (random_below(4))
+    {
+    case 0:
+        return "a";
+    case 1:
+        return "b";
+    case 2:
+        return "f" + to_string(random_below(2));
+    default:
+        return "l" + to_string(random_below(nlocals));
+    }
+}
+
+// a random term that is not an expression in brackets
+static string simple_term()
+{
+    switch (random_below(6))
+    {
+    case 0:
+        return to_string(random_below(1000));
+    case 1:
+        return "-" + int_variable();
+    case 2:
+        return "arr[" + int_variable() + "]";
+    case 3:
+        return "Math.abs(" + int_variable() + ")";
+    default:
+        return int_variable();
+    }
+}
+
+// a random int expression with brackets nested n deep, division is only by non-zero constants
+static string int_expression(int n)
+{
+    if (n <= 0)
+    {
+        return simple_term();
+    }
+
+    string nested = "(" + int_expression(n - 1) + ")";
+    switch (random_below(5))
+    {
+    case 0:
+        return simple_term() + " + " + nested;
+    case 1:
+        return simple_term() + " - " + nested;
+    case 2:
+        return nested + " * " + simple_term();
+    case 3:
+        return nested + " / " + to_string(1 + random_below(16));
+    default:
+        return nested + " & " + simple_term();
+    }
+}
+
+// a random condition
+static string condition()
+{
+    static const string relations[] = { " < ", " > ", " = " };
+    string c = "(" + int_expression(depth / 2) + ")" + relations[random_below(3)] + simple_term();
+    return random_below(4) == 0 ? "~(" + c + ")" : c;
+}
+
+// statement number i of the body of method m, nested statements are indented by indent
+static string statement(int m, int i, string indent)
+{
+    string inner = indent + "    ";
+    switch (i % 6)
+    {
+    case 0:
+        return indent + "let " + int_variable() + " = " + int_expression(depth) + ";\n";
+    case 1:
+        return indent + "let arr[" + simple_term() + "] = " + int_expression(depth) + ";\n";
+    case 2:
+        return indent + "if (" + condition() + ") {\n" + statement(m, 0, inner) + indent + "}\n";
+    case 3:
+        return indent + "if (" + condition() + ") {\n" + statement(m, 0, inner) + indent + "} else {\n" +
+               statement(m, 1, inner) + indent + "}\n";
+    case 4:
+        return indent + "while (" + condition() + ") {\n" + statement(m, 0, inner) + indent + "}\n";
+    default:
+        if (m > 0 && random_below(2) == 0)
+        {
+            return indent + "do m" + to_string(random_below(m)) + "(" + simple_term() + ", " + int_expression(depth / 2) + ");\n";
+        }
+        return indent + "do Output.printInt(" + int_expression(depth / 2) + ");\n";
+    }
+}
+
+// main program
+int main(int argc, char **argv)
+{
+    int nsubrs = 1000;
+    int nstatements = 20;
+    string class_name = "Workload";
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        size_t eq = arg.find('=');
+        string option = arg.substr(0, eq);
+        string value = eq == string::npos ? "" : arg.substr(eq + 1);
+
+        if (option == "--class" && value != "")
+        {
+            class_name = value;
+        }
+        else if (value != "" && value.find_first_not_of("0123456789") == string::npos)
+        {
+            int n = atoi(value.c_str());
+            if (option == "--subrs")
+            {
+                nsubrs = n;
+            }
+            else if (option == "--statements")
+            {
+                nstatements = n;
+            }
+            else if (option == "--depth")
+            {
+                depth = n;
+            }
+            else if (option == "--locals" && n > 0)
+            {
+                nlocals = n;
+            }
+            else if (option == "--seed" && n > 0)
+            {
+                state = n;
+            }
+            else
+            {
+                cerr << usage << endl;
+                return 1;
+            }
+        }
+        else
+        {
+            cerr << usage << endl;
+            return 1;
+        }
+    }
+
+    string text;
+    text += "// generated by jack-workload, " + to_string(nsubrs) + " methods of " + to_string(nstatements) + " statements\n";
+    text += "class " + class_name + " {\n";
+    text += "    field int f0, f1;\n";
+    text += "    field Array arr;\n\n";
+
+    text += "    constructor " + class_name + " new() {\n";
+    text += "        let f0 = 0;\n";
+    text += "        let f1 = 1;\n";
+    text += "        let arr = Array.new(1000);\n";
+    text += "        return this;\n";
+    text += "    }\n";
+
+    for (int m = 0; m < nsubrs; m++)
+    {
+        text += "\n    method int m" + to_string(m) + "(int a, int b) {\n";
+        text += "        var int l0";
+        for (int l = 1; l < nlocals; l++)
+        {
+            text += ", l" + to_string(l);
+        }
+        text += ";\n";
+
+        for (int i = 0; i < nstatements; i++)
+        {
+            text += statement(m, i, "        ");
+        }
+        text += "        return " + int_expression(depth) + ";\n";
+        text += "    }\n";
+
+        // write the class out as it is generated so a large class does not have to be held in memory
+        cout << text;
+        text.clear();
+    }
+
+    text += "\n    function void main() {\n";
+    text += "        var " + class_name + " w;\n";
+    text += "        let w = " + class_name + ".new();\n";
+    if (nsubrs > 0)
+    {
+        text += "        do Output.printInt(w.m0(1, 2));\n";
+    }
+    text += "        return;\n";
+    text += "    }\n";
+    text += "}\n";
+    cout << text;
+}
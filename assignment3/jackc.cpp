@@ -0,0 +1,456 @@
+//AUTHOR: MONG YUAN SIM A1808469
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "iobuffer.h"
+#include "abstract-syntax-tree.h"
+#include "jackc.h"
+#include "ast-stats.h"
+#include "jack-cache.h"
+#include "jack-index.h"
+#include "work-pool.h"
+
+// to shorten our code:
+using namespace std;
+using namespace CS_IO_Buffers;
+using namespace Jack_Compiler;
+
+// jackc - compile a Jack class read from standard input in a single process
+//
+// usage: jackc [--lint] [--optimise] [--peephole[=rules]] [--strength-reduce] [--emit=vm|xml|jack] [--jobs=n] [directory]
+//
+// The class is parsed once and each selected pass works on the same in-memory AST,
+// the passes are run in the same order as the tests pipe them together: parser, lint, optimiser-e, codegen
+//  --lint      - annotate the AST using lint
+//  --optimise  - optimise the AST using optimiser-e
+//  --peephole  - peephole optimise the VM code using every rule in codegen-peephole.cpp
+//  --peephole=rules - only use the named rules, eg --peephole=not-not,branch
+//  --strength-reduce - replace * and / by constants with cheaper code where codegen's cost model says so
+//  --emit=vm   - print the VM code for the class, this is the default
+//  --emit=xml  - print the AST as XML, this matches the output of the separate programs
+//  --emit=jack - pretty print the AST as Jack code
+//
+// If a directory is given every class in it is compiled, ie every file named <class_name>.jack,
+// and the VM code for each class is written to <class_name>.vm in the same directory
+//  --jobs=n    - compile up to n classes at once, the default is JACK_THREADS or the number of hardware threads
+//  --cache=dir - keep compiled classes in dir, the default is <directory>/.jackc-cache
+//  --no-cache  - compile every class
+//
+// A class is only compiled again if its source or the options have changed, or if a subroutine it calls
+// in another class of the project has changed its kind, return type or number of parameters, see jack-cache.h.
+//
+// Before any class is compiled every class is skimmed into an index of the project's subroutines, see jack-index.h,
+// it is written to <directory>/.jackc-index, lint uses it to check calls between classes and codegen uses it to
+// call a function of the same class that is called without a class name.
+//
+// The tokeniser used by the parser is precompiled, it reads standard input and can only be used once in a
+// process, so in a project each class is compiled by its own child process with its own AST and output buffer.
+// Errors from each class are printed once its child has finished, a class with errors does not get a .vm file.
+
+static const string usage = "usage: jackc [--lint] [--optimise] [--peephole[=rules]] [--strength-reduce] [--emit=vm|xml|jack] [--jobs=n] [--cache=dir|--no-cache] [directory]";
+
+// parse the class read from standard input then run the selected passes over the same tree, returns the final tree
+static ast compile_class(bool lint, bool optimise, string emit)
+{
+    ast t = jack_parser();
+
+    if (lint)
+    {
+        t = jack_lint(t);
+    }
+
+    if (optimise)
+    {
+        t = jack_optimiser(t);
+    }
+
+    if (emit == "xml")
+    {
+        ast_print_as_xml_with_stats(t, 2);
+    }
+    else if (emit == "jack")
+    {
+        jack_pretty(t);
+        ast_stats_on_exit("jackc", t);
+    }
+    else
+    {
+        jack_codegen(t);
+        ast_stats_on_exit("jackc", t);
+    }
+
+    // flush the output and any errors
+    print_output();
+    print_errors();
+    return t;
+}
+
+// the names of the .jack files in a directory in alphabetical order
+static vector<string> jack_files(string directory)
+{
+    vector<string> names;
+    DIR *dir = opendir(directory.c_str());
+    if (dir == nullptr)
+    {
+        fatal_error(0, "Cannot open directory: " + directory);
+    }
+
+    for (dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir))
+    {
+        string name = entry->d_name;
+        if (name.size() > 5 && name.compare(name.size() - 5, 5, ".jack") == 0)
+        {
+            names.push_back(name);
+        }
+    }
+    closedir(dir);
+
+    sort(names.begin(), names.end());
+    return names;
+}
+
+// the options for compiling a project
+struct project_options
+{
+    bool lint;                          // run lint
+    bool optimise;                      // run optimiser-e
+    int jobs;                           // the maximum number of child processes
+    unique_ptr<jack_cache> cache;       // the cache or nullptr
+};
+
+// a class of a project
+struct class_job
+{
+    string source;                      // the .jack file
+    string vm;                          // the .vm file to create
+    FILE *messages;                     // the child's standard error
+    uint64_t key;                       // its cache key
+    bool compiled;                      // true if it was compiled by this run
+    bool have_entry;                    // true if entry holds the compiled class
+    jack_cache_entry entry;             // the compiled class
+};
+
+// all of a file's contents
+static string read_file(string path)
+{
+    ifstream file(path, ios::binary);
+    if (!file)
+    {
+        fatal_error(0, "Cannot open " + path);
+    }
+
+    stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+// start a child process to compile one class, its standard input is the .jack file and
+// its standard output is a temporary file that is renamed to the .vm file if there are no errors
+// if there is a cache the child stores the compiled class in it, unless it reported any errors
+static pid_t start_class(class_job &job, project_options &options)
+{
+    job.messages = tmpfile();
+    if (job.messages == nullptr)
+    {
+        fatal_error(0, "Cannot create a temporary file");
+    }
+
+    // nothing buffered by this process can be printed twice
+    cout.flush();
+    cerr.flush();
+    fflush(nullptr);
+
+    pid_t child = fork();
+    if (child == 0)
+    {
+        int in = open(job.source.c_str(), O_RDONLY);
+        int out = open((job.vm + ".tmp").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        dup2(fileno(job.messages), 2);
+        if (in < 0 || out < 0)
+        {
+            cerr << "Cannot open " << (in < 0 ? job.source : job.vm + ".tmp") << endl;
+            _exit(1);
+        }
+        dup2(in, 0);
+        dup2(out, 1);
+
+        ast t = compile_class(options.lint, options.optimise, "vm");
+        cout.flush();
+        cerr.flush();
+        if (options.cache != nullptr && lseek(2, 0, SEEK_CUR) == 0)
+        {
+            options.cache->store(jack_cache_entry(job.key, t, read_file(job.vm + ".tmp")));
+        }
+        exit(0);
+    }
+    if (child < 0)
+    {
+        fatal_error(0, "Cannot start a process to compile " + job.source);
+    }
+    return child;
+}
+
+// report the errors from a finished child, keep its output if it succeeded, returns true if it succeeded
+static bool finish_class(class_job &job, int status)
+{
+    fflush(job.messages);
+    rewind(job.messages);
+    string errors;
+    char chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), job.messages)) > 0)
+    {
+        errors.append(chunk, n);
+    }
+    fclose(job.messages);
+
+    bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 && errors == "";
+    if (ok)
+    {
+        ok = rename((job.vm + ".tmp").c_str(), job.vm.c_str()) == 0;
+    }
+    else
+    {
+        unlink((job.vm + ".tmp").c_str());
+        unlink(job.vm.c_str());
+    }
+
+    if (!ok)
+    {
+        cerr << job.source << ":" << endl << errors;
+        if (errors == "")
+        {
+            cerr << (WIFSIGNALED(status) ? "the compiler crashed" : "the compiler failed") << endl;
+        }
+    }
+    return ok;
+}
+
+// compile the classes listed in todo using up to options.jobs child processes at once
+// returns the number of classes that could not be compiled
+static int compile_classes(vector<class_job> &classes, const vector<int> &todo, project_options &options)
+{
+    map<pid_t, int> running;
+    int failed = 0;
+    size_t next = 0;
+    while (next < todo.size() || !running.empty())
+    {
+        while (next < todo.size() && (int)running.size() < options.jobs)
+        {
+            running[start_class(classes[todo[next]], options)] = todo[next];
+            next++;
+        }
+
+        int status;
+        pid_t child = wait(&status);
+        if (child < 0)
+        {
+            fatal_error(0, "Lost track of the processes compiling the project");
+        }
+
+        auto job = running.find(child);
+        if (job != running.end())
+        {
+            class_job &c = classes[job->second];
+            c.compiled = true;
+            c.have_entry = false;
+            if (!finish_class(c, status))
+            {
+                failed++;
+            }
+            else if (options.cache != nullptr)
+            {
+                c.have_entry = options.cache->find(c.key, c.entry);
+            }
+            running.erase(job);
+        }
+    }
+    return failed;
+}
+
+// compile every class in a directory, classes found in the cache are not compiled again unless a subroutine
+// they call has changed its signature, returns the number of classes that could not be compiled
+static int compile_project(string directory, project_options &options)
+{
+    vector<string> names = jack_files(directory);
+    if (names.empty())
+    {
+        fatal_error(0, "There are no .jack files in " + directory);
+    }
+
+    // skim every class into the project index, it is used by the passes in every child process
+    jack_index index;
+    vector<class_job> classes;
+    for (auto &name : names)
+    {
+        string path = directory + "/" + name;
+        classes.push_back({ path, path.substr(0, path.size() - 5) + ".vm", nullptr, 0, false, false, {} });
+
+        string source = read_file(path);
+        index.skim_class(source);
+
+        class_job &c = classes.back();
+        if (options.cache != nullptr)
+        {
+            c.key = options.cache->key_of(source);
+            c.have_entry = options.cache->find(c.key, c.entry);
+        }
+    }
+
+    if (!index.write(directory + "/.jackc-index"))
+    {
+        cerr << "Cannot write " << directory << "/.jackc-index" << endl;
+    }
+    jack_set_project_index(&index);
+
+    // a class from the cache is compiled again if a subroutine it calls has changed its signature
+    jack_signatures signatures = index.signatures();
+    vector<int> todo;
+    for (int i = 0; i < (int)classes.size(); i++)
+    {
+        if (!classes[i].have_entry || !jack_uses_unchanged(classes[i].entry, signatures))
+        {
+            todo.push_back(i);
+        }
+    }
+
+    int failed = compile_classes(classes, todo, options);
+    if (options.cache == nullptr)
+    {
+        return failed;
+    }
+
+    // record the signatures the compiled classes were compiled against and
+    // write the VM code of the classes taken from the cache
+    for (auto &c : classes)
+    {
+        if (c.have_entry && c.compiled)
+        {
+            jack_record_uses(c.entry, signatures);
+            options.cache->store(c.entry);
+        }
+        else if (c.have_entry)
+        {
+            ofstream vm(c.vm, ios::binary);
+            vm << c.entry.vm;
+            if (!vm.flush())
+            {
+                cerr << "Cannot write " << c.vm << endl;
+                failed++;
+            }
+        }
+    }
+    return failed;
+}
+
+// main program
+int main(int argc, char **argv)
+{
+    bool lint = false;
+    bool optimise = false;
+    string peephole = "";
+    bool strength_reduce = false;
+    string emit = "vm";
+    string directory = "";
+    string cache = "";
+    bool use_cache = true;
+    int jobs = work_pool_threads();
+
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+
+        if (arg == "--lint")
+        {
+            lint = true;
+        }
+        else if (arg == "--optimise")
+        {
+            optimise = true;
+        }
+        else if (arg == "--peephole")
+        {
+            peephole = "all";
+        }
+        else if (arg.compare(0, 11, "--peephole=") == 0 && arg.size() > 11)
+        {
+            peephole = arg.substr(11);
+        }
+        else if (arg == "--strength-reduce")
+        {
+            strength_reduce = true;
+        }
+        else if (arg.compare(0, 7, "--emit=") == 0)
+        {
+            emit = arg.substr(7);
+        }
+        else if (arg.compare(0, 7, "--jobs=") == 0)
+        {
+            jobs = atoi(arg.c_str() + 7);
+        }
+        else if (arg.compare(0, 8, "--cache=") == 0 && arg.size() > 8)
+        {
+            cache = arg.substr(8);
+        }
+        else if (arg == "--no-cache")
+        {
+            use_cache = false;
+        }
+        else if (directory == "" && arg.compare(0, 2, "--") != 0)
+        {
+            directory = arg;
+        }
+        else
+        {
+            fatal_error(0, usage);
+        }
+    }
+
+    if (emit != "vm" && emit != "xml" && emit != "jack")
+    {
+        fatal_error(0, usage);
+    }
+
+    // the rules are selected before any child process is started so every class uses the same rules,
+    // jackc only uses the rules named by --peephole, not those named by JACK_PEEPHOLE
+    if (!jack_peephole_rules(peephole))
+    {
+        fatal_error(0, usage);
+    }
+    if (strength_reduce)
+    {
+        jack_strength_reduction(true);
+    }
+
+    // a project is always compiled to VM code
+    if (directory != "")
+    {
+        if (emit != "vm" || jobs < 1)
+        {
+            fatal_error(0, usage);
+        }
+
+        project_options options = { lint, optimise, jobs, nullptr };
+        if (use_cache)
+        {
+            string flags = string(lint ? "--lint " : "") + (optimise ? "--optimise " : "") +
+                           (peephole != "" ? "--peephole=" + peephole + " " : "") +
+                           (strength_reduce ? "--strength-reduce " : "") + "--emit=vm";
+            options.cache.reset(new jack_cache(cache != "" ? cache : directory + "/.jackc-cache", flags));
+        }
+        return compile_project(directory, options) == 0 ? 0 : 1;
+    }
+
+    compile_class(lint, optimise, emit);
+}
@@ -0,0 +1,277 @@
+//AUTHOR: MONG YUAN SIM A1808469
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "iobuffer.h"
+#include "abstract-syntax-tree.h"
+#include "ast-lazy-xml.h"
+#include "jack-document.h"
+#include "jackc.h"
+
+// to shorten our code:
+using namespace std;
+using namespace CS_IO_Buffers;
+using namespace Jack_Compiler;
+
+// jackd - keep a Jack class in memory for an editor and re-parse only what each edit damages
+//
+// usage: jackd [class.jack]
+//
+// Commands are read from standard input, one per line, the text of load and edit follows the command line:
+//  load <n>                - replace the class with the n bytes that follow
+//  edit <begin> <end> <n>  - replace the bytes from offset begin up to offset end with the n bytes that follow
+//  xml                     - print the AST of the class as XML
+//  vm                      - print the VM code for the class
+//  quit                    - exit, as does the end of input
+//
+// Every command's output ends with a line starting "ok" or, after any error messages, a line "error".
+// load and edit report "ok parsed <p> of <s> subroutines", the number of subroutines parsed
+// and the number in the class.
+
+static const string usage = "usage: jackd [class.jack]";
+
+// the commands are read with read() so that std::cin is never used by this process,
+// a forked parser must find nothing already buffered when it reads its own standard input
+class command_input
+{
+public:
+    command_input() : pos(0), eof(false) {}
+
+    // read the next line without its '\n', returns false at the end of input
+    bool line(string &s)
+    {
+        size_t eol;
+        while ((eol = buffer.find('\n', pos)) == string::npos && fill())
+        {
+        }
+
+        if (eol == string::npos)
+        {
+            s = buffer.substr(pos);
+            pos = buffer.size();
+            return s != "";
+        }
+
+        s = buffer.substr(pos, eol - pos);
+        pos = eol + 1;
+        return true;
+    }
+
+    // read the next n bytes, returns false if the input ends first
+    bool bytes(int n, string &s)
+    {
+        while ((int)(buffer.size() - pos) < n && fill())
+        {
+        }
+
+        if ((int)(buffer.size() - pos) < n)
+        {
+            return false;
+        }
+
+        s = buffer.substr(pos, n);
+        pos += n;
+        return true;
+    }
+
+private:
+    string buffer;
+    size_t pos;
+    bool eof;
+
+    bool fill()
+    {
+        if (eof)
+        {
+            return false;
+        }
+
+        buffer.erase(0, pos);
+        pos = 0;
+
+        char chunk[4096];
+        ssize_t n = read(0, chunk, sizeof(chunk));
+        if (n <= 0)
+        {
+            eof = true;
+            return false;
+        }
+
+        buffer.append(chunk, n);
+        return true;
+    }
+};
+
+// all of a file descriptor's contents
+static string read_all(int fd)
+{
+    string s;
+    char chunk[4096];
+    ssize_t n;
+    while ((n = read(fd, chunk, sizeof(chunk))) > 0)
+    {
+        s.append(chunk, n);
+    }
+    return s;
+}
+
+// parse the text of a class
+// the precompiled tokeniser reads standard input and can only be used once per process, so each parse runs
+// in a forked copy of this process with the text as its standard input, the child prints the AST as XML
+// and its errors are written to a temporary file, the XML is read back into an AST by this process
+static ast parse_class_text(const string &text, string &errors)
+{
+    FILE *input = tmpfile();
+    FILE *messages = tmpfile();
+    int xml_pipe[2];
+    if (input == nullptr || messages == nullptr || pipe(xml_pipe) != 0)
+    {
+        errors = "cannot create the parser's input and output\n";
+        return nullptr;
+    }
+
+    fwrite(text.data(), 1, text.size(), input);
+    fflush(input);
+    rewind(input);
+
+    // nothing buffered by this process can be printed twice
+    print_output();
+    cout.flush();
+    fflush(stdout);
+
+    pid_t child = fork();
+    if (child == 0)
+    {
+        close(xml_pipe[0]);
+        dup2(fileno(input), 0);
+        dup2(xml_pipe[1], 1);
+        dup2(fileno(messages), 2);
+
+        ast_print_as_xml(jack_parser(), 2);
+        print_output();
+        print_errors();
+        cout.flush();
+        _exit(0);
+    }
+
+    close(xml_pipe[1]);
+    string xml = child < 0 ? "" : read_all(xml_pipe[0]);
+    close(xml_pipe[0]);
+
+    int status = -1;
+    if (child > 0)
+    {
+        waitpid(child, &status, 0);
+    }
+
+    // the child shared the file offset so it is at the end of its messages
+    lseek(fileno(messages), 0, SEEK_SET);
+    errors = read_all(fileno(messages));
+    fclose(input);
+    fclose(messages);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || errors != "" || xml.find("</class>") == string::npos)
+    {
+        if (errors == "")
+        {
+            errors = "the parser failed\n";
+        }
+        return nullptr;
+    }
+
+    return ast_xml_reader(xml, 0, xml.size()).read();
+}
+
+// report the result of load or edit
+static void report(jack_document &doc, bool parsed)
+{
+    if (parsed)
+    {
+        write_to_output("ok parsed " + to_string(doc.parsed_subrs()) + " of " + to_string(doc.size_of_subrs()) + " subroutines\n");
+    }
+    else
+    {
+        write_to_output(doc.errors() + "error\n");
+    }
+}
+
+// main program
+int main(int argc, char **argv)
+{
+    if (argc > 2)
+    {
+        fatal_error(0, usage);
+    }
+
+    jack_document doc(parse_class_text);
+
+    if (argc == 2)
+    {
+        ifstream file(argv[1]);
+        if (!file)
+        {
+            fatal_error(0, "cannot open " + string(argv[1]));
+        }
+
+        stringstream text;
+        text << file.rdbuf();
+        report(doc, doc.open(text.str()));
+        print_output();
+        cout.flush();
+    }
+
+    command_input input;
+    string line;
+    while (input.line(line))
+    {
+        istringstream words(line);
+        string command;
+        words >> command;
+
+        int begin = 0, end = 0, n = 0;
+        string text;
+
+        if (command == "load" && words >> n && n >= 0 && input.bytes(n, text))
+        {
+            report(doc, doc.open(text));
+        }
+        else if (command == "edit" && words >> begin >> end >> n && n >= 0 && input.bytes(n, text))
+        {
+            report(doc, doc.edit(begin, end, text));
+        }
+        else if ((command == "xml" || command == "vm") && doc.tree() == nullptr)
+        {
+            write_to_output("no class has been parsed\nerror\n");
+        }
+        else if (command == "xml")
+        {
+            ast_print_as_xml(doc.tree(), 2);
+            write_to_output("ok\n");
+        }
+        else if (command == "vm")
+        {
+            jack_codegen(doc.tree());
+            write_to_output("ok\n");
+        }
+        else if (command == "quit")
+        {
+            break;
+        }
+        else
+        {
+            write_to_output("unknown command: " + line + "\nerror\n");
+        }
+
+        print_output();
+        cout.flush();
+    }
+
+    // flush the output and any errors
+    print_output();
+    print_errors();
+}
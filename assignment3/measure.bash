@@ -0,0 +1,169 @@
+#!/bin/bash
+
+# measure the throughput of each pass of the compiler on generated Jack classes
+# output should look like a CSV file, in the same style as workshop12/results.csv
+# usage: bash measure.bash [workload ...]
+# each workload is subrs:statements:depth:locals, the jack-workload options used to generate a class
+
+# Banner
+echo "Stage,Workload,Bytes,Tokens,Nodes,VM Lines,Time,Tokens / Second,Nodes / Second,VM Lines / Second,Peak RSS KB,Hostname,CPU,Cores/Threads,L1i Cache,L1d Cache,L2 Cache,L3 Cache,Memory"
+
+# what kind of system are we running on?
+# MacOS is reported as Darwin
+System=`test -f /usr/bin/uname && /usr/bin/uname -s`
+if [ "x${System}" == "xDarwin" ]
+then
+    export CS_ARCH=macos
+    export MACOSX_DEPLOYMENT_TARGET=10.12
+    export MACOS_ARCHS=$(bash bin/Compiler-archs.bash)
+else
+    THIS_OS=$(test -f /etc/os-release && (grep "^ID=" /etc/os-release | sed 's/ID="\([^"]*\).*/\1/'))
+    THIS_OSV=$(test -f /etc/os-release && (grep "^VERSION_ID=" /etc/os-release | sed 's/VERSION_ID="\([^\."]*\).*/\1/'))
+
+    # CATS is currently RHEL7.7
+    if [ "xrhel7" == "x${THIS_OS}${THIS_OSV}" -o "xcentos7" == "x${THIS_OS}${THIS_OSV}" ]
+    then
+        export CS_ARCH=cats
+    else
+        export CS_ARCH=centos8
+    fi
+fi
+
+# mem size
+mem_size()
+{
+    memory_size=
+    if [ ${#@} -eq 0 ] ; then return ; fi
+
+    # extract any fractions?
+    size="${1%%.*}"
+    fraction=0
+    divider=1
+
+    # if we have a fraction, remove by scaling
+    if [ "x${size}" != "x${1}" ]
+    then
+        fraction="${1#*.}"
+        fdigits=${#fraction}
+        divider=1
+        if [ ${fdigits} -gt 0 ]
+        then
+            while ((fdigits-->0)) ; do
+                ((divider*=10))
+                ((size*=10))
+            done
+            ((size+=fraction))
+        fi
+    fi
+
+    # convert to bytes, MiB scale tries to avoid overflow
+    case "${2}" in
+    kB | KiB)
+        ((size=size*1024))
+        ((size=size/divider))
+        ;;
+    MiB)
+        ((size=size*1024))
+        ((size=size/divider))
+        ((size=size*1024))
+        ;;
+    *)
+        ;;
+    esac
+
+    if [ ${#size} -eq 0 -o "${size}" -eq 0 ] ; then return ; fi
+
+    ((KB=size/1024))
+    ((MB=KB/1024))
+    ((Mremainder=KB-MB*1024))
+    ((GB=MB/1024))
+    ((Gremainder=MB-GB*1024))
+
+    if [ "${GB}" -gt 0 ]
+    then
+        if [ "${Gremainder}" -eq 0 ]
+        then
+            memory_size="${GB}GB"
+        else
+            memory_size="${MB}MB"
+        fi
+
+    elif [ "${MB}" -gt 0 -a "${Mremainder}" -eq 0 ]
+    then
+        memory_size="${MB}MB"
+    else
+        memory_size="${KB}KB"
+    fi
+}
+
+# lookup CPU info
+host=$(hostname)
+if [ -f /proc/cpuinfo ] ; then
+    cpu=$(grep -i "model name" /proc/cpuinfo 2> /dev/null | sed 's/.*:  *//'| sort -u)
+    cpus=$(lscpu 2> /dev/null |grep -i "socket(s):" | sed 's/.*:  *//')
+    cpuc=$(lscpu 2> /dev/null |grep -i " per socket:" | sed 's/.*:  *//')
+    cput=$(lscpu 2> /dev/null |grep -i " per core:" | sed 's/.*:  *//')
+    L1i=$(lscpu 2> /dev/null |grep -i "l1i cache" | sed 's/.*:  *//')
+    L1d=$(lscpu 2> /dev/null |grep -i "l1d cache" | sed 's/.*:  *//')
+    L2=$(lscpu 2> /dev/null | grep -i "l2 cache" | sed 's/.*:  *//')
+    L3=$(lscpu 2> /dev/null |grep -i "l3 cache" | sed 's/.*:  *//')
+    mem=$(grep -i memtotal /proc/meminfo 2> /dev/null  | sed 's/.*:  *//')
+
+    # cores is sockets x cores / socket
+    ((cpuc=cpus*cpuc))
+
+    # threads is cores x threads / core
+    ((cput=cpuc*cput))
+else
+    cpu=$(sysctl -n machdep.cpu.brand_string 2> /dev/null)
+    cpus=1
+    cpuc=$(sysctl -n machdep.cpu.core_count 2> /dev/null)
+    cput=$(sysctl -n machdep.cpu.thread_count 2> /dev/null)
+    L1i=$(sysctl -n hw.l1icachesize 2> /dev/null)
+    L1d=$(sysctl -n hw.l1dcachesize 2> /dev/null)
+    L2=$(sysctl -n hw.l2cachesize 2> /dev/null)
+    L3=$(sysctl -n hw.l3cachesize 2> /dev/null)
+    mem=$(sysctl -n hw.memsize 2> /dev/null)
+fi
+
+# make memory sizes readable
+mem_size ${L1i} ; L1i=${memory_size}
+mem_size ${L1d} ; L1d=${memory_size}
+mem_size ${L2} ; L2=${memory_size}
+mem_size ${L3} ; L3=${memory_size}
+mem_size ${mem} ; mem=${memory_size}
+
+# measure every pass over subrs:statements:depth:locals workloads
+# display results with system info too
+measure_workloads()
+{
+    class=$(mktemp)
+
+    while [ ${#@} -gt 0 ] ; do
+        subrs="${1%%:*}"
+        rest="${1#*:}"
+        statements="${rest%%:*}"
+        rest="${rest#*:}"
+        depth="${rest%%:*}"
+        locals="${rest#*:}"
+        shift 1
+
+        lib/${CS_ARCH}/jack-workload --subrs=${subrs} --statements=${statements} --depth=${depth} --locals=${locals} > ${class}
+        lib/${CS_ARCH}/jack-bench "${subrs}:${statements}:${depth}:${locals}" ${class} | while read -r line ; do
+            echo "${line}${host},${cpu},${cpuc}c/${cput}t,${L1i},${L1d},${L2},${L3},${mem}"
+        done
+    done
+
+    rm -f ${class}
+}
+
+# check we have compiled the generator and benchmark
+if [ ! -x lib/${CS_ARCH}/jack-workload -o ! -x lib/${CS_ARCH}/jack-bench ] ; then make notest ; fi
+
+# many small subroutines, long statement lists, deep expressions and many locals
+if [ ${#@} -eq 0 ]
+then
+    measure_workloads 1000:20:8:10 5000:20:8:10 1000:200:8:10 1000:20:40:10 1000:20:8:200
+else
+    measure_workloads "$@"
+fi
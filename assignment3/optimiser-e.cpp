@@ -3,6 +3,11 @@
 #include "iobuffer.h"
 #include "symbols.h"
 #include "abstract-syntax-tree.h"
+#include "jackc.h"
+#include "ast-stats.h"
+#include "ast-visitor.h"
+#include "ast-analysis.h"
+#include "ast-builders.h"
 
 // to shorten our code:
 using namespace std;
@@ -10,6 +15,10 @@ using namespace CS_IO_Buffers;
 using namespace CS_Symbol_Tables;
 using namespace Jack_Compiler;
 
+// the pass is private to this file, jackc calls it through the entry point declared in jackc.h
+namespace
+{
+
 // ***** WHAT TO DO *****
 //
 // MODIFY the skeleton code below to make an optimised copy an abstract syntax tree, ast, of a Jack class.
@@ -27,518 +36,339 @@ using namespace Jack_Compiler;
 //  - you may want to change the parameters / results to suit your own logic
 //  - you can change it as much as you like
 
-// forward declarations of one function per node in the abstract syntax tree
-ast copy_class(ast t);
-ast copy_class_var_decs(ast t);
-ast copy_var_dec(ast t);
-ast copy_subr_decs(ast t);
-ast copy_subr(ast t);
-ast copy_constructor(ast t);
-ast copy_function(ast t);
-ast copy_method(ast t);
-ast copy_param_list(ast t);
-ast copy_subr_body(ast t);
-ast copy_var_decs(ast t);
-ast copy_statements(ast t);
-ast copy_statement(ast t);
-ast copy_let(ast t);
-ast copy_let_array(ast t);
-ast copy_if(ast t);
-ast copy_if_else(ast t);
-ast copy_while(ast t);
-ast copy_do(ast t);
-ast copy_return(ast t);
-ast copy_return_expr(ast t);
-ast copy_expr(ast t);
-ast copy_term(ast t);
-ast copy_int(ast t);
-ast copy_string(ast t);
-ast copy_bool(ast t);
-ast copy_null(ast t);
-ast copy_this(ast t);
-ast copy_unary_op(ast t);
-ast copy_var(ast t);
-ast copy_array_index(ast t);
-ast copy_call_as_function(ast t);
-ast copy_call_as_method(ast t);
-ast copy_subr_call(ast t);
-ast copy_expr_list(ast t);
-ast copy_infix_op(ast t);
-
-bool pass_unary = false ;
-string global_uop ;
-
-// copy an ast class node with fields:
-// class_name - a string
-// var_decs   - ast vector of variable declarations
-// subr_decs  - ast vector of subroutine declarations
-//
-ast copy_class(ast t)
+// the optimiser is an ast_rewriter, see ast-visitor.h, with one copy_*() function per node that it changes
+// the other nodes are copied by ast_rewriter's copy_*() functions, they only create a new node if a sub-tree changed
+class optimiser : public ast_rewriter<optimiser>
 {
-    string myclassname = get_class_class_name(t);
-    ast var_decs = get_class_var_decs(t);
-    ast subr_decs = get_class_subr_decs(t);
+public:
+    ast copy_subr_body(ast t);
+    ast copy_statements(ast t);
+    ast copy_expr(ast t);
+    ast copy_term(ast t);
+    ast copy_unary_op(ast t);
+};
 
-    ast var_decs_copy = copy_class_var_decs(var_decs);
-    ast subr_decs_copy = copy_subr_decs(subr_decs);
+// ***** constant folding *****
+//
+// expressions are evaluated left to right as Jack specifies, using 16 bit two's complement arithmetic,
+// the values and operations are the ones in ast-analysis.h so every pass agrees on them
+// - a term with a constant value is a constant, eg an int, true is -1 and false and null are 0
+// - a constant prefix of an expression is folded with the next term if it is also a constant,
+//   division by 0 is left for the program to report when it is run
+// - an operation with an identity, eg x + 0, x * 1 or x & -1, is removed
+// - an operation that always gives the same result, eg x * 0, is replaced by the result if x has no side effects
+// - a constant that follows another constant, eg x + 1 + 2 or x * 2 * 3, is combined with it
+// - a term that is a single term in brackets is replaced by the term in the brackets
+// - relational operations on constants, or on the same variable, are replaced by true or false
 
-    if (var_decs_copy == var_decs && subr_decs_copy == subr_decs)
-        return t;
+// true if an ast term node is a constant, its value is recorded in value
+static bool is_constant(ast term, int &value)
+{
+    optional<int> constant = ast_constant_value(term);
+    if (!constant)
+        return false;
 
-    return create_class(get_ann(t), myclassname, var_decs_copy, subr_decs_copy);
+    value = *constant;
+    return true;
 }
 
-// copy an ast class var decs node
-// it is an ast vector of variable declarations
-//
-ast copy_class_var_decs(ast t)
+// true if an ast term node is a bool constant
+static bool is_bool(ast term)
 {
-    vector<ast> decs;
-
-    bool copied = false;
-    int ndecs = size_of_class_var_decs(t);
-    for (int i = 0; i < ndecs; i++)
-    {
-        ast deci = get_class_var_decs(t, i);
-        ast copy = copy_var_dec(deci);
-        if (deci != copy)
-            copied = true;
-
-        decs.push_back(copy);
-    }
-
-    if (!copied)
-        return t;
-
-    return create_class_var_decs(get_ann(t), decs);
+    return ast_node_kind(get_term_term(term)) == ast_bool;
 }
 
-// copy an ast variable declaration with fields
-// name - a string
-// type - a string - "int", "char", "boolean" or a class name
-// segment - a string
-// offset - an int
-// this is used for statics, fields, parameters and local variables
-//
-ast copy_var_dec(ast t)
+// true if op is a relational operator, its result is true or false
+static bool is_relational(char op)
 {
-    string name = get_var_dec_name(t);
-    string type = get_var_dec_type(t);
-    string segment = get_var_dec_segment(t);
-    int offset = get_var_dec_offset(t);
-
-    return create_var_dec(name, segment, offset, type);
+    return op == '<' || op == '>' || op == '=';
 }
 
-// copy an ast class var decs node
-// it is an ast vector of subroutine declarations
-//
-ast copy_subr_decs(ast t)
+// an ast term node for a constant
+static ast create_constant(int value, bool as_bool)
 {
-    vector<ast> decs;
-
-    bool copied = false;
-    int size = size_of_subr_decs(t);
-    for (int i = 0; i < size; i++)
-    {
-        ast deci = get_subr_decs(t, i);
-        ast copy = copy_subr(deci);
-        if (deci != copy)
-            copied = true;
+    if (as_bool)
+        return create_term(create_bool(value != 0));
 
-        decs.push_back(copy);
-    }
-
-    if (!copied)
-        return t;
-
-    return create_subr_decs(get_ann(t), decs);
+    return create_term(create_int(wrap16(value)));
 }
 
-// copy an ast subroutine node with a single field
-// subr - an ast constructor, ast function or ast method node
-//
-ast copy_subr(ast t)
+// the result of a op b, returns false if it must be left for the program to work out when it is run
+static bool evaluate(int a, char op, int b, int &result)
 {
-    ast subr = get_subr_subr(t);
-    ast copy;
-
-    switch (ast_node_kind(subr))
-    {
-    case ast_constructor:
-        copy = copy_constructor(subr);
-        break;
-    case ast_function:
-        copy = copy_function(subr);
-        break;
-    case ast_method:
-        copy = copy_method(subr);
-        break;
-    default:
-        fatal_error(0, "bad subroutine dec found");
-        copy = nullptr;
-        break;
-    }
-
-    if (subr == copy)
-        return t;
+    optional<int> value = jack_infix_value(op, a, b);
+    if (!value)
+        return false;
 
-    return create_subr(get_ann(t), copy);
+    result = *value;
+    return true;
 }
 
-// copy an ast constructor node with fields
-// vtype - a string - the name of the class
-// name - a string
-// param list - an ast vector of variable declarations
-// subr body - an ast subr body node
-//
-ast copy_constructor(ast t)
+// true if x op c is always x
+static bool is_right_identity(char op, int c)
 {
-    string vtype = get_constructor_vtype(t);
-    string name = get_constructor_name(t);
-    ast param_list = get_constructor_param_list(t);
-    ast subr_body = get_constructor_subr_body(t);
-
-    ast param_list_copy = copy_param_list(param_list);
-    ast subr_body_copy = copy_subr_body(subr_body);
-
-    if (param_list_copy == param_list && subr_body_copy == subr_body)
-        return t;
-
-    return create_constructor(get_ann(t), vtype, name, param_list_copy, subr_body_copy);
+    return ((op == '+' || op == '-' || op == '|') && c == 0) || ((op == '*' || op == '/') && c == 1) || (op == '&' && c == -1);
 }
 
-// copy an ast function node with fields
-// vtype - a string - one of "void", "int", "char", "boolean" or the name of a class
-// name - a string
-// param list - an ast vector of variable declarations
-// subr body - an ast subr body node
-//
-ast copy_function(ast t)
+// true if c op x is always x
+static bool is_left_identity(int c, char op)
 {
-    string vtype = get_function_vtype(t);
-    string name = get_function_name(t);
-    ast param_list = get_function_param_list(t);
-    ast subr_body = get_function_subr_body(t);
-
-    ast param_list_copy = copy_param_list(param_list);
-    ast subr_body_copy = copy_subr_body(subr_body);
-
-    if (param_list_copy == param_list && subr_body_copy == subr_body)
-        return t;
-
-    return create_function(get_ann(t), vtype, name, param_list_copy, subr_body_copy);
+    return ((op == '+' || op == '|') && c == 0) || (op == '*' && c == 1) || (op == '&' && c == -1);
 }
 
-// copy an ast method node with fields
-// vtype - a string - one of "void", "int", "char", "boolean" or the name of a class
-// name - a string
-// param list - an ast vector of variable declarations
-// subr body - an ast subr body node
-//
-ast copy_method(ast t)
+// true if x op c and c op x are always c
+static bool is_absorbing(char op, int c)
 {
-    string vtype = get_method_vtype(t);
-    string name = get_method_name(t);
-    ast param_list = get_method_param_list(t);
-    ast subr_body = get_method_subr_body(t);
-
-    ast param_list_copy = copy_param_list(param_list);
-    ast subr_body_copy = copy_subr_body(subr_body);
-
-    if (param_list_copy == param_list && subr_body_copy == subr_body)
-        return t;
-
-    return create_method(get_ann(t), vtype, name, param_list_copy, subr_body_copy);
+    return ((op == '*' || op == '&') && c == 0) || (op == '|' && c == -1);
 }
 
-// copy an ast param list node
-// it is an ast vector of variable declarations
-//
-ast copy_param_list(ast t)
+// the constant c such that x first a second b is always x op c, returns false if there is none
+// + and - can be combined with each other and * with *, 16 bit arithmetic wraps around so the order does not matter
+static bool combine(char first, int a, char second, int b, char &op, int &c)
 {
-    vector<ast> decs;
-
-    bool copied = false;
-    int size = size_of_param_list(t);
-    for (int i = 0; i < size; i++)
+    if ((first == '+' || first == '-') && (second == '+' || second == '-'))
     {
-        ast deci = get_param_list(t, i);
-        ast copy = copy_var_dec(deci);
-        if (deci != copy)
-            copied = true;
-
-        decs.push_back(copy);
+        c = wrap16((first == '+' ? a : -a) + (second == '+' ? b : -b));
+        op = c < 0 && c != -32768 ? '-' : '+';
+        c = op == '-' ? -c : c;
+        return true;
     }
-
-    if (!copied)
-        return t;
-
-    return create_param_list(get_ann(t), decs);
+    if (first == '*' && second == '*')
+    {
+        op = '*';
+        c = wrap16(a * b);
+        return true;
+    }
+    return false;
 }
 
-// copy an ast subr body node with fields
-// decs - an ast vector of variable declarations
-// body - an ast vector of statement nodes
-//
-ast copy_subr_body(ast t)
+// true if a sequence of terms and infix ops contains a subroutine call
+static bool has_side_effects(const vector<ast> &termops)
 {
-    ast decs = get_subr_body_decs(t);
-    ast body = get_subr_body_body(t);
-
-    ast decs_copy = copy_var_decs(decs);
-    ast body_copy = copy_statements(body);
-
-    if (decs_copy == decs && body_copy == body)
-        return t;
-
-    return create_subr_body(get_ann(t), decs_copy, body_copy);
+    for (auto termop : termops)
+    {
+        if (ast_has_calls(termop))
+            return true;
+    }
+    return false;
 }
 
-// copy an ast param list node
-// it is an ast vector of variable declarations
-//
-ast copy_var_decs(ast t)
+// true if two ast term nodes are the same variable, so they always have the same value
+static bool is_same_var(ast lhs, ast rhs)
 {
-    vector<ast> decs;
+    ast l = get_term_term(lhs);
+    ast r = get_term_term(rhs);
+    if (ast_node_kind(l) != ast_var || ast_node_kind(r) != ast_var)
+        return false;
 
-    bool copied = false;
-    int size = size_of_var_decs(t);
-    for (int i = 0; i < size; i++)
-    {
-        ast deci = get_var_decs(t, i);
-        ast copy = copy_var_dec(deci);
-        if (deci != copy)
-            copied = true;
+    return get_var_segment(l) == get_var_segment(r) && get_var_offset(l) == get_var_offset(r);
+}
 
-        decs.push_back(copy);
-    }
+// ***** dead code elimination *****
+//
+// - an if, if else or while statement whose condition is a constant after folding is replaced by the
+//   statements that can run, eg if (true) by its if true statements and while (false) by nothing
+// - the conditions are tested the way codegen's VM code tests them, an if is taken if its condition is
+//   not 0 but a while's condition is negated by not before if-goto so only -1 keeps it looping,
+//   eg the body of while (1) never runs
+// - the statements after a statement that never finishes, eg a return or while (true), are removed
+// - locals that were only used by code that has been removed are removed and the remaining locals are
+//   renumbered so the subroutine needs fewer locals, see copy_subr_body()
 
-    if (!copied)
-        return t;
+// true if an ast expr node is a constant, its value is recorded in value
+static bool is_constant_expr(ast expr, int &value)
+{
+    optional<int> constant = ast_constant_value(expr);
+    if (!constant)
+        return false;
 
-    return create_var_decs(get_ann(t), decs);
+    value = *constant;
+    return true;
 }
 
-// copy an ast statements node
-// it is an ast vector of statement nodes
-//
-ast copy_statements(ast t)
+// true if the statement after an ast statement node can never be reached
+static bool never_finishes(ast t)
 {
-    vector<ast> decs;
+    ast statement = get_statement_statement(t);
+    int value;
 
-    bool copied = false;
-    int size = size_of_statements(t);
-    for (int i = 0; i < size; i++)
+    switch (ast_node_kind(statement))
     {
-        ast deci = get_statements(t, i);
-        ast copy = copy_statement(deci);
-        if (deci != copy)
-            copied = true;
-
-        decs.push_back(copy);
+    case ast_return:
+    case ast_return_expr:
+        return true;
+    case ast_while:
+        return is_constant_expr(get_while_condition(statement), value) && value == -1;
+    case ast_if_else:
+    {
+        ast if_true = get_if_else_if_true(statement);
+        ast if_false = get_if_else_if_false(statement);
+        int ntrue = size_of_statements(if_true);
+        int nfalse = size_of_statements(if_false);
+        return ntrue > 0 && nfalse > 0 && never_finishes(get_statements(if_true, ntrue - 1)) &&
+               never_finishes(get_statements(if_false, nfalse - 1));
+    }
+    case ast_statements:
+    {
+        int size = size_of_statements(statement);
+        return size > 0 && never_finishes(get_statements(statement, size - 1));
+    }
+    default:
+        return false;
     }
-
-    if (!copied)
-        return t;
-
-    return create_statements(get_ann(t), decs);
 }
 
-// copy an ast statement node with a single field
-// statement - one of the following ast nodes, let, let array, if, if else, while, do, return, return expr or statements
-//
-ast copy_statement(ast t)
+// the statements that replace an ast statement node whose condition is a constant, returns nullptr
+// if the statement is kept, the statements have already been copied
+static ast live_statements(ast t)
 {
     ast statement = get_statement_statement(t);
-    ast copy;
+    int value;
 
     switch (ast_node_kind(statement))
     {
-    case ast_let:
-        copy = copy_let(statement);
-        break;
-    case ast_let_array:
-        copy = copy_let_array(statement);
-        break;
     case ast_if:
-        copy = copy_if(statement);
-        break;
+        if (!is_constant_expr(get_if_condition(statement), value))
+            return nullptr;
+        return value != 0 ? get_if_if_true(statement) : create_statements({});
     case ast_if_else:
-        copy = copy_if_else(statement);
-        break;
+        if (!is_constant_expr(get_if_else_condition(statement), value))
+            return nullptr;
+        return value != 0 ? get_if_else_if_true(statement) : get_if_else_if_false(statement);
     case ast_while:
-        copy = copy_while(statement);
-        break;
-    case ast_do:
-        copy = copy_do(statement);
-        break;
-    case ast_return:
-        copy = copy_return(statement);
-        break;
-    case ast_return_expr:
-        copy = copy_return_expr(statement);
-        break;
-    case ast_statements:
-        copy = copy_statements(statement);
-        break;
+        if (!is_constant_expr(get_while_condition(statement), value) || value == -1)
+            return nullptr;
+        return create_statements({});
     default:
-        fatal_error(0, "Unexpected statement kind");
-        copy = nullptr;
-        break;
+        return nullptr;
     }
-
-    if (copy == statement)
-        return t;
-
-    return create_statement(get_ann(t), copy);
 }
 
-// copy an ast let node with fields
-// var  - an ast variable
-// expr - an ast expr node
-//
-ast copy_let(ast t)
+// record the offsets of the locals used by a subroutine body
+class local_uses : public ast_walker<local_uses>
 {
-    ast var = get_let_var(t);
-    ast expr = get_let_expr(t);
-
-    ast var_copy = copy_var(var);
-    ast expr_copy = copy_expr(expr);
-
-    if (var_copy == var && expr_copy == expr)
-        return t;
+public:
+    vector<bool> used;
 
-    return create_let(get_ann(t), var_copy, expr_copy);
-}
+    void walk_var(ast t)
+    {
+        int offset = get_var_offset(t);
+        if (get_var_segment(t) == "local" && offset >= 0 && offset < (int)used.size())
+            used[offset] = true;
+    }
+};
 
-// copy an ast let array node with fields
-// var    - an ast variable
-// index  - an ast expr node
-// expr   - an ast expr node
-//
-ast copy_let_array(ast t)
+// copy a subroutine body giving each local its new offset
+class renumber_locals : public ast_rewriter<renumber_locals>
 {
-    ast var = get_let_array_var(t);
-    ast index = get_let_array_index(t);
-    ast expr = get_let_array_expr(t);
-
-    ast var_copy = copy_var(var);
-    ast index_copy = copy_expr(index);
-    ast expr_copy = copy_expr(expr);
+public:
+    vector<int> offsets;
 
-    if (var_copy == var && index_copy == index && expr_copy == expr)
-        return t;
+    ast copy_var(ast t)
+    {
+        int offset = get_var_offset(t);
+        if (get_var_segment(t) != "local" || offset < 0 || offset >= (int)offsets.size() || offsets[offset] == offset)
+            return t;
 
-    return create_let_array(get_ann(t), var_copy, index_copy, expr_copy);
-}
+        return create_var(get_ann(t), get_var_name(t), "local", offsets[offset], get_var_type(t));
+    }
+};
 
-// copy an ast if node with fields
-// condition - an ast expr node
-// if true   - an ast statements node
+// copy an ast subr body node with fields
+// decs - an ast vector of variable declarations
+// body - an ast vector of statement nodes
 //
-ast copy_if(ast t)
+ast optimiser::copy_subr_body(ast t)
 {
-    ast condition = get_if_condition(t);
-    ast if_true = get_if_if_true(t);
-
-    ast condition_copy = copy_expr(condition);
-    ast if_true_copy = copy_statements(if_true);
-
-    if (condition_copy == condition && if_true_copy == if_true)
-        return t;
+    ast decs = get_subr_body_decs(t);
+    ast body = get_subr_body_body(t);
 
-    return create_if(get_ann(t), condition_copy, if_true_copy);
-}
+    ast decs_copy = copy_var_decs(decs);
+    ast body_copy = copy_statements(body);
 
-// copy an ast if else node with fields
-// condition - an ast expr node
-// if true   - an ast statements node
-// if else   - an ast statements node
-//
-ast copy_if_else(ast t)
-{
-    ast condition = get_if_else_condition(t);
-    ast if_true = get_if_else_if_true(t);
-    ast if_false = get_if_else_if_false(t);
+    // remove the locals the body used before it was optimised but no longer uses, the others keep their order
+    int ndecs = size_of_var_decs(decs_copy);
+    local_uses before;
+    before.used.assign(ndecs, false);
+    before.walk(body);
+    local_uses after;
+    after.used.assign(ndecs, false);
+    after.walk(body_copy);
+
+    renumber_locals renumber;
+    renumber.offsets.assign(ndecs, 0);
+    ast_vector_builder<ast_var_decs> used_decs;
+    used_decs.set_ann(get_ann(decs_copy));
+    for (int i = 0; i < ndecs; i++)
+    {
+        ast dec = get_var_decs(decs_copy, i);
+        int offset = get_var_dec_offset(dec);
+        if (offset < 0 || offset >= ndecs)
+            return create_subr_body(get_ann(t), decs_copy, body_copy);
+
+        renumber.offsets[offset] = used_decs.size();
+        if (after.used[offset] || !before.used[offset])
+            used_decs.push_back(create_var_dec(get_ann(dec), get_var_dec_name(dec), "local", used_decs.size(), get_var_dec_type(dec)));
+    }
 
-    ast condition_copy = copy_expr(condition);
-    ast if_true_copy = copy_statements(if_true);
-    ast if_false_copy = copy_statements(if_false);
+    if (used_decs.size() < ndecs)
+    {
+        decs_copy = used_decs.build();
+        body_copy = renumber.copy(body_copy);
+    }
 
-    if (condition_copy == condition && if_true_copy == if_true && if_false_copy == if_false)
+    if (decs_copy == decs && body_copy == body)
         return t;
 
-    return create_if_else(get_ann(t), condition_copy, if_true_copy, if_false_copy);
+    return create_subr_body(get_ann(t), decs_copy, body_copy);
 }
 
-// copy an ast while node with fields
-// condition - an ast expr node
-// body      - an ast statements node
+// copy an ast statements node
+// it is an ast vector of statement nodes
 //
-ast copy_while(ast t)
-{
-    ast condition = get_while_condition(t);
-    ast body = get_while_body(t);
-
-    ast condition_copy = copy_expr(condition);
-    ast body_copy = copy_statements(body);
-
-    if (condition_copy == condition && body_copy == body)
-        return t;
-
-    return create_while(get_ann(t), condition_copy, body_copy);
-}
-
-// copy an ast do node with a single field
-// call - an ast call as function node or an ast call as method node
+// statements with constant conditions are replaced by their live statements and
+// the statements after a statement that never finishes are removed, see dead code elimination above
 //
-ast copy_do(ast t)
+ast optimiser::copy_statements(ast t)
 {
-    ast call = get_do_call(t);
-    ast copy;
+    ast_vector_builder<ast_statements> statements;
+    statements.set_ann(get_ann(t));
 
-    switch (ast_node_kind(call))
+    // true if the last statement kept never finishes so no more statements can be reached
+    auto unreachable = [&]()
     {
-    case ast_call_as_function:
-        copy = copy_call_as_function(call);
-        break;
-    case ast_call_as_method:
-        copy = copy_call_as_method(call);
-        break;
-    default:
-        fatal_error(0, "Unexpected call kind\n");
-        copy = nullptr;
-        break;
-    }
+        return statements.size() > 0 && never_finishes(statements.get(statements.size() - 1));
+    };
 
-    if (copy == call)
-        return t;
-
-    return create_do(get_ann(t), copy);
-}
+    bool copied = false;
+    int size = size_of_statements(t);
+    for (int i = 0; i < size && !unreachable(); i++)
+    {
+        ast deci = get_statements(t, i);
+        ast copy = copy_statement(deci);
+        if (deci != copy)
+            copied = true;
 
-// copy an ast return node, it has not fields
-// nothing to do ...
-//
-ast copy_return(ast t)
-{
-    return t;
-}
+        ast live = live_statements(copy);
+        if (live == nullptr)
+        {
+            statements.push_back(copy);
+            continue;
+        }
 
-// copy an ast return expr node with a single field
-// expr - an ast expr node
-//
-ast copy_return_expr(ast t)
-{
-    ast expr = get_return_expr(t);
+        copied = true;
+        int nlive = size_of_statements(live);
+        for (int j = 0; j < nlive && !unreachable(); j++)
+            statements.push_back(get_statements(live, j));
+    }
 
-    ast copy = copy_expr(expr);
+    if (statements.size() < size)
+        copied = true;
 
-    if (copy == expr)
+    if (!copied)
         return t;
 
-    return create_return_expr(get_ann(t), copy);
+    return statements.build();
 }
 
 // copy an ast param list node
@@ -547,23 +377,97 @@ ast copy_return_expr(ast t)
 // all elements at even indices are an ast term node
 // all elements at odd indices are an ast infix op
 //
-ast copy_expr(ast t)
+// the terms are copied and folded left to right, terms holds the expression so far, see constant folding above
+//
+ast optimiser::copy_expr(ast t)
 {
     vector<ast> terms;
 
     bool copied = false;
     int size = size_of_expr(t);
-    for (int i = 0; i < size; i++)
+    for (int i = 0; i < size; i += 2)
     {
-        ast termop = get_expr(t, i);
-        ast copy = i % 2 == 0 ? copy_term(termop) : copy_infix_op(termop);
-        if (termop != copy)
+        ast term = get_expr(t, i);
+        ast term_copy = copy_term(term);
+        if (term != term_copy)
+            copied = true;
+
+        if (i == 0)
+        {
+            terms.push_back(term_copy);
+            continue;
+        }
+
+        ast op = get_expr(t, i - 1);
+        ast op_copy = copy_infix_op(op);
+        if (op != op_copy)
             copied = true;
 
-        terms.push_back(copy);
+        char c = get_infix_op_op(op_copy)[0];
+        int lhs, rhs, result;
+        bool lhs_constant = terms.size() == 1 && is_constant(terms[0], lhs);
+        bool rhs_constant = is_constant(term_copy, rhs);
+        bool same_var = terms.size() == 1 && is_same_var(terms[0], term_copy);
+        int before;
+        char combined;
+        bool after_constant = terms.size() > 1 && is_constant(terms.back(), before);
+
+        if (lhs_constant && rhs_constant && evaluate(lhs, c, rhs, result))
+        {
+            bool as_bool = is_relational(c) || ((c == '&' || c == '|') && is_bool(terms[0]) && is_bool(term_copy));
+            terms[0] = create_constant(result, as_bool);
+        }
+        else if (rhs_constant && is_right_identity(c, rhs))
+        {
+            // x + 0 is x
+        }
+        else if (rhs_constant && after_constant && combine(get_infix_op_op(terms[terms.size() - 2])[0], before, c, rhs, combined, result))
+        {
+            // x + 1 + 2 is x + 3
+            terms.resize(terms.size() - 2);
+            if (!is_right_identity(combined, result))
+            {
+                terms.push_back(create_infix_op(string(1, combined)));
+                terms.push_back(create_constant(result, false));
+            }
+        }
+        else if (rhs_constant && is_absorbing(c, rhs) && !has_side_effects(terms))
+        {
+            terms = { term_copy };
+        }
+        else if (lhs_constant && is_left_identity(lhs, c))
+        {
+            terms[0] = term_copy;
+        }
+        else if (lhs_constant && is_absorbing(c, lhs) && !ast_has_calls(term_copy))
+        {
+            // 0 * x is 0
+        }
+        else if (lhs_constant && lhs == 0 && c == '-')
+        {
+            terms[0] = create_term(create_unary_op("-", term_copy));
+        }
+        else if (same_var && (c == '&' || c == '|'))
+        {
+            // x & x is x
+        }
+        else if (same_var && is_relational(c))
+        {
+            terms[0] = create_constant(c == '=' ? -1 : 0, true);
+        }
+        else
+        {
+            terms.push_back(op_copy);
+            terms.push_back(term_copy);
+        }
     }
 
-    if (!copied)
+    // ((x)) is (x)
+    if (terms.size() == 1 && ast_node_kind(get_term_term(terms[0])) == ast_expr)
+        return get_term_term(terms[0]);
+
+    // every operation that was folded removed an op and a term
+    if (!copied && (int)terms.size() == size)
         return t;
 
     return create_expr(get_ann(t), terms);
@@ -574,51 +478,14 @@ ast copy_expr(ast t)
 //        int, string, bool, null, this, expr, unary op,
 //        variable, array index, call as function or call as method
 //
-ast copy_term(ast t)
+ast optimiser::copy_term(ast t)
 {
     ast term = get_term_term(t);
-    ast copy;
+    ast copy = copy_as<ast_alpha>(term);
 
-    switch (ast_node_kind(term))
-    {
-    case ast_int:
-        copy = copy_int(term);
-        break;
-    case ast_string:
-        copy = copy_string(term);
-        break;
-    case ast_bool:
-        copy = copy_bool(term);
-        break;
-    case ast_null:
-        copy = copy_null(term);
-        break;
-    case ast_this:
-        copy = copy_this(term);
-        break;
-    case ast_expr:
-        copy = copy_expr(term);
-        break;
-    case ast_unary_op:
-        copy = copy_unary_op(term);
-        break;
-    case ast_var:
-        copy = copy_var(term);
-        break;
-    case ast_array_index:
-        copy = copy_array_index(term);
-        break;
-    case ast_call_as_function:
-        copy = copy_call_as_function(term);
-        break;
-    case ast_call_as_method:
-        copy = copy_call_as_method(term);
-        break;
-    default:
-        fatal_error(0, "Unexpected term kind\n");
-        copy = nullptr;
-        break;
-    }
+    // (x) is x
+    if (ast_node_kind(copy) == ast_expr && size_of_expr(copy) == 1)
+        return get_expr(copy, 0);
 
     if (copy == term)
         return t;
@@ -626,225 +493,51 @@ ast copy_term(ast t)
     return create_term(get_ann(t), copy);
 }
 
-// copy an ast int node with a single field
-// constant - an integer in the range -32,768 to 32,767
-//
-ast copy_int(ast t)
-{
-    int _constant = get_int_constant(t);
-
-    if ( pass_unary )
-    {
-        if ( global_uop == "-" )
-        {
-            return create_int(_constant) ;
-        }
-        else if ( global_uop == "~" )
-        {
-            return create_int(~_constant) ;
-        }
-    }
-
-    return create_int(get_ann(t), _constant);
-}
-
-// copy an ast string node with a single field
-// constant - a string
-//
-ast copy_string(ast t)
-{
-    string _constant = get_string_constant(t);
-
-    return create_string(get_ann(t), _constant);
-}
-
-// copy an ast bool node with a single field
-// constant - either true or false
-//
-ast copy_bool(ast t)
-{
-    bool _constant = get_bool_t_or_f(t);
-
-    return create_bool(get_ann(t), _constant);
-}
-
-// copy an ast null node, it has not fields
-// nothing to do ...
-//
-ast copy_null(ast t)
-{
-    return create_null(get_ann(t));
-    ;
-}
-
-// copy an ast this node, it has not fields
-// nothing to do ...
-//
-ast copy_this(ast t)
-{
-    return create_this(get_ann(t));
-}
-
 // copy an ast unary op node with fields
 // op   - a string, either "-" or "~"
 // term - an ast term node
 //        int, string, bool, null, this, expr, unary op,
 //        variable, array index, call as function or call as method
+// -c and ~c are folded if c is a constant, --x and ~~x are x
 //
-ast copy_unary_op(ast t)
+ast optimiser::copy_unary_op(ast t)
 {
     string uop = get_unary_op_op(t);
     ast term = get_unary_op_term(t);
 
-    //copy the string and make flag pass unary true
-    global_uop = uop ;
-    pass_unary = true;
-
-    ast copy = copy_term(term) ;
-
-    if ( uop == "-" )
-    {
-        return get_term_term(copy) ;
-    }
-    else if ( uop == "~" )
-    {
-        return get_term_term(copy) ;
-    }
-
-    return create_unary_op(get_ann(t), uop, copy);
-}
-
-// copy an ast variable node with fields
-// name - a string
-// type - a string - "int", "char", "boolean" or a class name
-// segment - a string
-// offset - an int
-//
-ast copy_var(ast t)
-{
-    //string name = get_var_name(t) ;
-    //string type = get_var_type(t) ;
-    //string segment = get_var_segment(t) ;
-    //int offset = get_var_offset(t) ;
-
-    return t;
-}
-
-// copy an ast array index node with fields
-// var   - an ast variable node
-// index - an ast expr node
-//
-ast copy_array_index(ast t)
-{
-
-    ast var = get_array_index_var(t);
-    ast index = get_array_index_index(t);
-
-    ast var_copy = copy_var(var);
-    ast index_copy = copy_expr(index);
+    ast copy = copy_term(term);
 
-    if (var_copy == var && index_copy == index)
-        return t;
-
-    return create_array_index(get_ann(t), var_copy, index_copy);
-}
-
-// copy an ast subr call as method with fields
-// class name - a string
-// call       - an ast subr call node
-//
-ast copy_call_as_function(ast t)
-{
-    string class_name = get_call_as_function_class_name(t);
-    ast subr_call = get_call_as_function_subr_call(t);
-
-    ast subr_call_copy = copy_subr_call(subr_call);
-
-    if (subr_call_copy == subr_call)
-        return t;
-
-    return create_call_as_function(get_ann(t), class_name, subr_call_copy);
-}
-
-// copy an ast subr call as method with fields
-// class name - a string
-// var        - an ast variable or ast this node, hidden first parameter of the call
-// call       - an ast subr call node
-//
-ast copy_call_as_method(ast t)
-{
-    string class_name = get_call_as_method_class_name(t);
-    ast var = get_call_as_method_var(t);
-    ast subr_call = get_call_as_method_subr_call(t);
-
-    ast var_copy = ast_node_kind(var) == ast_var ? copy_var(var) : copy_this(var);
-    ast subr_call_copy = copy_subr_call(subr_call);
+    int value;
+    if (is_constant(copy, value))
+        return get_term_term(create_constant(uop == "-" ? -value : ~value, uop == "~" && is_bool(copy)));
 
-    if (var_copy == var && subr_call_copy == subr_call)
-        return t;
-
-    return create_call_as_method(get_ann(t), class_name, var_copy, subr_call_copy);
-}
+    ast inner = get_term_term(copy);
+    if (ast_node_kind(inner) == ast_unary_op && get_unary_op_op(inner) == uop)
+        return get_term_term(get_unary_op_term(inner));
 
-// copy an ast subr call node with fields
-// name      - a string
-// expr list - a vector of ast expr nodes
-//
-ast copy_subr_call(ast t)
-{
-    string subr_name = get_subr_call_subr_name(t);
-    ast expr_list = get_subr_call_expr_list(t);
-
-    ast copy = copy_expr_list(expr_list);
-
-    if (copy == expr_list)
+    if (copy == term)
         return t;
 
-    return create_subr_call(get_ann(t), subr_name, copy);
+    return create_unary_op(get_ann(t), uop, copy);
 }
 
-// copy an ast expr list node
-// it is an ast vector of ast expr nodes
-//
-ast copy_expr_list(ast t)
-{
-    vector<ast> exprs;
-
-    bool copied = false;
-    int size = size_of_expr_list(t);
-    for (int i = 0; i < size; i++)
-    {
-        ast expri = get_expr_list(t, i);
-        ast copy = copy_expr(expri);
-        if (expri != copy)
-            copied = true;
+} // namespace
 
-        exprs.push_back(copy);
-    }
-
-    if (!copied)
-        return t;
-
-    return create_expr_list(get_ann(t), exprs);
-}
-
-// copy an ast infix op node with a single field
-// op - a string - one of "+", "-", "*", "/", "&", "|", "<", ">", "="
-//
-ast copy_infix_op(ast t)
+// return an optimised copy of an ast of a Jack class
+ast Jack_Compiler::jack_optimiser(ast t)
 {
-    string op = get_infix_op_op(t);
-
-    return create_infix_op(get_ann(t), op);
+    return optimiser().copy_class(t);
 }
 
-// main program
+// main program - omitted when the pass is linked into jackc
+#ifndef JACKC
 int main(int argc, char **argv)
 {
     // walk an AST in XML and print VM code
-    ast_print_as_xml(copy_class(ast_parse_xml()), 2);
+    ast_print_as_xml_with_stats(optimiser().copy_class(ast_parse_xml_with_stats()), 2);
 
     // flush the output and any errors
     print_output();
     print_errors();
 }
+#endif
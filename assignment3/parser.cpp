@@ -5,6 +5,8 @@
 #include "iobuffer.h"
 #include "symbols.h"
 #include "abstract-syntax-tree.h"
+#include "jackc.h"
+#include "ast-stats.h"
 
 // to shorten our code:
 using namespace std;
@@ -12,6 +14,10 @@ using namespace CS_IO_Buffers;
 using namespace CS_Symbol_Tables;
 using namespace Jack_Compiler;
 
+// the parser is private to this file, jackc calls it through the entry point declared in jackc.h
+namespace
+{
+
 // ***** WHAT TO DO *****
 //
 // MODIFY the skeleton code below to parse a Jack class and construct the equivalent abstract syntax tree, ast.
@@ -1109,7 +1115,10 @@ Token parse_unary_op()
     return unary_op;
 }
 
-ast jack_parser()
+} // namespace
+
+// parse a Jack class from standard input and return its ast
+ast Jack_Compiler::jack_parser()
 {
     // read the first token to get the tokeniser initialised
     next_token();
@@ -1118,13 +1127,15 @@ ast jack_parser()
     return parse_class();
 }
 
-// main program
+// main program - omitted when the parser is linked into jackc
+#ifndef JACKC
 int main(int argc, char **argv)
 {
     // parse a Jack class and print the abstract syntax tree as XML
-    ast_print_as_xml(jack_parser(), 2);
+    ast_print_as_xml_with_stats(jack_parser(), 2);
 
     // flush the output and any errors
     print_output();
     print_errors();
 }
+#endif
@@ -4,6 +4,10 @@
 #include "symbols.h"
 #include <algorithm>
 #include "abstract-syntax-tree.h"
+#include "jackc.h"
+#include "ast-stats.h"
+#include "ast-lazy-xml.h"
+#include "ast-visitor.h"
 #include <vector>
 
 // to shorten our code:
@@ -11,6 +15,10 @@ using namespace std;
 using namespace CS_IO_Buffers;
 using namespace Jack_Compiler;
 
+// the pass is private to this file, jackc calls it through the entry point declared in jackc.h
+namespace
+{
+
 // ***** WHAT TO DO *****
 //
 // MODIFY the skeleton code below to walk an abstract syntax tree, ast, of a Jack class
@@ -27,43 +35,46 @@ using namespace Jack_Compiler;
 //  - you may want to change the parameters / results to suit your own logic
 //  - you can change it as much as you like
 
-// forward declarations of one function per node in the abstract syntax tree
-void walk_class(ast t);
-void walk_class_var_decs(ast t);
-void walk_var_dec(ast t);
-void walk_subr_decs(ast t);
-void walk_subr(ast t);
-void walk_constructor(ast t);
-void walk_function(ast t);
-void walk_method(ast t);
-void walk_param_list(ast t);
-void walk_subr_body(ast t);
-void walk_var_decs(ast t);
-void walk_statements(ast t);
-void walk_statement(ast t);
-void walk_let(ast t);
-void walk_let_array(ast t);
-void walk_if(ast t);
-void walk_if_else(ast t);
-void walk_while(ast t);
-void walk_do(ast t);
-void walk_return(ast t);
-void walk_return_expr(ast t);
-void walk_expr(ast t);
-void walk_term(ast t);
-void walk_int(ast t);
-void walk_string(ast t);
-void walk_bool(ast t);
-void walk_null(ast t);
-void walk_this(ast t);
-void walk_unary_op(ast t);
-void walk_var(ast t);
-void walk_array_index(ast t);
-void walk_call_as_function(ast t);
-void walk_call_as_method(ast t);
-void walk_subr_call(ast t);
-void walk_expr_list(ast t);
-void walk_infix_op(ast t);
+// the pretty printer is an ast_walker, see ast-visitor.h, with one walk_*() function per node that is printed
+// the sub-trees of the other nodes, a subr node and an expr node, are walked by ast_walker's walk_*() functions
+class pretty : public ast_walker<pretty>
+{
+public:
+    void walk_class(ast t);
+    void walk_class_var_decs(ast t);
+    void walk_var_dec(ast t);
+    void walk_subr_decs(ast t);
+    void walk_constructor(ast t);
+    void walk_function(ast t);
+    void walk_method(ast t);
+    void walk_param_list(ast t);
+    void walk_subr_body(ast t);
+    void walk_var_decs(ast t);
+    void walk_statements(ast t);
+    void walk_statement(ast t);
+    void walk_let(ast t);
+    void walk_let_array(ast t);
+    void walk_if(ast t);
+    void walk_if_else(ast t);
+    void walk_while(ast t);
+    void walk_do(ast t);
+    void walk_return(ast t);
+    void walk_return_expr(ast t);
+    void walk_term(ast t);
+    void walk_int(ast t);
+    void walk_string(ast t);
+    void walk_bool(ast t);
+    void walk_null(ast t);
+    void walk_this(ast t);
+    void walk_unary_op(ast t);
+    void walk_var(ast t);
+    void walk_array_index(ast t);
+    void walk_call_as_function(ast t);
+    void walk_call_as_method(ast t);
+    void walk_subr_call(ast t);
+    void walk_expr_list(ast t);
+    void walk_infix_op(ast t);
+};
 
 int indentation_count = 0;
 char flag_for_statement = 'n';
@@ -137,7 +148,7 @@ void print_declarations(string segment, vector<ast> collections)
 // var_decs   - ast vector of variable declarations
 // subr_decs  - ast vector of subroutine declarations
 //
-void walk_class(ast t)
+void pretty::walk_class(ast t)
 {
     string myclassname = get_class_class_name(t);
     ast var_decs = get_class_var_decs(t);
@@ -155,7 +166,7 @@ void walk_class(ast t)
 // walk an ast class var decs node
 // it is an ast vector of variable declarations
 //
-void walk_class_var_decs(ast t)
+void pretty::walk_class_var_decs(ast t)
 {
     int ndecs = size_of_class_var_decs(t);
     indentation_count++;
@@ -210,7 +221,7 @@ void walk_class_var_decs(ast t)
 // offset - an int
 // this is used for statics, fields, parameters and local variables
 //
-void walk_var_dec(ast t)
+void pretty::walk_var_dec(ast t)
 {
     string name = get_var_dec_name(t);
     string type = get_var_dec_type(t);
@@ -247,7 +258,7 @@ void walk_var_dec(ast t)
 // walk an ast class var decs node
 // it is an ast vector of subroutine declarations
 //
-void walk_subr_decs(ast t)
+void pretty::walk_subr_decs(ast t)
 {
     int size = size_of_subr_decs(t);
     for (int i = 0; i < size; i++)
@@ -260,37 +271,13 @@ void walk_subr_decs(ast t)
     }
 }
 
-// walk an ast subroutine node with a single field
-// subr - an ast constructor, ast function or ast method node
-//
-void walk_subr(ast t)
-{
-    ast subr = get_subr_subr(t);
-
-    switch (ast_node_kind(subr))
-    {
-    case ast_constructor:
-        walk_constructor(subr);
-        break;
-    case ast_function:
-        walk_function(subr);
-        break;
-    case ast_method:
-        walk_method(subr);
-        break;
-    default:
-        fatal_error(0, "Unexpected subroutine kind");
-        break;
-    }
-}
-
 // walk an ast constructor node with fields
 // vtype - a string - the name of the class
 // name - a string
 // param list - an ast vector of variable declarations
 // subr body - an ast subr body node
 //
-void walk_constructor(ast t)
+void pretty::walk_constructor(ast t)
 {
     string vtype = get_constructor_vtype(t);
     string name = get_constructor_name(t);
@@ -312,7 +299,7 @@ void walk_constructor(ast t)
 // param list - an ast vector of variable declarations
 // subr body - an ast subr body node
 //
-void walk_function(ast t)
+void pretty::walk_function(ast t)
 {
     string vtype = get_function_vtype(t);
     string name = get_function_name(t);
@@ -335,7 +322,7 @@ void walk_function(ast t)
 // param list - an ast vector of variable declarations
 // subr body - an ast subr body node
 //
-void walk_method(ast t)
+void pretty::walk_method(ast t)
 {
     string vtype = get_method_vtype(t);
     string name = get_method_name(t);
@@ -353,7 +340,7 @@ void walk_method(ast t)
 // walk an ast param list node
 // it is an ast vector of variable declarations
 //
-void walk_param_list(ast t)
+void pretty::walk_param_list(ast t)
 {
     int ndecs = size_of_param_list(t);
     for (int i = 0; i < ndecs; i++)
@@ -370,7 +357,7 @@ void walk_param_list(ast t)
 // decs - an ast vector of variable declarations
 // body - an ast vector of statement nodes
 //
-void walk_subr_body(ast t)
+void pretty::walk_subr_body(ast t)
 {
     ast decs = get_subr_body_decs(t);
     ast body = get_subr_body_body(t);
@@ -392,7 +379,7 @@ void walk_subr_body(ast t)
 // walk an ast param list node
 // it is an ast vector of variable declarations
 //
-void walk_var_decs(ast t)
+void pretty::walk_var_decs(ast t)
 {
     int ndecs = size_of_var_decs(t);
     for (int i = 0; i < ndecs; i++)
@@ -413,7 +400,7 @@ void walk_var_decs(ast t)
 // walk an ast statements node
 // it is an ast vector of statement nodes
 //
-void walk_statements(ast t)
+void pretty::walk_statements(ast t)
 {
     int nstatements = size_of_statements(t);
     for (int i = 0; i < nstatements; i++)
@@ -429,50 +416,20 @@ void walk_statements(ast t)
 // walk an ast statement node with a single field
 // statement - one of the following ast nodes, let, let array, if, if else, while, do, return, return expr or statements
 //
-void walk_statement(ast t)
+void pretty::walk_statement(ast t)
 {
-    ast statement = get_statement_statement(t);
+    walk_fields<ast_statement>(t);
 
-    switch (ast_node_kind(statement))
+    // a blank line is written between a compound statement and the next statement
+    switch (ast_node_kind(get_statement_statement(t)))
     {
-    case ast_let:
-        walk_let(statement);
-        flag_for_statement = 'n';
-        break;
-    case ast_let_array:
-        walk_let_array(statement);
-        flag_for_statement = 'n';
-        break;
     case ast_if:
-        walk_if(statement);
-        flag_for_statement = 'y';
-        break;
     case ast_if_else:
-        walk_if_else(statement);
-        flag_for_statement = 'y';
-        break;
     case ast_while:
-        walk_while(statement);
         flag_for_statement = 'y';
         break;
-    case ast_do:
-        walk_do(statement);
-        flag_for_statement = 'n';
-        break;
-    case ast_return:
-        walk_return(statement);
-        flag_for_statement = 'n';
-        break;
-    case ast_return_expr:
-        walk_return_expr(statement);
-        flag_for_statement = 'n';
-        break;
-    case ast_statements:
-        walk_statements(statement);
-        flag_for_statement = 'n';
-        break;
     default:
-        fatal_error(0, "Unexpected statement kind");
+        flag_for_statement = 'n';
         break;
     }
 }
@@ -481,7 +438,7 @@ void walk_statement(ast t)
 // var  - an ast variable
 // expr - an ast expr node
 //
-void walk_let(ast t)
+void pretty::walk_let(ast t)
 {
     ast var = get_let_var(t);
     ast expr = get_let_expr(t);
@@ -501,7 +458,7 @@ void walk_let(ast t)
 // index  - an ast expr node
 // expr   - an ast expr node
 //
-void walk_let_array(ast t)
+void pretty::walk_let_array(ast t)
 {
     ast var = get_let_array_var(t);
     ast index = get_let_array_index(t);
@@ -528,7 +485,7 @@ void walk_let_array(ast t)
 //
 //}
 
-void walk_if(ast t)
+void pretty::walk_if(ast t)
 {
     ast condition = get_if_condition(t);
     ast if_true = get_if_if_true(t);
@@ -562,7 +519,7 @@ void walk_if(ast t)
 //{
 //
 //}
-void walk_if_else(ast t)
+void pretty::walk_if_else(ast t)
 {
     ast condition = get_if_else_condition(t);
     ast if_true = get_if_else_if_true(t);
@@ -601,7 +558,7 @@ void walk_if_else(ast t)
 // condition - an ast expr node
 // body      - an ast statements node
 //
-void walk_while(ast t)
+void pretty::walk_while(ast t)
 {
     ast condition = get_while_condition(t);
     ast body = get_while_body(t);
@@ -632,31 +589,17 @@ void walk_while(ast t)
 // walk an ast do node with a single field
 // call - an ast call as function node or an ast call as method node
 //
-void walk_do(ast t)
+void pretty::walk_do(ast t)
 {
-    ast call = get_do_call(t);
     indentation();
     write_to_output("do ");
-
-    switch (ast_node_kind(call))
-    {
-    case ast_call_as_function:
-        walk_call_as_function(call);
-        write_to_output(" ;\n");
-        break;
-    case ast_call_as_method:
-        walk_call_as_method(call);
-        write_to_output(" ;\n");
-        break;
-    default:
-        fatal_error(0, "Unexpected call kind");
-        break;
-    }
+    walk_fields<ast_do>(t);
+    write_to_output(" ;\n");
 }
 
 // walk an ast return node, it has not fields
 //
-void walk_return(ast t)
+void pretty::walk_return(ast t)
 {
     indentation();
     write_to_output("return ;\n");
@@ -665,7 +608,7 @@ void walk_return(ast t)
 // walk an ast return expr node with a single field
 // expr - an ast expr node
 //
-void walk_return_expr(ast t)
+void pretty::walk_return_expr(ast t)
 {
     ast expr = get_return_expr(t);
 
@@ -676,85 +619,31 @@ void walk_return_expr(ast t)
     write_to_output(" ;\n");
 }
 
-// walk an ast param list node
-// it is an ast vector of ast term and infix op nodes
-// it must be of odd length > 0, ie 1, 3, 5, 7, ...
-// all elements at even indices are an ast term node
-// all elements at odd indices are an ast infix op
-//
-void walk_expr(ast t)
-{
-    int term_ops = size_of_expr(t);
-    for (int i = 0; i < term_ops; i++)
-    {
-        ast term_op = get_expr(t, i);
-        if (i % 2 == 0)
-        {
-            walk_term(term_op);
-        }
-        else
-        {
-            walk_infix_op(term_op);
-        }
-    }
-}
-
 // walk an ast term node with a single field
 // term - one of the following ast nodes:
 //        int, string, bool, null, this, expr, unary op,
 //        variable, array index, call as function or call as method
 //
-void walk_term(ast t)
+void pretty::walk_term(ast t)
 {
     ast term = get_term_term(t);
 
-    switch (ast_node_kind(term))
+    if (ast_node_kind(term) == ast_expr)
     {
-    case ast_int:
-        walk_int(term);
-        break;
-    case ast_string:
-        walk_string(term);
-        break;
-    case ast_bool:
-        walk_bool(term);
-        break;
-    case ast_null:
-        walk_null(term);
-        break;
-    case ast_this:
-        walk_this(term);
-        break;
-    case ast_expr:
         write_to_output("(");
         walk_expr(term);
         write_to_output(")");
-        break;
-    case ast_unary_op:
-        walk_unary_op(term);
-        break;
-    case ast_var:
-        walk_var(term);
-        break;
-    case ast_array_index:
-        walk_array_index(term);
-        break;
-    case ast_call_as_function:
-        walk_call_as_function(term);
-        break;
-    case ast_call_as_method:
-        walk_call_as_method(term);
-        break;
-    default:
-        fatal_error(0, "Unexpected term kind");
-        break;
+    }
+    else
+    {
+        walk_fields<ast_term>(t);
     }
 }
 
 // walk an ast int node with a single field
 // constant - an integer in the range -32,768 to 32,767
 //
-void walk_int(ast t)
+void pretty::walk_int(ast t)
 {
     int _constant = get_int_constant(t);
     string constant = to_string(_constant);
@@ -764,7 +653,7 @@ void walk_int(ast t)
 // walk an ast string node with a single field
 // constant - a string
 //
-void walk_string(ast t)
+void pretty::walk_string(ast t)
 {
     string _constant = get_string_constant(t);
     write_to_output('"' + _constant + '"');
@@ -773,7 +662,7 @@ void walk_string(ast t)
 // walk an ast bool node with a single field
 // constant - either true or false
 //
-void walk_bool(ast t)
+void pretty::walk_bool(ast t)
 {
     bool _constant = get_bool_t_or_f(t);
 
@@ -789,14 +678,14 @@ void walk_bool(ast t)
 
 // walk an ast null node, it has not fields
 //
-void walk_null(ast t)
+void pretty::walk_null(ast t)
 {
     write_to_output("null");
 }
 
 // walk an ast this node, it has not fields
 //
-void walk_this(ast t)
+void pretty::walk_this(ast t)
 {
     write_to_output("this");
 }
@@ -807,7 +696,7 @@ void walk_this(ast t)
 //        int, string, bool, null, this, expr, unary op,
 //        variable, array index, call as function or call as method
 //
-void walk_unary_op(ast t)
+void pretty::walk_unary_op(ast t)
 {
     string uop = get_unary_op_op(t);
     ast term = get_unary_op_term(t);
@@ -823,7 +712,7 @@ void walk_unary_op(ast t)
 // segment - a string
 // offset - an int
 //
-void walk_var(ast t)
+void pretty::walk_var(ast t)
 {
     string name = get_var_name(t);
     string type = get_var_type(t);
@@ -837,7 +726,7 @@ void walk_var(ast t)
 // var   - an ast variable node
 // index - an ast expr node
 //
-void walk_array_index(ast t)
+void pretty::walk_array_index(ast t)
 {
     ast var = get_array_index_var(t);
     ast index = get_array_index_index(t);
@@ -852,7 +741,7 @@ void walk_array_index(ast t)
 // class name - a string
 // call       - an ast subr call node
 //
-void walk_call_as_function(ast t)
+void pretty::walk_call_as_function(ast t)
 {
     string class_name = get_call_as_function_class_name(t);
     ast subr_call = get_call_as_function_subr_call(t);
@@ -867,7 +756,7 @@ void walk_call_as_function(ast t)
 // var        - an ast variable or ast this node, hidden first parameter of the call
 // call       - an ast subr call node
 //
-void walk_call_as_method(ast t)
+void pretty::walk_call_as_method(ast t)
 {
     string class_name = get_call_as_method_class_name(t);
     ast var = get_call_as_method_var(t);
@@ -894,7 +783,7 @@ void walk_call_as_method(ast t)
 // name      - a string
 // expr list - a vector of ast expr nodes
 //
-void walk_subr_call(ast t)
+void pretty::walk_subr_call(ast t)
 {
     string subr_name = get_subr_call_subr_name(t);
     ast expr_list = get_subr_call_expr_list(t);
@@ -909,7 +798,7 @@ void walk_subr_call(ast t)
 // walk an ast expr list node
 // it is an ast vector of ast expr nodes
 //
-void walk_expr_list(ast t)
+void pretty::walk_expr_list(ast t)
 {
     int nexpressions = size_of_expr_list(t);
     for (int i = 0; i < nexpressions; i++)
@@ -925,19 +814,45 @@ void walk_expr_list(ast t)
 // walk an ast infix op node with a single field
 // op - a string - one of "+", "-", "*", "/", "&", "|", "<", ">", "="
 //
-void walk_infix_op(ast t)
+void pretty::walk_infix_op(ast t)
 {
     string op = get_infix_op_op(t);
     write_to_output(" " + op + " ");
 }
 
-// main program
+} // namespace
+
+// walk an ast of a Jack class and write the pretty printed Jack code to the output
+void Jack_Compiler::jack_pretty(ast t)
+{
+    pretty().walk_class(t);
+}
+
+// main program - omitted when the pass is linked into jackc
+#ifndef JACKC
 int main(int argc, char **argv)
 {
-    // walk an AST parsed from XML and pretty print equivalent Jack code
-    walk_class(ast_parse_xml());
+    if (argc > 1)
+    {
+        // only create the AST nodes for the named subroutine and pretty print it
+        ast_lazy_class lazy(ast_read_xml_text());
+        int i = lazy.find_subr(argv[1]);
+        if (i < 0)
+        {
+            fatal_error(0, "Cannot find subroutine " + string(argv[1]));
+        }
+
+        indentation_count = 1;
+        pretty().walk_subr(lazy.get_subr_decs(i));
+    }
+    else
+    {
+        // walk an AST parsed from XML and pretty print equivalent Jack code
+        pretty().walk_class(ast_parse_xml_with_stats());
+    }
 
     // flush the output and any errors
     print_output();
     print_errors();
 }
+#endif
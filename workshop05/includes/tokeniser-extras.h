@@ -70,7 +70,7 @@ namespace Workshop_Tokeniser
 
     // ***** the following are implemented in the tokeniser-extras.cpp file *****
 
-    // work out the kind of a parsed token, this calls keyword_or_identifier() if a token looks like an identifier
+    // work out the kind of a parsed token, a token that looks like an identifier is looked up in the keyword table
     extern TokenKind classify_spelling(string spelling) ;
 
     // work out the correct spelling to use in the Token object being created by new_token()
@@ -1,6 +1,7 @@
 // convert Text into Tokens wrapped up in XML
 #include "iobuffer.h"
 #include "tokeniser-extras.h"
+#include "keywords.h"
 #include <unordered_map>
 #include <iostream>
 #include <vector>
@@ -144,7 +145,7 @@ namespace Workshop_Tokeniser
         }
     }
 
-    // work out the kind of a parsed token, this may call keyword_or_identifier()
+    // work out the kind of a parsed token, words are looked up in the keyword table
     // the spelling is a valid token
     TokenKind classify_spelling(string spelling)
     {
@@ -158,9 +159,9 @@ namespace Workshop_Tokeniser
             case '\n':
                 return tk_newline;
             case 'A' ... 'Z':
-                return keyword_or_identifier(spelling);
             case 'a' ... 'z':
-                return keyword_or_identifier(spelling);
+                // a single probe of the keyword table
+                return keywords.find(spelling.data(),spelling.size(),tk_identifier);
             case '0' ... '9':
                 return tk_integer;
             case ' ':